@@ -46,6 +46,8 @@ void print_help()
     printf("\t\tGenerating identity, pubkey key from private key. Private key must be passed either from params or configuration file.\n");
     printf("\t-getbalance <IDENTITY>\n");
     printf("\t\tBalance of an identity (amount of qubic, number of in/out txs)\n");
+    printf("\t-getbalances <IDENTITY_LIST_FILE>\n");
+    printf("\t\tBalances of many identities (one per line in <IDENTITY_LIST_FILE>). Requests are pipelined over one connection.\n");
     printf("\t-getasset <IDENTITY>\n");
     printf("\t\tPrint a list of assets of an identity\n");
     printf("\t-queryassets <QUERY_TYPE> <QUERY_STING>\n");
@@ -81,30 +83,49 @@ void print_help()
     printf("\n[BLOCKCHAIN/PROTOCOL COMMANDS]\n");
     printf("\t-gettickdata <TICK_NUMBER> <OUTPUT_FILE_NAME>\n");
     printf("\t\tGet tick data and write it to a file. Use -readtickdata to examine the file. valid node ip/port are required.\n");
+    printf("\t-gettickrange <START_TICK> <END_TICK> <TICK_ARCHIVE_FILE> [NUMBER_OF_CONNECTIONS]\n");
+    printf("\t\tDownload all ticks from START_TICK to END_TICK into one compressed, indexed archive file, over NUMBER_OF_CONNECTIONS (default 4) pipelined connections. Ticks already in the archive are skipped, so an interrupted download is resumed by running the command again. valid node ip/port are required.\n");
+    printf("\t-extracttick <TICK_ARCHIVE_FILE> <TICK_NUMBER> <OUTPUT_FILE_NAME>\n");
+    printf("\t\tWrite one tick of an archive written by -gettickrange to a file in the format of -gettickdata.\n");
+    printf("\t-followticks <OUTPUT_FILE> [FORMAT] [START_TICK]\n");
+    printf("\t\tFollow the chain from START_TICK (default: the current tick) until stopped. Every tick is fetched with its transactions as soon as the node has moved past it, verified against the computor list of its epoch (marked unverified while the list is not available) and appended to OUTPUT_FILE (- for stdout, messages then go to stderr). FORMAT is ndjson (default, one JSON object per tick) or binary (tick, flags and size followed by the tick in the format of -gettickdata). Failed requests are retried with the same tick, so node disconnects leave no gaps. valid node ip/port are required.\n");
     printf("\t-getquorumtick <COMP_LIST_FILE> <TICK_NUMBER>\n");
-    printf("\t\tGet quorum tick data, the summary of quorum tick will be printed, <COMP_LIST_FILE> is fetched by command -getcomputorlist. valid node ip/port are required.\n");
+    printf("\t\tGet quorum tick data, the summary of quorum tick will be printed, <COMP_LIST_FILE> is fetched by command -getcomputorlist, or - for the cached computor list of the epoch (see -getcomputorlist). valid node ip/port are required.\n");
+    printf("\t-getquorumrange <COMP_LIST_FILE> <START_TICK> <END_TICK> [NUMBER_OF_CONNECTIONS]\n");
+    printf("\t\tAnalyze the quorum of all ticks from START_TICK to END_TICK: the votes are fetched over NUMBER_OF_CONNECTIONS (default 4) pipelined connections, checked like -getquorumtick does (each tick once, its votes are also the next votes of the tick before) and grouped. The ticks without quorum or with disagreeing votes are printed, followed by the participation and disagreement rates of every computor. <COMP_LIST_FILE> is fetched by command -getcomputorlist, or - for the cached computor list of the epoch. valid node ip/port are required.\n");
     printf("\t-getcomputorlist <OUTPUT_FILE_NAME>\n");
-    printf("\t\tGet computor list of the current epoch. Feed this data to -readtickdata to verify tick data. valid node ip/port are required.\n");
+    printf("\t\tGet computor list of the current epoch. Feed this data to -readtickdata to verify tick data. A list signed by the arbitrator is also saved to the computor list cache (computor_lists/<EPOCH>.bin in the working directory), which the commands taking a computor list use when it is given as -. They fetch a missing list from the node once per epoch. valid node ip/port are required.\n");
     printf("\t-getnodeiplist\n");
     printf("\t\tPrint a list of node ip from a seed node ip. Valid node ip/port are required.\n");
+    printf("\t-comparenodes <NODE_IP_LIST_FILE|discover> <QUERY> [IDENTITY]\n");
+    printf("\t\tSend the same QUERY to many nodes in parallel and print per-node latency, majority tick/epoch and divergent spectrum digests. NODE_IP_LIST_FILE has one ip per line, discover uses the peers of the seed node. QUERY is tickinfo, systeminfo or balance (requires IDENTITY). Valid node port is required.\n");
     printf("\t-gettxinfo <TX_ID>\n");
     printf("\t\tGet tx infomation, will print empty if there is no tx or invalid tx. valid node ip/port are required.\n");
     printf("\t-uploadfile <FILE_PATH> [COMPRESS_TOOL]\n");
-    printf("\t\tUpload a file to qubic network. valid node ip/port and seed are required. optional COMPRESS_TOOL is used to compress the file (support: zip(Unix), tar(Win, Unix)) \n");
+    printf("\t\tUpload a file to qubic network. valid node ip/port and seed are required. optional COMPRESS_TOOL is used to compress the file (support: qlz (built-in, streamed without temporary files), zip(Unix), tar(Win, Unix)) \n");
     printf("\t-downloadfile <TX_ID> <FILE_PATH> [DECOMPRESS_TOOL]\n");
-    printf("\t\tDownload a file to qubic network. valid node ip/port are required. optional DECOMPRESS_TOOL is used to decompress the file (support: zip(Unix), tar(Win, Unix)) \n");
+    printf("\t\tDownload a file to qubic network. valid node ip/port are required. optional DECOMPRESS_TOOL is used to decompress the file (support: zip(Unix), tar(Win, Unix)). Files uploaded with qlz are decompressed automatically.\n");
     printf("\t-checktxontick <TICK_NUMBER> <TX_ID>\n");
     printf("\t\tCheck if a transaction is included in a tick. valid node ip/port are required.\n");
     printf("\t-checktxonfile <TX_ID> <TICK_DATA_FILE>\n");
     printf("\t\tCheck if a transaction is included in a tick (tick data from a file). valid node ip/port are required.\n");
+    printf("\t\tTICK_DATA_FILE can also be an archive written by -gettickrange, the transaction is then looked up in its transaction index (<TICK_DATA_FILE>.txi).\n");
     printf("\t-readtickdata <FILE_NAME> <COMPUTOR_LIST>\n");
-    printf("\t\tRead tick data from a file, print the output on screen, COMPUTOR_LIST is required if you need to verify block data\n");
+    printf("\t\tRead tick data from a file, print the output on screen, COMPUTOR_LIST is required if you need to verify block data (- for the cached computor list of the epoch of the tick)\n");
+    printf("\t-verifytickfiles <COMPUTOR_LIST> <TICK_FILE_LIST> [NUMBER_OF_THREADS]\n");
+    printf("\t\tVerify tick data signature, completeness and transaction signatures of many tick data files (written by -gettickdata) in parallel and print a verdict per tick. COMPUTOR_LIST is a file or - for the cached computor list of the epoch of the first tick. TICK_FILE_LIST has one file name per line. NUMBER_OF_THREADS defaults to one per core.\n");
     printf("\t-sendcustomtransaction <TARGET_IDENTITY> <TX_TYPE> <AMOUNT> <EXTRA_BYTE_SIZE> <EXTRA_BYTE_IN_HEX>\n");
     printf("\t\tPerform a custom transaction (IPO, querying smart contract), valid private key and node ip/port are required.\n");
     printf("\t-dumpspectrumfile <SPECTRUM_BINARY_FILE> <OUTPUT_CSV_FILE>\n");
     printf("\t\tDump spectrum file into csv.\n");
     printf("\t-dumpuniversefile <UNIVERSE_BINARY_FILE> <OUTPUT_CSV_FILE>\n");
     printf("\t\tDump universe file into csv.\n");
+    printf("\t-spectrumdigest <SPECTRUM_BINARY_FILE> [TREE_FILE]\n");
+    printf("\t\tCompute the spectrum digest of a spectrum file with a parallel Merkle tree build, to compare a local snapshot with the digest reported by -getbalance. Optionally save the whole tree to TREE_FILE for -merkleproof.\n");
+    printf("\t-universedigest <UNIVERSE_BINARY_FILE> [TREE_FILE]\n");
+    printf("\t\tCompute the universe digest of a universe file like -spectrumdigest.\n");
+    printf("\t-merkleproof <TREE_FILE> <INDEX>\n");
+    printf("\t\tPrint the leaf digest, siblings and root of spectrum / universe INDEX from a tree saved by -spectrumdigest or -universedigest, without a node.\n");
     printf("\t-dumpcontractfile <CONTRACT_BINARY_FILE> <CONTRACT_ID> <OUTPUT_CSV_FILE>\n");
     printf("\t\tDump contract file into csv. Current supported CONTRACT_IDs: 1-QX \n");
     printf("\t-makeipobid <CONTRACT_INDEX> <NUMBER_OF_SHARE> <PRICE_PER_SHARE>\n");
@@ -137,7 +158,7 @@ void print_help()
     printf("\t-getminingscoreranking\n");
     printf("\t\tGet current mining score ranking. Valid private key and node ip/port are required.\t\n");
     printf("\t-getvotecountertx <COMPUTOR_LIST_FILE> <TICK>\n");
-    printf("\t\tGet vote counter transaction of a tick: showing how many votes per ID that this tick leader saw from (<TICK>-675-3) to (<TICK>-3) \t\n");
+    printf("\t\tGet vote counter transaction of a tick: showing how many votes per ID that this tick leader saw from (<TICK>-675-3) to (<TICK>-3). <COMPUTOR_LIST_FILE> can be - for the cached computor list of the epoch of the tick.\n");
     printf("\t-setloggingmode <MODE>\n");
     printf("\t\tSet console logging mode: 0 disabled, 1 low computational cost, 2 full logging. Valid private key and node ip/port are required.\t\n");
     printf("\t-compmessage \"<MESSAGE>\"\n");
@@ -377,6 +398,21 @@ void print_help()
     printf("\t\tGet incoming transfer amounts from either TESTEXB (\"B\") or TESTEXC (\"C\"). Requires the TESTEXB and TESTEXC SCs to be enabled.\n");
     printf("\t-testbidinipothroughcontract <B_OR_C> <CONTRACT_INDEX> <NUMBER_OF_SHARE> <PRICE_PER_SHARE>\n");
     printf("\t\tBid in an IPO either as TESTEXB (\"B\") or as TESTEXC (\"C\"). Requires the TESTEXB and TESTEXC SCs to be enabled.\n");
+
+    printf("\n[BENCHMARK COMMANDS]\n");
+    printf("\t-benchmark <BENCHMARK_NAME> [PARAMETER]\n");
+    printf("\t\tRun a performance benchmark. Pass an unknown name to list all benchmarks and their parameters. Available benchmarks:\n");
+    printf("\t\tbatchverify: compare verifications/s of single signature verification and batch verification (with and without public keys decoded up front) for batch sizes 1 to 1024.\n");
+    printf("\t\tcompression: compare bytes on chain and wall time of the built-in qlz codec against zip and tar.\n");
+    printf("\t\tconnectionmemory: open many connections to the node and report the memory footprint per connection.\n");
+    printf("\t\tidentity: compare identities/s of single and batched public key <-> identity conversion over a full spectrum.\n");
+    printf("\t\tk12batch: check multi-buffer KangarooTwelve against KangarooTwelve() and compare hashes/s for short inputs, identity conversion and Merkle proof verification.\n");
+    printf("\t\tk12tree: check parallel KangarooTwelve tree hashing against KangarooTwelve() and compare GB/s for inputs from 64 KB up to the given size.\n");
+    printf("\t\tmerkleverify: compare proofs/s of single and batched spectrum Merkle proof verification against one spectrum digest.\n");
+    printf("\t\tsign: compare signatures/s of signData() with a seed against a reusable Signer, one at a time and in batches.\n");
+    printf("\t\ttickread: load generated full tick files with the previous quadratic loader and with TickFile and compare ticks/s.\n");
+    printf("\t\ttickverify: verify generated tick files with 1 thread up to one thread per core and report transactions/s and scaling.\n");
+    printf("\t\ttickwait: let many waiters wait for the tick after next through the shared tick watcher and report node requests and wakeup spread.\n");
 }
 
 static long long charToNumber(char* a)
@@ -577,6 +613,15 @@ void parseArgument(int argc, char** argv)
             CHECK_OVER_PARAMETERS
             break;
         }
+        if (strcmp(argv[i], "-getbalances") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_cmd = GET_BALANCES;
+            g_requestedFileName = argv[i+1];
+            i+=2;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
         if (strcmp(argv[i], "-getasset") == 0)
         {
             CHECK_NUMBER_OF_PARAMETERS(1)
@@ -643,6 +688,57 @@ void parseArgument(int argc, char** argv)
             CHECK_OVER_PARAMETERS
             break;
         }
+        if (strcmp(argv[i], "-gettickrange") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(3)
+            g_cmd = GET_TICK_RANGE;
+            g_requestedTickNumber = uint32_t(charToNumber(argv[i+1]));
+            g_requestedEndTickNumber = uint32_t(charToNumber(argv[i+2]));
+            g_requestedFileName = argv[i+3];
+            i+=4;
+            if (i < argc)
+            {
+                g_numberOfThreads = int(charToNumber(argv[i]));
+                i++;
+            }
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+        if (strcmp(argv[i], "-extracttick") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(3)
+            g_cmd = EXTRACT_TICK_FROM_ARCHIVE;
+            g_requestedFileName = argv[i+1];
+            g_requestedTickNumber = uint32_t(charToNumber(argv[i+2]));
+            g_requestedFileName2 = argv[i+3];
+            i+=4;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+        if (strcmp(argv[i], "-followticks") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_cmd = FOLLOW_TICKS;
+            g_requestedFileName = argv[i+1];
+            i+=2;
+            if (i < argc)
+            {
+                g_paramString1 = argv[i];
+                if (strcmp(g_paramString1, "ndjson") != 0 && strcmp(g_paramString1, "binary") != 0)
+                {
+                    LOG("Invalid FORMAT. Must be ndjson or binary.\n");
+                    exit(1);
+                }
+                i++;
+            }
+            if (i < argc)
+            {
+                g_requestedTickNumber = uint32_t(charToNumber(argv[i]));
+                i++;
+            }
+            CHECK_OVER_PARAMETERS
+            break;
+        }
         if (strcmp(argv[i], "-getquorumtick") == 0)
         {
             CHECK_NUMBER_OF_PARAMETERS(2)
@@ -653,6 +749,22 @@ void parseArgument(int argc, char** argv)
             CHECK_OVER_PARAMETERS
             break;
         }
+        if (strcmp(argv[i], "-getquorumrange") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(3)
+            g_cmd = GET_QUORUM_RANGE;
+            g_requestedFileName = argv[i + 1];
+            g_requestedTickNumber = uint32_t(charToNumber(argv[i+2]));
+            g_requestedEndTickNumber = uint32_t(charToNumber(argv[i+3]));
+            i+=4;
+            if (i < argc)
+            {
+                g_numberOfThreads = int(charToNumber(argv[i]));
+                i++;
+            }
+            CHECK_OVER_PARAMETERS
+            break;
+        }
         if (strcmp(argv[i], "-getcomputorlist") == 0)
         {
             CHECK_NUMBER_OF_PARAMETERS(1)
@@ -669,6 +781,21 @@ void parseArgument(int argc, char** argv)
             CHECK_OVER_PARAMETERS
             break;
         }
+        if (strcmp(argv[i], "-comparenodes") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(2)
+            g_cmd = COMPARE_NODES;
+            g_paramString1 = argv[i+1];
+            g_paramString2 = argv[i+2];
+            i+=3;
+            if (i < argc)
+            {
+                g_requestedIdentity = argv[i];
+                i++;
+            }
+            CHECK_OVER_PARAMETERS
+            break;
+        }
         if (strcmp(argv[i], "-gettxinfo") == 0)
         {
             CHECK_NUMBER_OF_PARAMETERS(1)
@@ -737,6 +864,21 @@ void parseArgument(int argc, char** argv)
             CHECK_OVER_PARAMETERS
             break;
         }
+        if (strcmp(argv[i], "-verifytickfiles") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(2)
+            g_cmd = VERIFY_TICK_FILES;
+            g_requestedFileName = argv[i+1];
+            g_requestedFileName2 = argv[i+2];
+            i+=3;
+            if (i < argc)
+            {
+                g_numberOfThreads = int(charToNumber(argv[i]));
+                i++;
+            }
+            CHECK_OVER_PARAMETERS
+            break;
+        }
         if (strcmp(argv[i], "-getvotecountertx") == 0)
         {
             CHECK_NUMBER_OF_PARAMETERS(2)
@@ -780,6 +922,30 @@ void parseArgument(int argc, char** argv)
             CHECK_OVER_PARAMETERS
             break;
         }
+        if (strcmp(argv[i], "-spectrumdigest") == 0 || strcmp(argv[i], "-universedigest") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_cmd = (strcmp(argv[i], "-spectrumdigest") == 0) ? SPECTRUM_DIGEST_OF_FILE : UNIVERSE_DIGEST_OF_FILE;
+            g_dumpBinaryFileInput = argv[i+1];
+            i+=2;
+            if (i < argc)
+            {
+                g_dumpBinaryFileOutput = argv[i];
+                i++;
+            }
+            CHECK_OVER_PARAMETERS
+            break;
+        }
+        if (strcmp(argv[i], "-merkleproof") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(2)
+            g_cmd = MERKLE_PROOF_FROM_FILE;
+            g_dumpBinaryFileInput = argv[i+1];
+            g_merkleLeafIndex = uint64_t(charToNumber(argv[i+2]));
+            i+=3;
+            CHECK_OVER_PARAMETERS
+            break;
+        }
         if (strcmp(argv[i], "-dumpcontractfile") == 0)
         {
             CHECK_NUMBER_OF_PARAMETERS(3)
@@ -2152,6 +2318,25 @@ void parseArgument(int argc, char** argv)
             return;
         }
 
+        /****************************
+         **** BENCHMARK COMMANDS ****
+         ****************************/
+
+        if (strcmp(argv[i], "-benchmark") == 0)
+        {
+            CHECK_NUMBER_OF_PARAMETERS(1)
+            g_cmd = RUN_BENCHMARK;
+            g_paramString1 = argv[i + 1];
+            if (i + 2 < argc)
+            {
+                g_paramString2 = argv[i + 2];
+                i++;
+            }
+            i += 2;
+            CHECK_OVER_PARAMETERS
+            return;
+        }
+
         i++;
     }
     if (g_configFile != nullptr)
@@ -6,15 +6,15 @@
 #include "key_utils.h"
 #include "asset_utils.h"
 #include "connection.h"
+#include "packet_stream.h"
 #include "logger.h"
 #include "node_utils.h"
 #include "k12_and_key_utils.h"
 #include "utils.h"
 #include "sanity_check.h"
 
-std::vector<RespondOwnedAssets> getOwnedAsset(const char * nodeIp, const int nodePort, const char* requestedIdentity)
+static void requestOwnedAssets(QCPtr qc, const char* requestedIdentity)
 {
-    std::vector<RespondOwnedAssets> result;
     uint8_t publicKey[32] = {0};
     getPublicKeyFromIdentity(requestedIdentity, publicKey);
     struct {
@@ -25,15 +25,11 @@ std::vector<RespondOwnedAssets> getOwnedAsset(const char * nodeIp, const int nod
     packet.header.setSize(sizeof(packet));
     packet.header.randomizeDejavu();
     packet.header.setType(REQUEST_OWNED_ASSETS);
-    auto qc = make_qc(nodeIp, nodePort);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-
-    return qc->getLatestVectorPacketAs<RespondOwnedAssets>();
 }
 
-std::vector<RespondPossessedAssets> getPossessionAsset(const char * nodeIp, const int nodePort, const char* requestedIdentity)
+static void requestPossessedAssets(QCPtr qc, const char* requestedIdentity)
 {
-    std::vector<RespondPossessedAssets> result;
     uint8_t publicKey[32] = {0};
     getPublicKeyFromIdentity(requestedIdentity, publicKey);
     struct {
@@ -44,14 +40,11 @@ std::vector<RespondPossessedAssets> getPossessionAsset(const char * nodeIp, cons
     packet.header.setSize(sizeof(packet));
     packet.header.randomizeDejavu();
     packet.header.setType(REQUEST_POSSESSED_ASSETS);
-    auto qc = make_qc(nodeIp, nodePort);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-
-    return qc->getLatestVectorPacketAs<RespondPossessedAssets>();
 }
 
 template<typename T>
-void getAssetDigest(T& respondedAsset, uint8_t* assetDigest)
+void getAssetDigest(const T& respondedAsset, uint8_t* assetDigest)
 {
     // Check if the size of entity is good
     const size_t asset_size = sizeof(respondedAsset.asset);
@@ -79,7 +72,7 @@ void getAssetDigest(T& respondedAsset, uint8_t* assetDigest)
 }
 
 template<typename T>
-void printAssetDigest(T& respondedAsset)
+void printAssetDigest(const T& respondedAsset)
 {
     uint8_t assetDigest[32];
     getAssetDigest(respondedAsset, assetDigest);
@@ -122,25 +115,29 @@ static void printPossessionAsset(const AssetRecord& owner, const AssetRecord& po
 void printOwnedAsset(const char * nodeIp, const int nodePort, const char* requestedIdentity)
 {
     LOG("======== OWNERSHIP ========\n");
-    auto vroa = getOwnedAsset(nodeIp, nodePort, requestedIdentity);
-    for (auto& roa : vroa)
+    auto qc = make_qc(nodeIp, nodePort);
+    requestOwnedAssets(qc, requestedIdentity);
+    PacketStreamReader reader(qc);
+    reader.forEachPacketAs<RespondOwnedAssets>([](const RespondOwnedAssets& roa)
     {
         printOwnedAsset(roa.asset, roa.issuanceAsset);
         printAssetDigest(roa);
         LOG("Tick: %u\n\n", roa.tick);
-    }
+    });
 }
 
 void printPossessionAsset(const char * nodeIp, const int nodePort, const char* requestedIdentity)
 {
     LOG("======== POSSESSION ========\n");
-    auto vrpa = getPossessionAsset(nodeIp, nodePort, requestedIdentity);
-    for (auto& rpa : vrpa)
+    auto qc = make_qc(nodeIp, nodePort);
+    requestPossessedAssets(qc, requestedIdentity);
+    PacketStreamReader reader(qc);
+    reader.forEachPacketAs<RespondPossessedAssets>([](const RespondPossessedAssets& rpa)
     {
         printPossessionAsset(rpa.ownershipAsset, rpa.asset, rpa.issuanceAsset);
         printAssetDigest(rpa);
         LOG("Tick: %u\n\n", rpa.tick);
-    }
+    });
 }
 
 void printAssetResponse(const RespondAssets& response, bool verbose)
@@ -379,23 +376,20 @@ void printAssetRecords(const char* nodeIp, const int nodePort, const char* reque
     qc->sendData((uint8_t*)&packet, packet.header.size());
 
     bool receivedResponses = false;
+    PacketStreamReader reader(qc);
     if (withSiblings)
     {
-        auto responses = qc->getLatestVectorPacketAs<RespondAssetsWithSiblings>();
-        for (const auto& response : responses)
+        receivedResponses = reader.forEachPacketAs<RespondAssetsWithSiblings>([verbose](const RespondAssetsWithSiblings& response)
         {
             printAssetResponseWithSiblings(response, verbose);
-            receivedResponses = true;
-        }
+        }) > 0;
     }
     else
     {
-        auto responses = qc->getLatestVectorPacketAs<RespondAssets>();
-        for (const auto& response : responses)
+        receivedResponses = reader.forEachPacketAs<RespondAssets>([verbose](const RespondAssets& response)
         {
             printAssetResponse(response, verbose);
-            receivedResponses = true;
-        }
+        }) > 0;
     }
 
     if (!receivedResponses)
@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <map>
+#include <random>
+
+#include "batch_verify.h"
+#include "k12_and_key_utils.h"
+#include "parallel.h"
+
+// smaller groups are verified one by one, since decoding R makes a batch of one or two slower than verify()
+#define INDIVIDUAL_VERIFY_MAX 2
+// larger combinations save hardly any more doublings, but their tables leave the cache and bisection gets longer
+#define MAX_COMBINATION_SIZE 64
+
+namespace
+{
+
+struct DecodedKey
+{
+    point_affine point;
+    unsigned long long scalar[4]; // sum of z_i * h_i of the entries in the current combination, Montgomery form
+    bool used;
+};
+
+struct PreparedSignature
+{
+    size_t index;
+    size_t key;
+    point_affine negatedR;
+    unsigned long long h[4]; // Montgomery form
+    unsigned long long s[4]; // Montgomery form
+};
+
+struct PointTable
+{
+    point_extproj_precomp_t points[4]; // P, 3P, 5P, 7P for wNAF digits of width 4
+};
+
+}
+
+static void addModOrder(const unsigned long long* a, const unsigned long long* b, unsigned long long* c)
+{ // c = a+b mod order, where a,b in [0, order-1]
+    unsigned long long sum[4], difference[4];
+    _addcarry_u64(_addcarry_u64(_addcarry_u64(_addcarry_u64(0, a[0], b[0], &sum[0]), a[1], b[1], &sum[1]), a[2], b[2], &sum[2]), a[3], b[3], &sum[3]);
+    if (!_subborrow_u64(_subborrow_u64(_subborrow_u64(_subborrow_u64(0, sum[0], CURVE_ORDER_0, &difference[0]), sum[1], CURVE_ORDER_1, &difference[1]), sum[2], CURVE_ORDER_2, &difference[2]), sum[3], CURVE_ORDER_3, &difference[3]))
+    {
+        memcpy(c, difference, 32);
+    }
+    else
+    {
+        memcpy(c, sum, 32);
+    }
+}
+
+static void randomCoefficients(size_t count, std::vector<unsigned long long>& coefficients)
+{
+    std::random_device device;
+    uint32_t seed[8];
+    for (auto& word : seed)
+        word = device();
+    coefficients.resize(count);
+    KangarooTwelve((uint8_t*)seed, sizeof(seed), (uint8_t*)coefficients.data(), unsigned(count * sizeof(unsigned long long)));
+    for (auto& z : coefficients)
+    {
+        if (!z)
+            z = 1;
+    }
+}
+
+static void addDigit(point_extproj_precomp_t* table, int digit, point_extproj_t T)
+{
+    point_extproj_precomp_t U;
+    if (digit < 0)
+    {
+        eccneg_extproj_precomp(table[(-digit) >> 1], U);
+        eccadd(U, T);
+    }
+    else if (digit > 0)
+    {
+        eccadd(table[digit >> 1], T);
+    }
+}
+
+static void addFixedBaseDigit(unsigned int tableOffset, int digit, point_extproj_t T)
+{
+    point_precomp_t V;
+    if (digit < 0)
+    {
+        eccneg_precomp(((point_precomp_t*)&DOUBLE_SCALAR_TABLE)[tableOffset + ((-digit) >> 1)], V);
+        eccmadd(V, T);
+    }
+    else if (digit > 0)
+    {
+        eccmadd(((point_precomp_t*)&DOUBLE_SCALAR_TABLE)[tableOffset + (digit >> 1)], T);
+    }
+}
+
+// Whether sum(z_i * s_i) * G + sum(z_i * h_i * A_i) - sum(z_i * R_i) is the neutral point for the given signatures.
+static bool combinationHolds(const std::vector<PreparedSignature>& signatures, size_t first, size_t count, std::vector<DecodedKey>& keys)
+{
+    std::vector<unsigned long long> z;
+    randomCoefficients(count, z);
+
+    // merge the scalars per public key and of G
+    unsigned long long gScalar[4] = {0}, product[4], zMontgomery[4];
+    std::vector<size_t> usedKeys;
+    for (size_t i = 0; i < count; i++)
+    {
+        const PreparedSignature& signature = signatures[first + i];
+        DecodedKey& key = keys[signature.key];
+        if (!key.used)
+        {
+            key.used = true;
+            memset(key.scalar, 0, sizeof(key.scalar));
+            usedKeys.push_back(signature.key);
+        }
+        unsigned long long zi[4] = { z[i], 0, 0, 0 };
+        Montgomery_multiply_mod_order(zi, Montgomery_Rprime, zMontgomery);
+        Montgomery_multiply_mod_order(zMontgomery, signature.h, product);
+        addModOrder(key.scalar, product, key.scalar);
+        Montgomery_multiply_mod_order(zMontgomery, signature.s, product);
+        addModOrder(gScalar, product, gScalar);
+    }
+    Montgomery_multiply_mod_order(gScalar, ONE, gScalar);
+
+    // tables and wNAF digits of A, phi(A), psi(A), psi(phi(A)) for every key and of -R for every signature
+    std::vector<PointTable> keyTables(4 * usedKeys.size());
+    std::vector<char> keyDigits(4 * 65 * usedKeys.size());
+    for (size_t k = 0; k < usedKeys.size(); k++)
+    {
+        DecodedKey& key = keys[usedKeys[k]];
+        key.used = false;
+        Montgomery_multiply_mod_order(key.scalar, ONE, key.scalar);
+        unsigned long long scalars[4];
+        decompose(key.scalar, scalars);
+        point_extproj_t Q1, Q2, Q3, Q4;
+        point_setup(&key.point, Q1);
+        Q2[0] = Q1[0];
+        ecc_phi(Q2);
+        Q3[0] = Q1[0];
+        ecc_psi(Q3);
+        Q4[0] = Q2[0];
+        ecc_psi(Q4);
+        point_extproj* endomorphisms[4] = { Q1, Q2, Q3, Q4 };
+        for (int j = 0; j < 4; j++)
+        {
+            wNAF_recode(scalars[j], 4, &keyDigits[(4 * k + j) * 65]);
+            ecc_precomp_double(endomorphisms[j], keyTables[4 * k + j].points);
+        }
+    }
+    std::vector<PointTable> rTables(count);
+    std::vector<char> rDigits(65 * count);
+    for (size_t i = 0; i < count; i++)
+    {
+        point_extproj_t R;
+        point_setup((point_affine*)&signatures[first + i].negatedR, R);
+        ecc_precomp_double(R, rTables[i].points);
+        wNAF_recode(z[i], 4, &rDigits[65 * i]);
+    }
+    unsigned long long gScalars[4];
+    char gDigits[4][65];
+    decompose(gScalar, gScalars);
+    for (int j = 0; j < 4; j++)
+        wNAF_recode(gScalars[j], 8, gDigits[j]);
+
+    // interleaved multi-scalar multiplication, one doubling per digit for the whole batch
+    point_extproj_t T;
+    memset(T, 0, sizeof(point_extproj_t));
+    T->y[0][0] = 1;
+    T->z[0][0] = 1;
+    for (unsigned int i = 65; i--; )
+    {
+        eccdouble(T);
+        for (size_t t = 0; t < keyTables.size(); t++)
+            addDigit(keyTables[t].points, keyDigits[t * 65 + i], T);
+        for (size_t t = 0; t < count; t++)
+            addDigit(rTables[t].points, rDigits[t * 65 + i], T);
+        for (unsigned int j = 0; j < 4; j++)
+            addFixedBaseDigit(j * 64, gDigits[j][i], T);
+    }
+
+    point_t P;
+    eccnorm(T, P);
+    return !P->x[0][0] && !P->x[0][1] && !P->x[1][0] && !P->x[1][1]
+        && P->y[0][0] == 1 && !P->y[0][1] && !P->y[1][0] && !P->y[1][1];
+}
+
+// verify() of an entry that passed the encoding checks, with its public key already decoded.
+static bool verifyWithDecodedKey(const SignatureToVerify& entry, const point_affine& publicKey)
+{
+    point_t A;
+    A[0] = publicKey;
+    unsigned char temp[32 + 64];
+    unsigned char h[64];
+    memcpy(temp, entry.signature, 32);
+    memcpy(temp + 32, entry.publicKey, 32);
+    memcpy(temp + 64, entry.digest, 32);
+    KangarooTwelve(temp, 32 + 64, h, 64);
+    if (!ecc_mul_double((unsigned long long*)(entry.signature + 32), (unsigned long long*)h, A))
+        return false;
+    encode(A, (unsigned char*)A);
+    return memcmp(A, entry.signature, 32) == 0;
+}
+
+static void verifyRange(const std::vector<SignatureToVerify>& entries, const std::vector<PreparedSignature>& signatures,
+                        size_t first, size_t count, std::vector<DecodedKey>& keys, std::vector<uint8_t>& results)
+{
+    if (count <= INDIVIDUAL_VERIFY_MAX)
+    {
+        for (size_t i = first; i < first + count; i++)
+            results[signatures[i].index] = verifyWithDecodedKey(entries[signatures[i].index], keys[signatures[i].key].point);
+        return;
+    }
+    if (combinationHolds(signatures, first, count, keys))
+    {
+        for (size_t i = first; i < first + count; i++)
+            results[signatures[i].index] = true;
+        return;
+    }
+    // bisect to find the invalid entries
+    verifyRange(entries, signatures, first, count / 2, keys, results);
+    verifyRange(entries, signatures, first + count / 2, count - count / 2, keys, results);
+}
+
+// Verify entries [first, first + count), the results of these entries are written to results.
+static void verifyChunk(const std::vector<SignatureToVerify>& entries, size_t first, size_t count, const DecodedPublicKeys* decodedKeys,
+                        std::vector<uint8_t>& results)
+{
+    std::vector<DecodedKey> keys;
+    std::vector<bool> validKeys;
+    std::map<std::array<uint8_t, 32>, size_t> keyIndices;
+    std::vector<PreparedSignature> signatures;
+    signatures.reserve(count);
+    for (size_t i = first; i < first + count; i++)
+    {
+        const SignatureToVerify& entry = entries[i];
+        // same encoding checks as verify(), entries failing them stay invalid
+        if ((entry.publicKey[15] & 0x80) || (entry.signature[15] & 0x80) || (entry.signature[62] & 0xC0) || entry.signature[63])
+            continue;
+
+        std::array<uint8_t, 32> publicKey;
+        memcpy(publicKey.data(), entry.publicKey, 32);
+        auto found = keyIndices.find(publicKey);
+        size_t key;
+        if (found == keyIndices.end())
+        {
+            key = keys.size();
+            keyIndices[publicKey] = key;
+            keys.emplace_back();
+            keys[key].used = false;
+            const unsigned long long* point = decodedKeys ? decodedKeys->find(entry.publicKey) : nullptr;
+            if (point)
+                memcpy(&keys[key].point, point, sizeof(point_affine));
+            validKeys.push_back(point || decode(entry.publicKey, &keys[key].point));
+        }
+        else
+        {
+            key = found->second;
+        }
+        if (!validKeys[key])
+            continue;
+
+        // verify() compares the encoding of s*G + h*A with R, so R must decode and be encoded canonically
+        PreparedSignature signature;
+        uint8_t encoded[32];
+        if (!decode(entry.signature, &signature.negatedR))
+            continue;
+        encode(&signature.negatedR, encoded);
+        if (memcmp(encoded, entry.signature, 32) != 0)
+            continue;
+        fp2neg1271(signature.negatedR.x);
+
+        unsigned char temp[32 + 64];
+        unsigned long long h[8];
+        memcpy(temp, entry.signature, 32);
+        memcpy(temp + 32, entry.publicKey, 32);
+        memcpy(temp + 64, entry.digest, 32);
+        KangarooTwelve(temp, 32 + 64, (uint8_t*)h, 64);
+        Montgomery_multiply_mod_order(h, Montgomery_Rprime, signature.h);
+        unsigned long long s[4];
+        memcpy(s, entry.signature + 32, 32);
+        Montgomery_multiply_mod_order(s, Montgomery_Rprime, signature.s);
+        signature.index = i;
+        signature.key = key;
+        signatures.push_back(signature);
+    }
+
+    verifyRange(entries, signatures, 0, signatures.size(), keys, results);
+}
+
+static_assert(sizeof(point_affine) == sizeof(unsigned long long[8]), "DecodedPublicKeys stores points as 8 words");
+
+void DecodedPublicKeys::add(const uint8_t* publicKeys, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t* publicKey = publicKeys + 32 * i;
+        point_t point;
+        if ((publicKey[15] & 0x80) || !decode(publicKey, point))
+            continue;
+        std::array<uint8_t, 32> key;
+        memcpy(key.data(), publicKey, 32);
+        memcpy(mPoints[key].data(), point, sizeof(point_affine));
+    }
+}
+
+const unsigned long long* DecodedPublicKeys::find(const uint8_t* publicKey) const
+{
+    std::array<uint8_t, 32> key;
+    memcpy(key.data(), publicKey, 32);
+    auto found = mPoints.find(key);
+    return found == mPoints.end() ? nullptr : found->second.data();
+}
+
+size_t DecodedPublicKeys::size() const
+{
+    return mPoints.size();
+}
+
+std::vector<bool> verifySignatures(const std::vector<SignatureToVerify>& entries, int numberOfThreads, const DecodedPublicKeys* decodedKeys)
+{
+    std::vector<uint8_t> results(entries.size(), 0);
+    size_t numberOfChunks = (entries.size() + MAX_COMBINATION_SIZE - 1) / MAX_COMBINATION_SIZE;
+    parallelFor(numberOfChunks, numberOfThreads, [&](size_t chunk)
+    {
+        size_t first = chunk * MAX_COMBINATION_SIZE;
+        verifyChunk(entries, first, std::min<size_t>(MAX_COMBINATION_SIZE, entries.size() - first), decodedKeys, results);
+    });
+    return std::vector<bool>(results.begin(), results.end());
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// One SchnorrQ signature to check, all pointers are borrowed.
+struct SignatureToVerify
+{
+    const uint8_t* publicKey; // 32 bytes
+    const uint8_t* digest;    // 32 bytes
+    const uint8_t* signature; // 64 bytes
+};
+
+// Public keys decoded into curve points once, for keys that sign again and again (the computors). Decoding a key takes
+// a square root in the field, which is a large part of verifying one signature.
+class DecodedPublicKeys
+{
+public:
+    // Decode count keys of 32 bytes each. Keys that are not on the curve are left out, their signatures fail as usual.
+    void add(const uint8_t* publicKeys, size_t count);
+
+    // The decoded point of publicKey (affine x and y, as used by the FourQ code), nullptr if it was not added.
+    const unsigned long long* find(const uint8_t* publicKey) const;
+
+    size_t size() const;
+
+private:
+    std::map<std::array<uint8_t, 32>, std::array<unsigned long long, 8>> mPoints;
+};
+
+// Verify many signatures together. Return one result per entry, equal to verify() of the entry.
+//
+// The entries are checked with one randomized linear combination of their verification equations,
+//     sum(z_i * R_i) == (sum(z_i * s_i)) * G + sum(z_i * h_i * A_i)
+// with random 64-bit z_i, evaluated as a single interleaved multi-scalar multiplication: the doublings are shared by
+// the whole batch and the terms of entries with the same public key are merged. If the combination does not hold,
+// the batch is split in halves until the invalid entries are isolated, small groups are verified one by one.
+// An invalid signature passes the combination with probability 2^-64, unless its error is a point of small order
+// (which only the owner of the key can produce on purpose); such errors are caught with probability of at least 1/2.
+// Combinations of up to 64 entries are spread over numberOfThreads threads (0 = one per core). Keys found in
+// decodedKeys are not decoded again.
+std::vector<bool> verifySignatures(const std::vector<SignatureToVerify>& entries, int numberOfThreads = 1,
+                                   const DecodedPublicKeys* decodedKeys = nullptr);
@@ -0,0 +1,965 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "batch_verify.h"
+#include "benchmark.h"
+#include "buffer_pool.h"
+#include "computor_list.h"
+#include "connection.h"
+#include "k12_and_key_utils.h"
+#include "k12_batch.h"
+#include "key_utils.h"
+#include "logger.h"
+#include "lz_codec.h"
+#include "merkle_verify.h"
+#include "node_utils.h"
+#include "parallel.h"
+#include "signer.h"
+#include "tick_file.h"
+#include "tick_verifier.h"
+#include "tick_watcher.h"
+#include "wallet_utils.h"
+
+typedef void (*BenchmarkFunction)(const char* nodeIp, int nodePort, const char* parameter);
+
+struct BenchmarkEntry
+{
+    const char* name;
+    const char* parameterHelp;
+    BenchmarkFunction function;
+};
+
+static long long parameterOrDefault(const char* parameter, long long defaultValue)
+{
+    if (!parameter || !parameter[0])
+        return defaultValue;
+    return strtoll(parameter, nullptr, 10);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Resident set size of this process in bytes, 0 if unknown on this platform.
+static size_t getResidentMemory()
+{
+#ifdef __linux__
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f)
+        return 0;
+    unsigned long long totalPages = 0, residentPages = 0;
+    int read = fscanf(f, "%llu %llu", &totalPages, &residentPages);
+    fclose(f);
+    if (read != 2)
+        return 0;
+    return size_t(residentPages) * size_t(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+static void benchmarkConnectionMemory(const char* nodeIp, int nodePort, const char* parameter)
+{
+    const int numberOfConnections = int(parameterOrDefault(parameter, 32));
+    LOG("sizeof(QubicConnection): %zu bytes\n", sizeof(QubicConnection));
+
+    size_t rssBefore = getResidentMemory();
+    std::vector<QCPtr> connections(numberOfConnections);
+    std::vector<std::thread> threads;
+    std::mutex logMutex;
+    auto start = std::chrono::steady_clock::now();
+    // bypass the connection pool, every connection is distinct; connect in parallel to avoid waiting for each handshake
+    for (int i = 0; i < numberOfConnections; i++)
+    {
+        threads.emplace_back([&, i]()
+        {
+            try
+            {
+                connections[i] = std::make_shared<QubicConnection>(nodeIp, nodePort);
+            }
+            catch (std::logic_error& e)
+            {
+                std::lock_guard<std::mutex> lock(logMutex);
+                LOG("Connection %d failed: %s\n", i, e.what());
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    double elapsed = secondsSince(start);
+    size_t rssAfter = getResidentMemory();
+
+    int opened = 0;
+    for (auto& connection : connections)
+        opened += (connection != nullptr);
+    LOG("Opened %d connections in %.3f s\n", opened, elapsed);
+    if (opened && rssBefore && rssAfter)
+    {
+        LOG("Resident memory: %zu KB before, %zu KB after\n", rssBefore / 1024, rssAfter / 1024);
+        LOG("Resident memory per connection: %.1f KB\n", double(rssAfter - rssBefore) / opened / 1024.0);
+    }
+    else if (!rssBefore)
+    {
+        LOG("Resident memory measurement is not supported on this platform\n");
+    }
+    LOG("Receive buffer memory retained by pool: %zu KB\n", BufferPool::shared().retainedBytes() / 1024);
+}
+
+static void benchmarkTickWait(const char* nodeIp, int nodePort, const char* parameter)
+{
+    const int numberOfWaiters = int(parameterOrDefault(parameter, 100));
+    auto watcher = TickWatcher::forNode(nodeIp, nodePort);
+    uint32_t startTick = watcher->getCurrentTick();
+    if (startTick == 0)
+    {
+        LOG("Failed to get current tick\n");
+        return;
+    }
+    size_t pollsBefore = watcher->getNumberOfPolls();
+    LOG("Current tick %u, %d waiters wait for tick %u\n", startTick, numberOfWaiters, startTick + 2);
+
+    // time at which each waiter was woken up; the spread shows how promptly all subscribers are released
+    std::vector<double> wakeupTime(numberOfWaiters);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numberOfWaiters; i++)
+    {
+        threads.emplace_back([&, i]()
+        {
+            watcher->waitForTick(startTick + 2);
+            wakeupTime[i] = secondsSince(start);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    double elapsed = secondsSince(start);
+    double firstWakeup = elapsed;
+    for (double t : wakeupTime)
+        firstWakeup = std::min(firstWakeup, t);
+
+    size_t polls = watcher->getNumberOfPolls() - pollsBefore;
+    LOG("Reached tick %u after %.3f s, all waiters woken within %.3f s\n", startTick + 2, firstWakeup, elapsed - firstWakeup);
+    LOG("Tick info requests: %zu shared by %d waiters (sleep-polling every 1 s would send about %.0f)\n",
+        polls, numberOfWaiters, numberOfWaiters * elapsed);
+    LOG("Estimated tick duration: %lld ms\n", watcher->getTickDurationEstimateMsec());
+}
+
+// Bytes a file of the given size occupies on chain when uploaded: payload plus transaction overhead of the file
+// header and of every fragment.
+static size_t bytesOnChain(size_t fileSize)
+{
+    const size_t fragmentPayload = 1024 - FileFragmentTransactionPrefix::minInputSize();
+    size_t fragments = (fileSize + fragmentPayload - 1) / fragmentPayload;
+    return sizeof(FileHeaderTransaction) + fileSize + fragments * (sizeof(FileFragmentTransactionPrefix) + SIGNATURE_SIZE);
+}
+
+static size_t fileSizeOf(const std::string& fileName)
+{
+    FILE* f = fopen(fileName.c_str(), "rb");
+    if (!f)
+        return 0;
+    fseek(f, 0, SEEK_END);
+    size_t size = size_t(ftell(f));
+    fclose(f);
+    return size;
+}
+
+static void benchmarkCompression(const char* nodeIp, int nodePort, const char* parameter)
+{
+    // default input: log-like text, roughly what gets uploaded in practice
+    std::string fileName = (parameter && parameter[0]) ? parameter : "qlz_benchmark_input.txt";
+    if (!parameter || !parameter[0])
+    {
+        FILE* f = fopen(fileName.c_str(), "wb");
+        if (!f)
+        {
+            LOG("Failed to create %s\n", fileName.c_str());
+            return;
+        }
+        srand(1);
+        for (int i = 0; i < 200000; i++)
+            fprintf(f, "tick %d computor %d digest %08x%08x status %s\n", 4000000 + i / 7, rand() % 676, rand(), rand(), (rand() % 5) ? "ok" : "missing");
+        fclose(f);
+    }
+    std::vector<uint8_t> input(fileSizeOf(fileName));
+    FILE* f = fopen(fileName.c_str(), "rb");
+    if (!f || input.empty() || fread(input.data(), 1, input.size(), f) != input.size())
+    {
+        LOG("Failed to read %s\n", fileName.c_str());
+        if (f)
+            fclose(f);
+        return;
+    }
+    fclose(f);
+    LOG("Input: %s, %zu bytes, %zu bytes on chain uncompressed\n", fileName.c_str(), input.size(), bytesOnChain(input.size()));
+    LOG("%-6s %12s %14s %12s %12s\n", "tool", "compressed", "bytes on chain", "compress s", "decompress s");
+
+    // built-in codec, in process
+    std::vector<uint8_t> compressed;
+    auto start = std::chrono::steady_clock::now();
+    QlzCompressor compressor("txt", input.size(), [&](const uint8_t* data, size_t size)
+    {
+        compressed.insert(compressed.end(), data, data + size);
+    });
+    compressor.write(input.data(), input.size());
+    compressor.finish();
+    double compressTime = secondsSince(start);
+    std::vector<uint8_t> output;
+    start = std::chrono::steady_clock::now();
+    QlzDecompressor decompressor([&](const uint8_t* data, size_t size)
+    {
+        output.insert(output.end(), data, data + size);
+    });
+    bool ok = decompressor.write(compressed.data(), compressed.size()) && decompressor.finished() && output == input;
+    double decompressTime = secondsSince(start);
+    LOG("%-6s %12zu %14zu %12.3f %12.3f%s\n", "qlz", compressed.size(), bytesOnChain(compressed.size()), compressTime, decompressTime,
+        ok ? "" : "  ROUND TRIP FAILED");
+
+    // external tools, through temporary files as uploadFile/downloadFile do
+    const char* tools[] = { "zip", "tar" };
+    for (const char* tool : tools)
+    {
+        start = std::chrono::steady_clock::now();
+        std::string compressedFile = compressFileWithTool(fileName.c_str(), tool);
+        compressTime = secondsSince(start);
+        size_t compressedSize = compressedFile.empty() ? 0 : fileSizeOf(compressedFile);
+        if (!compressedSize)
+        {
+            LOG("%-6s not available\n", tool);
+            continue;
+        }
+        // extract somewhere else so the input is not overwritten
+        std::string extractDir = "qlz_benchmark_extract";
+        std::error_code error;
+        std::filesystem::create_directories(extractDir, error);
+        if (error)
+            continue;
+        std::string extractFile = extractDir + "/" + compressedFile.substr(compressedFile.find_last_of("/\\") + 1);
+        rename(compressedFile.c_str(), extractFile.c_str());
+        start = std::chrono::steady_clock::now();
+        std::string cwdCommand = "cd " + extractDir + " && " + (strcmp(tool, "zip") == 0 ? "unzip -oq " : "tar -xzf ") + extractFile.substr(extractDir.size() + 1);
+        int status = system(cwdCommand.c_str());
+        decompressTime = secondsSince(start);
+        LOG("%-6s %12zu %14zu %12.3f %12.3f%s\n", tool, compressedSize, bytesOnChain(compressedSize), compressTime, decompressTime,
+            status == 0 ? "" : "  DECOMPRESSION FAILED");
+        std::filesystem::remove_all(extractDir, error);
+        if (error)
+            LOG("Failed to remove %s\n", extractDir.c_str());
+    }
+    if (!parameter || !parameter[0])
+        remove(fileName.c_str());
+}
+
+static void benchmarkBatchVerify(const char* nodeIp, int nodePort, const char* parameter)
+{
+    const size_t maxBatchSize = size_t(parameterOrDefault(parameter, 1024));
+    if (maxBatchSize == 0)
+        return;
+    // every signature from a different key, like quorum votes (transactions of a tick often share keys, which is faster)
+    std::vector<uint8_t> publicKeys(32 * maxBatchSize), digests(32 * maxBatchSize), signatures(64 * maxBatchSize);
+    for (size_t i = 0; i < maxBatchSize; i++)
+    {
+        uint8_t subseed[32], privateKey[32];
+        uint64_t number = i;
+        KangarooTwelve((uint8_t*)&number, sizeof(number), subseed, 32);
+        KangarooTwelve(subseed, 32, &digests[32 * i], 32);
+        getPrivateKeyFromSubSeed(subseed, privateKey);
+        getPublicKeyFromPrivateKey(privateKey, &publicKeys[32 * i]);
+        sign(subseed, &publicKeys[32 * i], &digests[32 * i], &signatures[64 * i]);
+    }
+    std::vector<SignatureToVerify> entries(maxBatchSize);
+    for (size_t i = 0; i < maxBatchSize; i++)
+        entries[i] = { &publicKeys[32 * i], &digests[32 * i], &signatures[64 * i] };
+    // like a computor list, decoded once up front
+    DecodedPublicKeys decodedKeys;
+    decodedKeys.add(publicKeys.data(), maxBatchSize);
+
+    LOG("%10s %14s %14s %8s %18s %16s %8s\n", "batch size", "verify/s", "batch/s", "speedup", "batch/s 1 invalid", "batch/s decoded", "speedup");
+    for (size_t batchSize = 1; batchSize <= maxBatchSize; batchSize *= 2)
+    {
+        // about the same number of signatures for every batch size
+        const size_t rounds = std::max<size_t>(1, 1024 / batchSize);
+        std::vector<SignatureToVerify> batch(entries.begin(), entries.begin() + batchSize);
+        bool allValid = true;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; round++)
+        {
+            for (const auto& entry : batch)
+                allValid &= verify(entry.publicKey, entry.digest, entry.signature);
+        }
+        double individualRate = double(rounds * batchSize) / secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; round++)
+        {
+            for (bool valid : verifySignatures(batch))
+                allValid &= valid;
+        }
+        double batchRate = double(rounds * batchSize) / secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; round++)
+        {
+            for (bool valid : verifySignatures(batch, 1, &decodedKeys))
+                allValid &= valid;
+        }
+        double decodedRate = double(rounds * batchSize) / secondsSince(start);
+
+        // one wrong digest in the middle of the batch
+        std::vector<uint8_t> wrongDigest(batch[batchSize / 2].digest, batch[batchSize / 2].digest + 32);
+        wrongDigest[0] ^= 1;
+        batch[batchSize / 2].digest = wrongDigest.data();
+        size_t numberOfInvalid = 0;
+        start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; round++)
+        {
+            for (bool valid : verifySignatures(batch))
+                numberOfInvalid += valid ? 0 : 1;
+        }
+        double invalidRate = double(rounds * batchSize) / secondsSince(start);
+
+        LOG("%10zu %14.0f %14.0f %7.2fx %18.0f %16.0f %7.2fx%s\n", batchSize, individualRate, batchRate, batchRate / individualRate,
+            invalidRate, decodedRate, decodedRate / individualRate, (allValid && numberOfInvalid == rounds) ? "" : "  WRONG RESULT");
+    }
+}
+
+static void benchmarkTickVerify(const char* nodeIp, int nodePort, const char* parameter)
+{
+    const int numberOfTicks = int(parameterOrDefault(parameter, 16));
+    const int transactionsPerTick = 256;
+    const int numberOfSenders = 64;
+    const std::string directory = "tickverify_benchmark";
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (numberOfTicks <= 0 || error)
+        return;
+
+    // synthetic epoch: computor list, and ticks with transactions of a few senders, all signed correctly
+    auto makeKey = [](uint64_t number, uint8_t* subseed, uint8_t* publicKey)
+    {
+        uint8_t privateKey[32];
+        KangarooTwelve((uint8_t*)&number, sizeof(number), subseed, 32);
+        getPrivateKeyFromSubSeed(subseed, privateKey);
+        getPublicKeyFromPrivateKey(privateKey, publicKey);
+    };
+    BroadcastComputors computors;
+    memset(&computors, 0, sizeof(computors));
+    computors.computors.epoch = 100;
+    std::vector<uint8_t> computorSubseeds(32 * NUMBER_OF_COMPUTORS), senderSubseeds(32 * numberOfSenders), senderKeys(32 * numberOfSenders);
+    for (int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+        makeKey(i, &computorSubseeds[32 * i], computors.computors.publicKeys[i]);
+    for (int i = 0; i < numberOfSenders; i++)
+        makeKey(1000000 + i, &senderSubseeds[32 * i], &senderKeys[32 * i]);
+    std::string computorFile = directory + "/computors";
+    FILE* f = fopen(computorFile.c_str(), "wb");
+    if (!f)
+        return;
+    fwrite(&computors, 1, sizeof(computors), f);
+    fclose(f);
+    const ComputorList computorList(computors);
+
+    std::vector<std::string> fileNames;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < numberOfTicks; t++)
+    {
+        TickData td;
+        memset(&td, 0, sizeof(td));
+        td.epoch = computors.computors.epoch;
+        td.tick = 1000 + t;
+        td.computorIndex = t % NUMBER_OF_COMPUTORS;
+        std::vector<uint8_t> transactions;
+        for (int i = 0; i < transactionsPerTick; i++)
+        {
+            uint8_t data[sizeof(Transaction) + 8 + SIGNATURE_SIZE] = {0};
+            Transaction* tx = (Transaction*)data;
+            int sender = (t * transactionsPerTick + i) % numberOfSenders;
+            memcpy(tx->sourcePublicKey, &senderKeys[32 * sender], 32);
+            tx->amount = i + 1;
+            tx->tick = td.tick;
+            tx->inputSize = 8;
+            memcpy(data + sizeof(Transaction), &i, sizeof(i));
+            uint8_t digest[32];
+            KangarooTwelve(data, sizeof(Transaction) + 8, digest, 32);
+            sign(&senderSubseeds[32 * sender], tx->sourcePublicKey, digest, data + sizeof(Transaction) + 8);
+            KangarooTwelve(data, sizeof(data), td.transactionDigests[i], 32);
+            transactions.insert(transactions.end(), data, data + sizeof(data));
+        }
+        uint8_t digest[32];
+        td.computorIndex ^= TickData::type();
+        KangarooTwelve((uint8_t*)&td, sizeof(TickData) - SIGNATURE_SIZE, digest, 32);
+        td.computorIndex ^= TickData::type();
+        sign(&computorSubseeds[32 * td.computorIndex], computors.computors.publicKeys[td.computorIndex], digest, td.signature);
+
+        fileNames.push_back(directory + "/tick" + std::to_string(td.tick));
+        f = fopen(fileNames.back().c_str(), "wb");
+        if (!f)
+            return;
+        fwrite(&td, 1, sizeof(td), f);
+        fwrite(transactions.data(), 1, transactions.size(), f);
+        fclose(f);
+    }
+    LOG("Generated %d ticks with %d transactions each in %.3f s\n", numberOfTicks, transactionsPerTick, secondsSince(start));
+
+    const int cores = std::max(1, int(std::thread::hardware_concurrency()));
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < cores; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(cores);
+    LOG("%8s %10s %16s %8s\n", "threads", "seconds", "transactions/s", "scaling");
+    double singleThreadRate = 0;
+    for (int threads : threadCounts)
+    {
+        start = std::chrono::steady_clock::now();
+        auto verdicts = verifyTickFiles(fileNames, computorList, threads);
+        double seconds = secondsSince(start);
+        bool allOk = true;
+        for (const auto& verdict : verdicts)
+            allOk &= verdict.ok();
+        double rate = double(numberOfTicks) * transactionsPerTick / seconds;
+        if (threads == 1)
+            singleThreadRate = rate;
+        LOG("%8d %10.3f %16.0f %7.2fx%s\n", threads, seconds, rate, rate / singleThreadRate, allOk ? "" : "  VERIFICATION FAILED");
+    }
+    std::filesystem::remove_all(directory, error);
+    if (error)
+        LOG("Failed to remove %s\n", directory.c_str());
+}
+
+// The loader used before TickFile: one read per field, a nested loop to put the transactions in the order of the
+// tick data and a copy of every vector. Kept to compare against.
+static void readTickFileQuadratic(const char* fileName, TickData& td, std::vector<Transaction>& txs, std::vector<extraDataStruct>& extraData,
+                                  std::vector<SignatureStruct>& signatures, std::vector<TxhashStruct>& txHashes)
+{
+    uint8_t extraDataBuffer[MAX_INPUT_SIZE] = {0};
+    uint8_t signatureBuffer[SIGNATURE_SIZE] = {0};
+    char txHashBuffer[61] = {0};
+    uint8_t all_zero[32] = {0};
+    FILE* f = fopen(fileName, "rb");
+    if (!f || fread(&td, 1, sizeof(TickData), f) != sizeof(TickData))
+    {
+        if (f)
+            fclose(f);
+        return;
+    }
+    int numTx;
+    for (numTx = NUMBER_OF_TRANSACTIONS_PER_TICK; numTx > 0; numTx--)
+    {
+        if (memcmp(all_zero, td.transactionDigests[numTx - 1], 32) != 0)
+            break;
+    }
+    std::vector<uint8_t> vDigests(32 * numTx);
+    for (int i = 0; i < numTx; i++)
+    {
+        Transaction tx;
+        if (fread(&tx, 1, sizeof(Transaction), f) != sizeof(Transaction) || tx.inputSize > MAX_INPUT_SIZE
+            || fread(extraDataBuffer, 1, tx.inputSize, f) != tx.inputSize || fread(signatureBuffer, 1, SIGNATURE_SIZE, f) != SIGNATURE_SIZE)
+            break;
+        extraDataStruct eds;
+        eds.vecU8.assign(extraDataBuffer, extraDataBuffer + tx.inputSize);
+        extraData.push_back(eds);
+        SignatureStruct sig;
+        memcpy(sig.sig, signatureBuffer, SIGNATURE_SIZE);
+        signatures.push_back(sig);
+        std::vector<uint8_t> raw_data(sizeof(Transaction) + tx.inputSize + SIGNATURE_SIZE);
+        memcpy(raw_data.data(), &tx, sizeof(Transaction));
+        memcpy(raw_data.data() + sizeof(Transaction), extraDataBuffer, tx.inputSize);
+        memcpy(raw_data.data() + sizeof(Transaction) + tx.inputSize, signatureBuffer, SIGNATURE_SIZE);
+        KangarooTwelve(raw_data.data(), uint32_t(raw_data.size()), &vDigests[32 * i], 32);
+        TxhashStruct tx_hash;
+        getTxHashFromDigest(&vDigests[32 * i], txHashBuffer);
+        memcpy(tx_hash.hash, txHashBuffer, 60);
+        txHashes.push_back(tx_hash);
+        txs.push_back(tx);
+    }
+    fclose(f);
+    txs.resize(numTx);
+    extraData.resize(numTx);
+    signatures.resize(numTx);
+    txHashes.resize(numTx);
+
+    std::vector<Transaction> _txs(numTx);
+    std::vector<extraDataStruct> _extraData(numTx);
+    std::vector<SignatureStruct> _signatures(numTx);
+    std::vector<TxhashStruct> _txHashes(numTx);
+    for (int i = 0; i < numTx; i++)
+    {
+        for (int j = 0; j < numTx; j++)
+        {
+            if (memcmp(&vDigests[32 * j], td.transactionDigests[i], 32) == 0)
+            {
+                _txs[i] = txs[j];
+                _extraData[i] = extraData[j];
+                _signatures[i] = signatures[j];
+                _txHashes[i] = txHashes[j];
+            }
+        }
+    }
+    txs = _txs;
+    extraData = _extraData;
+    signatures = _signatures;
+    txHashes = _txHashes;
+}
+
+static void benchmarkTickRead(const char* nodeIp, int nodePort, const char* parameter)
+{
+    const int numberOfTicks = int(parameterOrDefault(parameter, 16));
+    const std::string directory = "tickread_benchmark";
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (numberOfTicks <= 0 || error)
+        return;
+
+    // full ticks, the transactions are stored in a different order than they are listed in the tick data
+    std::vector<std::string> fileNames;
+    size_t numberOfBytes = 0;
+    for (int t = 0; t < numberOfTicks; t++)
+    {
+        TickData td;
+        memset(&td, 0, sizeof(td));
+        td.epoch = 100;
+        td.tick = 1000 + t;
+        std::vector<std::vector<uint8_t>> transactions(NUMBER_OF_TRANSACTIONS_PER_TICK);
+        for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
+        {
+            const uint16_t inputSize = uint16_t((i * 37 + t) % 256);
+            std::vector<uint8_t>& data = transactions[i];
+            data.resize(sizeof(Transaction) + inputSize + SIGNATURE_SIZE);
+            for (size_t b = 0; b < data.size(); b++)
+                data[b] = uint8_t(b * 131 + i * 7 + t);
+            Transaction* tx = (Transaction*)data.data();
+            tx->amount = i + 1;
+            tx->tick = td.tick;
+            tx->inputSize = inputSize;
+            KangarooTwelve(data.data(), unsigned(data.size()), td.transactionDigests[i], 32);
+        }
+        fileNames.push_back(directory + "/tick" + std::to_string(td.tick));
+        FILE* f = fopen(fileNames.back().c_str(), "wb");
+        if (!f)
+            return;
+        fwrite(&td, 1, sizeof(td), f);
+        numberOfBytes += sizeof(td);
+        for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
+        {
+            // 997 is odd, so this is a permutation of the transactions
+            const std::vector<uint8_t>& data = transactions[(i * 997 + t) % NUMBER_OF_TRANSACTIONS_PER_TICK];
+            fwrite(data.data(), 1, data.size(), f);
+            numberOfBytes += data.size();
+        }
+        fclose(f);
+    }
+    LOG("Generated %d ticks with %d transactions each, %.2f MB\n", numberOfTicks, NUMBER_OF_TRANSACTIONS_PER_TICK, numberOfBytes / 1048576.0);
+
+    bool sameResult = true;
+    double quadraticSeconds = 0, tickFileSeconds = 0;
+    for (const auto& fileName : fileNames)
+    {
+        TickData td;
+        std::vector<Transaction> txs;
+        std::vector<extraDataStruct> extraData;
+        std::vector<SignatureStruct> signatures;
+        std::vector<TxhashStruct> txHashes;
+        auto start = std::chrono::steady_clock::now();
+        readTickFileQuadratic(fileName.c_str(), td, txs, extraData, signatures, txHashes);
+        quadraticSeconds += secondsSince(start);
+
+        TickFile tickFile;
+        start = std::chrono::steady_clock::now();
+        tickFile.read(fileName.c_str());
+        tickFileSeconds += secondsSince(start);
+
+        const auto& views = tickFile.transactions();
+        sameResult &= (views.size() == txs.size());
+        for (size_t i = 0; sameResult && i < views.size(); i++)
+        {
+            sameResult &= views[i].transaction && memcmp(views[i].transaction, &txs[i], sizeof(Transaction)) == 0
+                && memcmp(views[i].input, extraData[i].vecU8.data(), extraData[i].vecU8.size()) == 0
+                && memcmp(views[i].signature, signatures[i].sig, SIGNATURE_SIZE) == 0;
+        }
+    }
+    const double numberOfTransactions = double(numberOfTicks) * NUMBER_OF_TRANSACTIONS_PER_TICK;
+    LOG("%12s %10s %16s\n", "loader", "ticks/s", "transactions/s");
+    LOG("%12s %10.1f %16.0f\n", "quadratic", numberOfTicks / quadraticSeconds, numberOfTransactions / quadraticSeconds);
+    LOG("%12s %10.1f %16.0f\n", "TickFile", numberOfTicks / tickFileSeconds, numberOfTransactions / tickFileSeconds);
+    LOG("Speedup: %.2fx%s\n", quadraticSeconds / tickFileSeconds, sameResult ? "" : "  WRONG RESULT");
+    std::filesystem::remove_all(directory, error);
+    if (error)
+        LOG("Failed to remove %s\n", directory.c_str());
+}
+
+static void benchmarkK12Batch(const char* nodeIp, int nodePort, const char* parameter)
+{
+    const size_t count = size_t(parameterOrDefault(parameter, 65536));
+    if (count == 0)
+        return;
+    LOG("Implementation: %s\n", getKangarooTwelveBatchImplementation());
+
+    // same results as KangarooTwelve() around the block boundaries and the padding byte positions
+    bool correct = true;
+    const unsigned int lengths[] = { 0, 1, 31, 32, 64, 80, 135, 136, 166, 167, 168, 169, 200, 335, 336, 337, 1000, 8191, 8192 };
+    const unsigned int outputLengths[] = { 3, 32, 64, 168, 200 };
+    for (unsigned int length : lengths)
+    {
+        for (unsigned int outputLength : outputLengths)
+        {
+            const size_t n = 11; // not a multiple of the vector width
+            std::vector<uint8_t> input(length * n + 1), batchOutput(outputLength * n), output(outputLength);
+            for (size_t i = 0; i < input.size(); i++)
+                input[i] = uint8_t(i * 131 + length);
+            KangarooTwelveBatch(input.data(), length, batchOutput.data(), outputLength, n);
+            for (size_t i = 0; i < n; i++)
+            {
+                KangarooTwelve(input.data() + i * length, length, output.data(), outputLength);
+                if (memcmp(output.data(), &batchOutput[i * outputLength], outputLength) != 0)
+                {
+                    LOG("WRONG RESULT for input length %u, output length %u\n", length, outputLength);
+                    correct = false;
+                }
+            }
+        }
+    }
+    if (correct)
+        LOG("Batch results equal KangarooTwelve()\n");
+
+    std::vector<uint8_t> inputs(80 * count), outputs(32 * count);
+    for (size_t i = 0; i < inputs.size(); i++)
+        inputs[i] = uint8_t(i * 2654435761u >> 13);
+    LOG("%12s %14s %14s %8s\n", "input bytes", "scalar hash/s", "batch hash/s", "speedup");
+    for (unsigned int length : { 32u, 64u, 80u })
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++)
+            KangarooTwelve(&inputs[length * i], length, &outputs[32 * i], 32);
+        double scalarRate = double(count) / secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        KangarooTwelveBatch(inputs.data(), length, outputs.data(), 32, count);
+        double batchRate = double(count) / secondsSince(start);
+        LOG("%12u %14.0f %14.0f %7.2fx\n", length, scalarRate, batchRate, batchRate / scalarRate);
+    }
+
+    // public keys to identities
+    std::vector<char> identities(61 * count), identity(61, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+        getIdentityFromPublicKey(&inputs[32 * i], &identities[61 * i], false);
+    double scalarRate = double(count) / secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    getIdentitiesFromPublicKeys(inputs.data(), count, identities.data(), false);
+    double batchRate = double(count) / secondsSince(start);
+    for (size_t i = 0; i < count && correct; i++)
+    {
+        getIdentityFromPublicKey(&inputs[32 * i], identity.data(), false);
+        correct = (memcmp(identity.data(), &identities[61 * i], 60) == 0);
+    }
+    LOG("Identities:    %14.0f %14.0f %7.2fx%s\n", scalarRate, batchRate, batchRate / scalarRate, correct ? "" : "  WRONG RESULT");
+
+    // Merkle proofs of depth 24, hashed one proof at a time or level by level over all proofs
+    const unsigned int depth = 24;
+    const size_t numberOfProofs = std::max<size_t>(1, count / depth);
+    std::vector<uint8_t> siblings(32 * depth * numberOfProofs), leaves(32 * numberOfProofs), roots(32 * numberOfProofs), batchRoots(32 * numberOfProofs);
+    for (size_t i = 0; i < siblings.size(); i++)
+        siblings[i] = uint8_t(i * 40503u >> 7);
+    for (size_t i = 0; i < leaves.size(); i++)
+        leaves[i] = uint8_t(i * 977u);
+    start = std::chrono::steady_clock::now();
+    for (size_t p = 0; p < numberOfProofs; p++)
+    {
+        getDigestFromSiblings<32>(depth, &leaves[32 * p], 32, unsigned(p), (const uint8_t(*)[32])&siblings[32 * depth * p], &roots[32 * p]);
+    }
+    scalarRate = double(numberOfProofs) / secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> pairs(64 * numberOfProofs), digests(32 * numberOfProofs);
+    KangarooTwelveBatch(leaves.data(), 32, digests.data(), 32, numberOfProofs);
+    for (unsigned int level = 0; level < depth; level++)
+    {
+        for (size_t p = 0; p < numberOfProofs; p++)
+        {
+            // index p at level 0, the sibling is on the left for odd indices
+            bool siblingLeft = ((p >> level) & 1) != 0;
+            const uint8_t* sibling = &siblings[32 * (depth * p + level)];
+            memcpy(&pairs[64 * p], siblingLeft ? sibling : &digests[32 * p], 32);
+            memcpy(&pairs[64 * p + 32], siblingLeft ? &digests[32 * p] : sibling, 32);
+        }
+        KangarooTwelveBatch(pairs.data(), 64, digests.data(), 32, numberOfProofs);
+    }
+    batchRate = double(numberOfProofs) / secondsSince(start);
+    LOG("Merkle proofs: %14.0f %14.0f %7.2fx%s\n", scalarRate, batchRate, batchRate / scalarRate,
+        memcmp(roots.data(), digests.data(), roots.size()) == 0 ? "" : "  WRONG RESULT");
+}
+
+static void benchmarkK12Tree(const char* nodeIp, int nodePort, const char* parameter)
+{
+    const size_t maxSize = size_t(parameterOrDefault(parameter, 64)) << 20;
+    if (maxSize == 0)
+        return;
+    const int numberOfThreads = getNumberOfWorkerThreads(0);
+    LOG("Implementation: %s, worker threads: %d\n", getKangarooTwelveBatchImplementation(), numberOfThreads);
+    std::vector<uint8_t> input(std::max<size_t>(maxSize, 1 << 20));
+    for (size_t i = 0; i < input.size(); i++)
+        input[i] = uint8_t(i * 2654435761u >> 11);
+
+    // same results as KangarooTwelve() around the chunk boundaries
+    bool correct = true;
+    const size_t sizes[] = { 0, 8191, 8192, 8193, 16383, 16384, 16385, 8192 * 9 + 7, 8192 * 65, 8192 * 66 - 1, (1 << 20) + 3 };
+    for (size_t size : sizes)
+    {
+        for (unsigned int outputLength : { 32u, 64u })
+        {
+            uint8_t expected[64], output[64];
+            KangarooTwelve(input.data(), unsigned(size), expected, outputLength);
+            KangarooTwelveParallel(input.data(), size, output, outputLength);
+            if (memcmp(expected, output, outputLength) != 0)
+            {
+                LOG("WRONG RESULT for input length %zu, output length %u\n", size, outputLength);
+                correct = false;
+            }
+        }
+    }
+    if (correct)
+        LOG("Tree results equal KangarooTwelve()\n");
+
+    LOG("%12s %12s %14s %14s %8s\n", "input bytes", "scalar GB/s", "1 thread GB/s", "all GB/s", "speedup");
+    for (size_t size = 64 << 10; size <= maxSize; size *= 4)
+    {
+        // about 256 MB hashed per measurement
+        const size_t rounds = std::max<size_t>(1, (size_t(256) << 20) / size);
+        uint8_t digest[32];
+        auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; round++)
+            KangarooTwelve(input.data(), unsigned(size), digest, 32);
+        double scalarRate = double(rounds * size) / secondsSince(start) / 1e9;
+        start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; round++)
+            KangarooTwelveParallel(input.data(), size, digest, 32, 1);
+        double batchRate = double(rounds * size) / secondsSince(start) / 1e9;
+        start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; round++)
+            KangarooTwelveParallel(input.data(), size, digest, 32, numberOfThreads);
+        double parallelRate = double(rounds * size) / secondsSince(start) / 1e9;
+        LOG("%12zu %12.2f %14.2f %14.2f %7.2fx\n", size, scalarRate, batchRate, parallelRate, parallelRate / scalarRate);
+    }
+}
+
+static void benchmarkSign(const char* nodeIp, int nodePort, const char* parameter)
+{
+    const size_t count = size_t(parameterOrDefault(parameter, 4096));
+    if (count == 0)
+        return;
+    const char* seed = "benchmarkseedbenchmarkseedbenchmarkseedbenchmarkseedben";
+    const int numberOfThreads = getNumberOfWorkerThreads(0);
+    // transactions with 64 bytes of input, signed up to their signature
+    const size_t dataLength = sizeof(Transaction) + 64;
+    std::vector<uint8_t> data(dataLength * count);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = uint8_t(i * 2654435761u >> 9);
+    std::vector<uint8_t> expected(64 * count), signatures(64 * count);
+    std::vector<DataToSign> entries(count);
+    for (size_t i = 0; i < count; i++)
+        entries[i] = { &data[dataLength * i], dataLength, &signatures[64 * i] };
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+        signData(seed, &data[dataLength * i], dataLength, &expected[64 * i]);
+    double seedRate = double(count) / secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    Signer signer(seed);
+    for (size_t i = 0; i < count; i++)
+        signer.signData(&data[dataLength * i], dataLength, &signatures[64 * i]);
+    double signerRate = double(count) / secondsSince(start);
+    bool correct = (signatures == expected);
+
+    std::fill(signatures.begin(), signatures.end(), 0);
+    start = std::chrono::steady_clock::now();
+    signer.signBatch(entries, 1);
+    double batchRate = double(count) / secondsSince(start);
+    correct &= (signatures == expected);
+
+    std::fill(signatures.begin(), signatures.end(), 0);
+    start = std::chrono::steady_clock::now();
+    signer.signBatch(entries, numberOfThreads);
+    double parallelRate = double(count) / secondsSince(start);
+    correct &= (signatures == expected);
+
+    LOG("%-34s %14s %8s\n", "", "signatures/s", "speedup");
+    LOG("%-34s %14.0f %7.2fx\n", "signData() with seed", seedRate, 1.0);
+    LOG("%-34s %14.0f %7.2fx\n", "Signer::signData()", signerRate, signerRate / seedRate);
+    LOG("%-34s %14.0f %7.2fx\n", "Signer::signBatch(), 1 thread", batchRate, batchRate / seedRate);
+    char label[64];
+    snprintf(label, sizeof(label), "Signer::signBatch(), %d threads", numberOfThreads);
+    LOG("%-34s %14.0f %7.2fx\n", label, parallelRate, parallelRate / seedRate);
+    LOG("%s\n", correct ? "Signatures equal signData()" : "WRONG RESULT");
+}
+
+static void benchmarkIdentity(const char* nodeIp, int nodePort, const char* parameter)
+{
+    // a full spectrum by default, converted in chunks to keep the memory bounded
+    const size_t count = size_t(parameterOrDefault(parameter, 0x1000000));
+    const size_t chunkSize = 65536;
+    if (count == 0)
+        return;
+    std::vector<uint8_t> publicKeys(32 * chunkSize), decodedKeys(32 * chunkSize), valid(chunkSize);
+    std::vector<char> identities(61 * chunkSize);
+    double encodeSeconds = 0, batchEncodeSeconds = 0, decodeSeconds = 0, batchDecodeSeconds = 0;
+    bool correct = true;
+    for (size_t first = 0; first < count; first += chunkSize)
+    {
+        const size_t n = std::min(chunkSize, count - first);
+        KangarooTwelve((uint8_t*)&first, sizeof(first), publicKeys.data(), 32);
+        for (size_t i = 1; i < n; i++)
+        {
+            memcpy(&publicKeys[32 * i], &publicKeys[32 * (i - 1)], 32);
+            publicKeys[32 * i + (i % 32)] ^= uint8_t(i * 167);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++)
+            getIdentityFromPublicKey(&publicKeys[32 * i], &identities[61 * i], false);
+        encodeSeconds += secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        getIdentitiesFromPublicKeys(publicKeys.data(), n, identities.data(), false);
+        batchEncodeSeconds += secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++)
+        {
+            getPublicKeyFromIdentity(&identities[61 * i], &decodedKeys[32 * i]);
+            valid[i] = checkSumIdentity(&identities[61 * i]) ? 1 : 0;
+        }
+        decodeSeconds += secondsSince(start);
+        std::fill(decodedKeys.begin(), decodedKeys.end(), 0);
+        start = std::chrono::steady_clock::now();
+        size_t numberOfValid = getPublicKeysFromIdentities(identities.data(), n, decodedKeys.data(), valid.data());
+        batchDecodeSeconds += secondsSince(start);
+        correct &= (numberOfValid == n && memcmp(decodedKeys.data(), publicKeys.data(), 32 * n) == 0);
+    }
+    LOG("%zu identities\n", count);
+    LOG("%-28s %14s %14s %8s\n", "", "one by one/s", "batch/s", "speedup");
+    LOG("%-28s %14.0f %14.0f %7.2fx\n", "public key -> identity", count / encodeSeconds, count / batchEncodeSeconds, encodeSeconds / batchEncodeSeconds);
+    LOG("%-28s %14.0f %14.0f %7.2fx\n", "identity -> key + checksum", count / decodeSeconds, count / batchDecodeSeconds, decodeSeconds / batchDecodeSeconds);
+    LOG("%s\n", correct ? "All identities decode to their public key" : "WRONG RESULT");
+}
+
+static void benchmarkMerkleVerify(const char* nodeIp, int nodePort, const char* parameter)
+{
+    const size_t numberOfProofs = size_t(parameterOrDefault(parameter, 65536));
+    if (numberOfProofs == 0)
+        return;
+    // a full tree over the first 2^18 entities, the other subtrees of the spectrum are arbitrary digests
+    const unsigned int fullDepth = 18;
+    const size_t numberOfLeaves = size_t(1) << fullDepth;
+    std::vector<Entity> leaves(numberOfLeaves);
+    for (size_t i = 0; i < numberOfLeaves; i++)
+    {
+        memset(&leaves[i], 0, sizeof(Entity));
+        KangarooTwelve((uint8_t*)&i, sizeof(i), leaves[i].publicKey, 32);
+        leaves[i].incomingAmount = (long long)(i * 1000);
+        leaves[i].latestIncomingTransferTick = unsigned(i);
+    }
+    // levels[l] holds the nodes of level l, level 0 are the leaf digests
+    std::vector<std::vector<uint8_t>> levels(SPECTRUM_DEPTH + 1);
+    levels[0].resize(32 * numberOfLeaves);
+    KangarooTwelveBatch((const uint8_t*)leaves.data(), sizeof(Entity), levels[0].data(), 32, numberOfLeaves);
+    uint8_t otherSubtrees[SPECTRUM_DEPTH][32];
+    for (unsigned int level = 0; level < SPECTRUM_DEPTH; level++)
+    {
+        const size_t numberOfNodes = levels[level].size() / 32;
+        if (numberOfNodes > 1)
+        {
+            levels[level + 1].resize(levels[level].size() / 2);
+            KangarooTwelveBatch(levels[level].data(), 64, levels[level + 1].data(), 32, numberOfNodes / 2);
+        }
+        else
+        {
+            KangarooTwelve((uint8_t*)&level, sizeof(level), otherSubtrees[level], 32);
+            uint8_t pair[64];
+            memcpy(pair, levels[level].data(), 32);
+            memcpy(pair + 32, otherSubtrees[level], 32);
+            levels[level + 1].resize(32);
+            KangarooTwelve(pair, 64, levels[level + 1].data(), 32);
+        }
+    }
+    const uint8_t* root = levels[SPECTRUM_DEPTH].data();
+
+    // proofs of pseudo random entities, one of them wrong
+    std::vector<RespondedEntity> proofs(numberOfProofs);
+    for (size_t p = 0; p < numberOfProofs; p++)
+    {
+        size_t index = (p * 2654435761u) % numberOfLeaves;
+        RespondedEntity& proof = proofs[p];
+        proof.entity = leaves[index];
+        proof.spectrumIndex = int(index);
+        proof.tick = 1;
+        for (unsigned int level = 0; level < SPECTRUM_DEPTH; level++)
+        {
+            size_t position = index >> level;
+            if (level < fullDepth)
+                memcpy(proof.siblings[level], &levels[level][32 * (position ^ 1)], 32);
+            else
+                memcpy(proof.siblings[level], otherSubtrees[level], 32);
+        }
+    }
+    proofs[numberOfProofs / 2].entity.incomingAmount++;
+
+    std::vector<uint8_t> expected(numberOfProofs), valid(numberOfProofs);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t p = 0; p < numberOfProofs; p++)
+    {
+        uint8_t digest[32];
+        getSpectrumDigest(proofs[p], digest);
+        expected[p] = (memcmp(digest, root, 32) == 0) ? 1 : 0;
+    }
+    double singleRate = double(numberOfProofs) / secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    verifySpectrumProofs(proofs.data(), numberOfProofs, root, valid.data());
+    double batchRate = double(numberOfProofs) / secondsSince(start);
+    size_t numberOfValid = std::count(valid.begin(), valid.end(), 1);
+
+    LOG("%zu spectrum proofs of depth %u, %zu valid\n", numberOfProofs, SPECTRUM_DEPTH, numberOfValid);
+    LOG("%14s %14s %8s\n", "single/s", "batch/s", "speedup");
+    LOG("%14.0f %14.0f %7.2fx%s\n", singleRate, batchRate, batchRate / singleRate,
+        (valid == expected && numberOfValid == numberOfProofs - 1) ? "" : "  WRONG RESULT");
+}
+
+static const BenchmarkEntry benchmarks[] = {
+    { "batchverify", "[MAX_BATCH_SIZE] (default 1024), no node required", benchmarkBatchVerify },
+    { "compression", "[FILE] (default: generated 12 MB text file), no node required", benchmarkCompression },
+    { "connectionmemory", "[NUMBER_OF_CONNECTIONS] (default 32), requires node", benchmarkConnectionMemory },
+    { "identity", "[NUMBER_OF_IDENTITIES] (default 16777216, a full spectrum), no node required", benchmarkIdentity },
+    { "k12batch", "[NUMBER_OF_HASHES] (default 65536), no node required", benchmarkK12Batch },
+    { "k12tree", "[MAX_INPUT_SIZE_MB] (default 64), no node required", benchmarkK12Tree },
+    { "merkleverify", "[NUMBER_OF_PROOFS] (default 65536), no node required", benchmarkMerkleVerify },
+    { "sign", "[NUMBER_OF_SIGNATURES] (default 4096), no node required", benchmarkSign },
+    { "tickread", "[NUMBER_OF_TICKS] (default 16, 1024 transactions each), no node required", benchmarkTickRead },
+    { "tickverify", "[NUMBER_OF_TICKS] (default 16, 256 transactions each), no node required", benchmarkTickVerify },
+    { "tickwait", "[NUMBER_OF_WAITERS] (default 100), requires node", benchmarkTickWait },
+};
+
+void runBenchmark(const char* nodeIp, int nodePort, const char* name, const char* parameter)
+{
+    for (const auto& benchmark : benchmarks)
+    {
+        if (strcmp(benchmark.name, name) == 0)
+        {
+            LOG("Running benchmark %s\n", name);
+            benchmark.function(nodeIp, nodePort, parameter);
+            return;
+        }
+    }
+    LOG("Unknown benchmark %s. Available benchmarks:\n", name);
+    for (const auto& benchmark : benchmarks)
+        LOG("\t%s %s\n", benchmark.name, benchmark.parameterHelp);
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Run the benchmark called name. parameter is benchmark specific and may be empty (use the default).
+// An unknown name prints the list of available benchmarks.
+void runBenchmark(const char* nodeIp, int nodePort, const char* name, const char* parameter);
@@ -0,0 +1,85 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "buffer_pool.h"
+
+#define MIN_CLASS_SHIFT 12
+
+static int sizeClassOf(size_t size)
+{
+    int sizeClass = 0;
+    while ((size_t(1) << (sizeClass + MIN_CLASS_SHIFT)) < size)
+        sizeClass++;
+    return sizeClass;
+}
+
+BufferPool& BufferPool::shared()
+{
+    // never destroyed: connections held by other static objects may release their buffers during exit
+    static BufferPool* pool = new BufferPool();
+    return *pool;
+}
+
+uint8_t* BufferPool::acquire(size_t size, size_t& capacity)
+{
+    int sizeClass = sizeClassOf(size);
+    if (sizeClass >= numberOfClasses)
+        throw std::logic_error("Requested buffer exceeds maximum packet size.");
+    capacity = size_t(1) << (sizeClass + MIN_CLASS_SHIFT);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mFree[sizeClass].empty())
+        {
+            uint8_t* buffer = mFree[sizeClass].back();
+            mFree[sizeClass].pop_back();
+            mRetainedBytes -= capacity;
+            return buffer;
+        }
+    }
+    return new uint8_t[capacity];
+}
+
+void BufferPool::release(uint8_t* buffer, size_t capacity)
+{
+    if (!buffer)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mRetainedBytes + capacity <= maxRetainedBytes)
+        {
+            mFree[sizeClassOf(capacity)].push_back(buffer);
+            mRetainedBytes += capacity;
+            return;
+        }
+    }
+    delete[] buffer;
+}
+
+size_t BufferPool::retainedBytes()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mRetainedBytes;
+}
+
+uint8_t* PooledBuffer::reserve(size_t size)
+{
+    if (size <= mCapacity)
+        return mData;
+    size_t newCapacity;
+    uint8_t* newData = BufferPool::shared().acquire(size, newCapacity);
+    if (mData)
+    {
+        memcpy(newData, mData, mCapacity);
+        BufferPool::shared().release(mData, mCapacity);
+    }
+    mData = newData;
+    mCapacity = newCapacity;
+    return mData;
+}
+
+void PooledBuffer::reset()
+{
+    BufferPool::shared().release(mData, mCapacity);
+    mData = nullptr;
+    mCapacity = 0;
+}
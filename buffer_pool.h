@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Process-wide slab allocator for receive buffers. Buffers come in power-of-two size classes from 4 KB to 16 MB and
+// released buffers are kept on per-class free lists (up to a total retained size), so connections that are opened
+// and closed repeatedly reuse the same memory instead of allocating and page-faulting it again.
+// Thread safe.
+class BufferPool
+{
+public:
+    static BufferPool& shared();
+
+    // Return a buffer of at least size bytes. capacity is set to the actual size of the buffer.
+    uint8_t* acquire(size_t size, size_t& capacity);
+    void release(uint8_t* buffer, size_t capacity);
+
+    size_t retainedBytes();
+
+private:
+    static const int numberOfClasses = 13; // 4 KB .. 16 MB
+    static const size_t maxRetainedBytes = 64ULL << 20;
+
+    std::mutex mMutex;
+    std::vector<uint8_t*> mFree[numberOfClasses];
+    size_t mRetainedBytes = 0;
+};
+
+// Growable buffer backed by BufferPool. Starts empty and only grows to the largest size requested.
+class PooledBuffer
+{
+public:
+    PooledBuffer() : mData(nullptr), mCapacity(0) {}
+    ~PooledBuffer() { reset(); }
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    // Make sure the buffer holds at least size bytes. Content is preserved.
+    uint8_t* reserve(size_t size);
+
+    // Return the memory to the pool.
+    void reset();
+
+    uint8_t* data() { return mData; }
+    size_t capacity() const { return mCapacity; }
+
+private:
+    uint8_t* mData;
+    size_t mCapacity;
+};
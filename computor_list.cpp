@@ -0,0 +1,214 @@
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "computor_list.h"
+#include "connection.h"
+#include "logger.h"
+#include "node_utils.h"
+#include "request_pipeline.h"
+
+namespace
+{
+
+struct ComputorListCache
+{
+    std::mutex mutex;
+    std::map<uint16_t, std::shared_ptr<const ComputorList>> lists;
+    // lookups of epochs that are being read or fetched without the mutex, later callers wait for their result
+    std::map<uint16_t, std::shared_future<std::shared_ptr<const ComputorList>>> pending;
+};
+
+}
+
+ComputorList::ComputorList(const BroadcastComputors& list)
+    : broadcast(list), signedByArbitrator(isComputorListSignedByArbitrator(list))
+{
+    decodedKeys.add(&list.computors.publicKeys[0][0], NUMBER_OF_COMPUTORS);
+}
+
+static ComputorListCache& cache()
+{
+    // never destroyed: lists may be in use by other threads until exit
+    static ComputorListCache* instance = new ComputorListCache();
+    return *instance;
+}
+
+static std::string cacheFileName(uint16_t epoch)
+{
+    return std::string(COMPUTOR_LIST_CACHE_DIRECTORY) + "/" + std::to_string(epoch) + ".bin";
+}
+
+static bool readComputorListFile(const char* fileName, BroadcastComputors& result)
+{
+    FILE* f = fopen(fileName, "rb");
+    if (!f)
+        return false;
+    bool complete = (fread(&result, 1, sizeof(BroadcastComputors), f) == sizeof(BroadcastComputors));
+    fclose(f);
+    return complete;
+}
+
+// Like getComputorFromNode(), without printing errors.
+static bool fetchComputorList(const char* nodeIp, int nodePort, BroadcastComputors& result)
+{
+    try
+    {
+        QubicRequestPipeline pipeline(make_qc(nodeIp, nodePort));
+        struct
+        {
+            RequestResponseHeader header;
+        } packet;
+        packet.header.setSize(sizeof(packet));
+        packet.header.setType(REQUEST_COMPUTORS);
+        result = pipeline.submitAs<BroadcastComputors>((uint8_t*)&packet, sizeof(packet)).get();
+        return true;
+    }
+    catch (const std::logic_error&)
+    {
+        return false;
+    }
+}
+
+// Keep a signed list in memory, unless its epoch is cached already. Return whether it was added, then the caller saves
+// it with saveComputorList() after releasing the cache mutex, which must be held.
+static bool insertLocked(const std::shared_ptr<const ComputorList>& list)
+{
+    auto& cached = cache().lists[list->broadcast.computors.epoch];
+    if (cached)
+        return false;
+    cached = list;
+    return true;
+}
+
+// Save a list to the cache directory. It is written to a temporary file first, so that a reader never sees a partial
+// list. A list that cannot be saved is fetched again by the next command.
+static void saveComputorList(const ComputorList& list)
+{
+    const std::string fileName = cacheFileName(list.broadcast.computors.epoch);
+    const std::string tempFileName = fileName + ".tmp";
+    std::error_code error;
+    std::filesystem::create_directories(COMPUTOR_LIST_CACHE_DIRECTORY, error);
+    FILE* f = fopen(tempFileName.c_str(), "wb");
+    if (!f)
+        return;
+    bool complete = (fwrite(&list.broadcast, 1, sizeof(BroadcastComputors), f) == sizeof(BroadcastComputors));
+    complete = (fclose(f) == 0) && complete;
+    if (complete)
+        std::filesystem::rename(tempFileName, fileName, error);
+    if (!complete || error)
+        std::filesystem::remove(tempFileName, error);
+}
+
+// Read the list of epoch from the cache directory, or else fetch it from the node. A fetched list of another epoch is
+// returned as well, so that it can be cached.
+static std::shared_ptr<const ComputorList> readOrFetchComputorList(const char* nodeIp, int nodePort, uint16_t epoch, bool& fromFile)
+{
+    BroadcastComputors list;
+    fromFile = false;
+    if (readComputorListFile(cacheFileName(epoch).c_str(), list) && list.computors.epoch == epoch)
+    {
+        auto result = std::make_shared<const ComputorList>(list);
+        fromFile = result->signedByArbitrator;
+        if (fromFile)
+            return result;
+    }
+    if (!fetchComputorList(nodeIp, nodePort, list) || !isComputorListSignedByArbitrator(list))
+        return nullptr;
+    return std::make_shared<const ComputorList>(list);
+}
+
+std::shared_ptr<const ComputorList> getCachedComputorList(const char* nodeIp, int nodePort, uint16_t epoch)
+{
+    // the mutex is not held while the list is read or fetched, only one caller does that per epoch
+    std::promise<std::shared_ptr<const ComputorList>> promise;
+    {
+        std::unique_lock<std::mutex> lock(cache().mutex);
+        auto found = cache().lists.find(epoch);
+        if (found != cache().lists.end())
+            return found->second;
+        auto inProgress = cache().pending.find(epoch);
+        if (inProgress != cache().pending.end())
+        {
+            auto result = inProgress->second;
+            lock.unlock();
+            return result.get();
+        }
+        cache().pending[epoch] = promise.get_future().share();
+    }
+
+    bool fromFile = false;
+    auto list = readOrFetchComputorList(nodeIp, nodePort, epoch, fromFile);
+    // the list of another epoch is kept as well, it is the one the next command most likely needs
+    auto result = (list && list->broadcast.computors.epoch == epoch) ? list : nullptr;
+    bool inserted = false;
+    {
+        std::lock_guard<std::mutex> lock(cache().mutex);
+        if (fromFile)
+            cache().lists[epoch] = list;
+        else if (list)
+            inserted = insertLocked(list);
+        cache().pending.erase(epoch);
+    }
+    promise.set_value(result);
+    if (inserted)
+        saveComputorList(*list);
+    return result;
+}
+
+bool addComputorListToCache(const BroadcastComputors& list)
+{
+    if (!isComputorListSignedByArbitrator(list))
+        return false;
+    auto result = std::make_shared<const ComputorList>(list);
+    bool inserted;
+    {
+        std::lock_guard<std::mutex> lock(cache().mutex);
+        inserted = insertLocked(result);
+    }
+    if (inserted)
+        saveComputorList(*result);
+    return true;
+}
+
+std::shared_ptr<const ComputorList> loadComputorList(const char* argument, const char* nodeIp, int nodePort, uint16_t epoch)
+{
+    if (strcmp(argument, "-") == 0)
+    {
+        auto result = getCachedComputorList(nodeIp, nodePort, epoch);
+        if (result)
+            LOG("Computor list of epoch %u is VERIFIED (signed by ARBITRATOR)\n", epoch);
+        else
+            LOG("Failed to get the computor list of epoch %u signed by ARBITRATOR from %s/ or %s:%d\n", epoch,
+                COMPUTOR_LIST_CACHE_DIRECTORY, nodeIp, nodePort);
+        return result;
+    }
+
+    BroadcastComputors list;
+    if (!readComputorListFile(argument, list))
+    {
+        LOG("Failed to read comp list %s\n", argument);
+        return nullptr;
+    }
+    auto result = std::make_shared<const ComputorList>(list);
+    if (result->signedByArbitrator)
+    {
+        LOG("Computor list is VERIFIED (signed by ARBITRATOR)\n");
+        bool inserted;
+        {
+            std::lock_guard<std::mutex> lock(cache().mutex);
+            inserted = insertLocked(result);
+        }
+        if (inserted)
+            saveComputorList(*result);
+    }
+    else
+    {
+        LOG("Computor list is NOT verified\n");
+    }
+    return result;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "batch_verify.h"
+#include "structs.h"
+
+// Directory of the on-disk computor list cache, relative to the working directory. It holds one file per epoch
+// (<EPOCH>.bin, in the format of -getcomputorlist). Only lists signed by the arbitrator are cached.
+#define COMPUTOR_LIST_CACHE_DIRECTORY "computor_lists"
+
+// A computor list with its public keys decoded for verifySignatures().
+struct ComputorList
+{
+    explicit ComputorList(const BroadcastComputors& list);
+
+    BroadcastComputors broadcast;
+    bool signedByArbitrator;
+    DecodedPublicKeys decodedKeys;
+};
+
+// The computor list of epoch signed by the arbitrator, looked up in memory, then in the cache directory and only then
+// requested from the node (which has the list of its current epoch only). A list fetched from the node is verified and
+// cached, so it is fetched once per epoch. Return nullptr if there is no signed list of the epoch, printing nothing.
+// Thread safe.
+std::shared_ptr<const ComputorList> getCachedComputorList(const char* nodeIp, int nodePort, uint16_t epoch);
+
+// Add a list to the cache, in memory and on disk, if it is signed by the arbitrator. Return whether it is signed.
+bool addComputorListToCache(const BroadcastComputors& list);
+
+// The list named by a computor list argument of a command: "-" for the cached list of epoch (see
+// getCachedComputorList()), anything else is a file written by -getcomputorlist. A file is used even if it is not
+// signed by the arbitrator, a signed one is added to the cache. Print whether the list is verified, or why there is
+// none (then return nullptr).
+std::shared_ptr<const ComputorList> loadComputorList(const char* argument, const char* nodeIp, int nodePort, uint16_t epoch);
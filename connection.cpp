@@ -7,6 +7,7 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <sys/select.h>
 #include <unistd.h>
 #endif
 #include <cstring>
@@ -29,6 +30,7 @@
 #include "qutil.h"
 
 #define DEFAULT_TIMEOUT_MSEC 1000
+#define SKIP_CHUNK_SIZE 65536
 
 #ifdef _MSC_VER
 
@@ -117,14 +119,8 @@ QubicConnection::QubicConnection(const char* nodeIp, int nodePort)
 	memset(mNodeIp, 0, 32);
 	memcpy(mNodeIp, nodeIp, strlen(nodeIp));
 	mNodePort = nodePort;
-	mSocket = connect(nodeIp, nodePort);
-    if (mSocket < 0)
-        throw std::logic_error("Unable to establish connection.");
-
-    // receive handshake - exchange peer packets
-    mHandshakeData.resize(sizeof(ExchangePublicPeers));
-    uint8_t* data = mHandshakeData.data();
-    *((ExchangePublicPeers*)data) = receivePacketWithHeaderAs<ExchangePublicPeers>();
+    mSocket = -1;
+    resolveConnection();
 
     // If node has no ComputorList or a self-generated ComputorList it will requestComputor upon tcp initialization
     // Ignore this message if it is here
@@ -132,7 +128,7 @@ QubicConnection::QubicConnection(const char* nodeIp, int nodePort)
     setTimeout(mSocket, SO_RCVTIMEO, DEFAULT_TIMEOUT_MSEC / 5);
     try
     {
-        *((RequestComputors*)data) = receivePacketWithHeaderAs<RequestComputors>();
+        receivePacketWithHeaderAs<RequestComputors>();
     }
     catch(std::logic_error) {}
     setTimeout(mSocket, SO_RCVTIMEO, DEFAULT_TIMEOUT_MSEC);
@@ -145,7 +141,8 @@ void QubicConnection::getHandshakeData(std::vector<uint8_t>& buffer)
 
 QubicConnection::~QubicConnection()
 {
-	close(mSocket);
+    if (mSocket >= 0)
+	    close(mSocket);
 }
 
 // Receive the requested number of bytes (sz) or less if sz bytes have not been received after timeout. Return number of received bytes.
@@ -176,6 +173,11 @@ int QubicConnection::receiveData(uint8_t* buffer, int sz)
     return totalRecvSz;
 }
 
+int QubicConnection::receiveSome(uint8_t* buffer, int sz)
+{
+    return recv(mSocket, (char*)buffer, sz, 0);
+}
+
 int QubicConnection::receiveAllDataOrThrowException(uint8_t* buffer, int sz)
 {
     int recvSz = receiveData(buffer, sz);
@@ -186,11 +188,58 @@ int QubicConnection::receiveAllDataOrThrowException(uint8_t* buffer, int sz)
     return recvSz;
 }
 
+void QubicConnection::skipData(int sz)
+{
+    uint8_t* buffer = mReceiveBuffer.reserve((sz < SKIP_CHUNK_SIZE) ? sz : SKIP_CHUNK_SIZE);
+    while (sz > 0)
+    {
+        int chunkSize = (sz < SKIP_CHUNK_SIZE) ? sz : SKIP_CHUNK_SIZE;
+        receiveAllDataOrThrowException(buffer, chunkSize);
+        sz -= chunkSize;
+    }
+}
+
 void QubicConnection::resolveConnection()
 {
+    if (mSocket >= 0)
+        close(mSocket);
     mSocket = connect(mNodeIp, mNodePort);
     if (mSocket < 0)
         throw std::logic_error("Unable to establish connection.");
+
+    // receive handshake - exchange peer packets
+    mHandshakeData.resize(sizeof(ExchangePublicPeers));
+    *((ExchangePublicPeers*)mHandshakeData.data()) = receivePacketWithHeaderAs<ExchangePublicPeers>();
+}
+
+bool QubicConnection::waitForData(int timeoutMsec)
+{
+    if (mSocket < 0)
+        return false;
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(mSocket, &readSet);
+    timeval timeout;
+    timeout.tv_sec = timeoutMsec / 1000;
+    timeout.tv_usec = (timeoutMsec % 1000) * 1000;
+    return select(mSocket + 1, &readSet, nullptr, nullptr, &timeout) > 0;
+}
+
+bool QubicConnection::isHealthy()
+{
+    if (mSocket < 0)
+        return false;
+
+    // A healthy idle connection has nothing to read: readability means either the peer closed the connection
+    // (recv returns 0), an error occurred, or unread data from a previous request is pending, which would
+    // desynchronize the next response.
+    if (!waitForData(0))
+        return true;
+    char byte;
+    int peekSz = recv(mSocket, &byte, 1, MSG_PEEK);
+    if (peekSz > 0)
+        LOG("Connection to %s:%d has unread data, it will not be reused\n", mNodeIp, mNodePort);
+    return false;
 }
 
 // Receive the next qubic packet with a RequestResponseHeader that matches T
@@ -216,7 +265,7 @@ T QubicConnection::receivePacketWithHeaderAs()
             // skip this packet and keep receiving
             packetSize = header.size();
             remainingSize = packetSize - sizeof(RequestResponseHeader);
-            receiveAllDataOrThrowException(mBuffer, remainingSize);
+            skipData(remainingSize);
             continue;
         }
         break;
@@ -228,9 +277,11 @@ T QubicConnection::receivePacketWithHeaderAs()
     memset(&result, 0, sizeof(T));
     if (remainingSize)
     {
-        memset(mBuffer, 0, sizeof(T));
-        receiveAllDataOrThrowException(mBuffer, remainingSize);
-        result = *((T*)mBuffer);
+        // decode straight into the result, a shorter payload leaves the rest zeroed and excess data is dropped
+        int directSize = (remainingSize < int(sizeof(T))) ? remainingSize : int(sizeof(T));
+        receiveAllDataOrThrowException((uint8_t*)&result, directSize);
+        if (remainingSize > directSize)
+            skipData(remainingSize - directSize);
     }
     return result;
 }
@@ -242,12 +293,11 @@ T QubicConnection::receivePacketAs()
     int packetSize = sizeof(T);
     T result;
     memset(&result, 0, sizeof(T));
-    int recvByte = receiveData(mBuffer, packetSize);
+    int recvByte = receiveData((uint8_t*)&result, packetSize);
     if (recvByte != packetSize)
     {
         throw std::logic_error("Unexpected data size.");
     }
-    result = *((T*)mBuffer);
     return result;
 }
 
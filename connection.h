@@ -5,6 +5,8 @@
 #include <memory>
 #include <stdexcept>
 
+#include "buffer_pool.h"
+
 // Not thread safe
 class QubicConnection
 {
@@ -12,14 +14,28 @@ public:
 	QubicConnection(const char* nodeIp, int nodePort);
 	~QubicConnection();
 
-    // Establish connection to mNodePort on node mNodeIp. 
+    // Establish connection to mNodePort on node mNodeIp.
+    // Any previously open socket is closed first and the handshake is received again.
     // May throw std::logic_error.
     void resolveConnection();
 
+    // Wait until data is available for reading (or the connection was closed). Return false on timeout.
+    bool waitForData(int timeoutMsec);
+
+    // Check without blocking that the connection is still open and has no unread data pending.
+    bool isHealthy();
+
+    const char* getNodeIp() const { return mNodeIp; }
+    int getNodePort() const { return mNodePort; }
+
     // Receive at most sz bytes and write them to buffer. Return the actual number of received bytes.
     // Should only return less than sz bytes on timeout, closed connection, or error.
 	int receiveData(uint8_t* buffer, int sz);
 
+    // Receive whatever is available (at least 1 byte, at most sz bytes), waiting up to the socket timeout.
+    // Return the number of received bytes, 0 or less on timeout, closed connection, or error.
+    int receiveSome(uint8_t* buffer, int sz);
+
     // Receive sz bytes and write them to buffer. Throws std::logic_error if sz bytes cannot be read. 
     int receiveAllDataOrThrowException(uint8_t* buffer, int sz);
 
@@ -40,19 +56,24 @@ public:
     // Receive vector data of Ts where each T is preceeded by a header.
     template <typename T> std::vector<T> getLatestVectorPacketAs();
 private:
+    // Receive and drop sz bytes.
+    void skipData(int sz);
+
 	char mNodeIp[32];
 	int mNodePort;
 	int mSocket;
-    uint8_t mBuffer[0xFFFFFF];
+    PooledBuffer mReceiveBuffer; // grows on demand, only used for data that is not decoded into the caller's type
     std::vector<uint8_t> mHandshakeData; // storing handshake data after open a connection
 };
 
 typedef std::shared_ptr<QubicConnection> QCPtr;
 
-static QCPtr make_qc(const char* nodeIp, int nodePort)
-{
-    return std::make_shared<QubicConnection>(nodeIp, nodePort);
-}
+// Payload of one received packet, without RequestResponseHeader.
+typedef std::vector<uint8_t> PacketPayload;
+
+// Get a connection to the node, reusing an idle pooled connection if possible (see connection_pool.h).
+// May throw std::logic_error.
+QCPtr make_qc(const char* nodeIp, int nodePort);
 
 class EndResponseReceived : public std::runtime_error
 {
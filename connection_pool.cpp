@@ -0,0 +1,161 @@
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "connection_pool.h"
+
+#define DEFAULT_MAX_IDLE_PER_NODE 8
+#define DEFAULT_MAX_IDLE_TIME_MSEC 60000
+
+struct IdleConnection
+{
+    QubicConnection* connection;
+    std::chrono::steady_clock::time_point releaseTime;
+};
+
+struct QubicConnectionPool::State
+{
+    std::mutex mutex;
+    std::map<std::string, std::vector<IdleConnection>> idle;
+    size_t maxIdlePerNode = DEFAULT_MAX_IDLE_PER_NODE;
+    long long maxIdleTimeMs = DEFAULT_MAX_IDLE_TIME_MSEC;
+    size_t created = 0;
+    size_t reused = 0;
+    size_t reconnected = 0;
+
+    ~State()
+    {
+        for (auto& node : idle)
+            for (auto& entry : node.second)
+                delete entry.connection;
+    }
+};
+
+static std::string poolKey(const char* nodeIp, int nodePort)
+{
+    return std::string(nodeIp) + ":" + std::to_string(nodePort);
+}
+
+QubicConnectionPool::QubicConnectionPool() : mState(std::make_shared<State>())
+{
+}
+
+QubicConnectionPool& QubicConnectionPool::instance()
+{
+    static QubicConnectionPool pool;
+    return pool;
+}
+
+QCPtr QubicConnectionPool::acquire(const char* nodeIp, int nodePort)
+{
+    QubicConnection* connection = nullptr;
+    bool expired = false;
+    {
+        std::lock_guard<std::mutex> lock(mState->mutex);
+        auto it = mState->idle.find(poolKey(nodeIp, nodePort));
+        if (it != mState->idle.end() && !it->second.empty())
+        {
+            // most recently released connection first, it is the most likely to still be alive
+            IdleConnection entry = it->second.back();
+            it->second.pop_back();
+            connection = entry.connection;
+            auto idleMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - entry.releaseTime).count();
+            expired = idleMs > mState->maxIdleTimeMs;
+        }
+    }
+
+    // Called when the last QCPtr to the connection is released. The pool state is only weakly referenced, so
+    // connections outliving the pool are simply closed.
+    std::weak_ptr<State> weakState = mState;
+    auto deleter = [weakState](QubicConnection* c)
+    {
+        auto state = weakState.lock();
+        if (state)
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            auto& idle = state->idle[poolKey(c->getNodeIp(), c->getNodePort())];
+            if (idle.size() < state->maxIdlePerNode)
+            {
+                idle.push_back({ c, std::chrono::steady_clock::now() });
+                return;
+            }
+        }
+        delete c;
+    };
+    if (connection)
+    {
+        if (expired || !connection->isHealthy())
+        {
+            try
+            {
+                connection->resolveConnection();
+            }
+            catch (std::logic_error&)
+            {
+                delete connection;
+                throw;
+            }
+            std::lock_guard<std::mutex> lock(mState->mutex);
+            mState->reconnected++;
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(mState->mutex);
+            mState->reused++;
+        }
+        return QCPtr(connection, deleter);
+    }
+
+    connection = new QubicConnection(nodeIp, nodePort);
+    {
+        std::lock_guard<std::mutex> lock(mState->mutex);
+        mState->created++;
+    }
+    return QCPtr(connection, deleter);
+}
+
+void QubicConnectionPool::setMaxIdlePerNode(size_t maxIdle)
+{
+    std::lock_guard<std::mutex> lock(mState->mutex);
+    mState->maxIdlePerNode = maxIdle;
+}
+
+void QubicConnectionPool::setMaxIdleTimeMs(long long maxIdleTimeMs)
+{
+    std::lock_guard<std::mutex> lock(mState->mutex);
+    mState->maxIdleTimeMs = maxIdleTimeMs;
+}
+
+void QubicConnectionPool::clear()
+{
+    std::vector<QubicConnection*> toClose;
+    {
+        std::lock_guard<std::mutex> lock(mState->mutex);
+        for (auto& node : mState->idle)
+            for (auto& entry : node.second)
+                toClose.push_back(entry.connection);
+        mState->idle.clear();
+    }
+    for (auto connection : toClose)
+        delete connection;
+}
+
+QubicConnectionPool::Stats QubicConnectionPool::getStats()
+{
+    std::lock_guard<std::mutex> lock(mState->mutex);
+    Stats stats;
+    stats.created = mState->created;
+    stats.reused = mState->reused;
+    stats.reconnected = mState->reconnected;
+    stats.idle = 0;
+    for (auto& node : mState->idle)
+        stats.idle += node.second.size();
+    return stats;
+}
+
+QCPtr make_qc(const char* nodeIp, int nodePort)
+{
+    return QubicConnectionPool::instance().acquire(nodeIp, nodePort);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "connection.h"
+
+// Keeps handshaken connections to nodes open between requests, keyed by node ip and port.
+// A connection handed out by acquire() returns to the pool when the last QCPtr referencing it is released.
+// Before an idle connection is handed out again it is health-checked and transparently reconnected if the node
+// closed it, if it has been idle for too long, or if unread data from a previous request is pending.
+// Thread safe.
+class QubicConnectionPool
+{
+public:
+    struct Stats
+    {
+        size_t created;
+        size_t reused;
+        size_t reconnected;
+        size_t idle;
+    };
+
+    QubicConnectionPool();
+
+    // Process-wide pool used by make_qc().
+    static QubicConnectionPool& instance();
+
+    // Get a connection to the node. May throw std::logic_error.
+    QCPtr acquire(const char* nodeIp, int nodePort);
+
+    // Maximum number of idle connections kept per node. Connections released beyond that are closed.
+    void setMaxIdlePerNode(size_t maxIdle);
+
+    // Idle connections older than this are reconnected before reuse (catches half-open TCP connections).
+    void setMaxIdleTimeMs(long long maxIdleTimeMs);
+
+    // Close all idle connections.
+    void clear();
+
+    Stats getStats();
+
+private:
+    struct State;
+    std::shared_ptr<State> mState;
+};
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <future>
+
+#include "csv_export.h"
+#include "logger.h"
+#include "parallel.h"
+
+// ranges formatted per thread before they are written, the next batch is formatted while this one is written
+#define RANGES_PER_THREAD 4
+// initial size of a range buffer, grows to the largest range and is reused
+#define RANGE_BUFFER_SIZE (1 << 20)
+
+void CsvRows::reserve(size_t size)
+{
+    if (size > mData.size())
+        mData.resize(std::max(size, 2 * mData.size()));
+}
+
+CsvRows& CsvRows::text(const char* text, size_t length)
+{
+    if (mSize + length > mData.size())
+        reserve(mSize + length);
+    memcpy(&mData[mSize], text, length);
+    mSize += length;
+    return *this;
+}
+
+CsvRows& CsvRows::name(const char* text, size_t maxLength)
+{
+    size_t length = 0;
+    while (length < maxLength && text[length])
+        length++;
+    return this->text(text, length);
+}
+
+CsvRows& CsvRows::unsignedNumber(uint64_t value)
+{
+    char digits[20];
+    char* p = digits + sizeof(digits);
+    do
+    {
+        *--p = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+    return text(p, digits + sizeof(digits) - p);
+}
+
+CsvRows& CsvRows::number(int64_t value)
+{
+    if (value < 0)
+    {
+        character('-');
+        return unsignedNumber(0 - uint64_t(value));
+    }
+    return unsignedNumber(uint64_t(value));
+}
+
+bool exportCsv(const char* fileName, const char* header, size_t numberOfItems, size_t rangeSize,
+               const CsvRangeFormatter& format, int numberOfThreads)
+{
+    FILE* f = fopen(fileName, "w");
+    if (!f)
+    {
+        LOG("Failed to open %s\n", fileName);
+        return false;
+    }
+    fwrite(header, 1, strlen(header), f);
+
+    auto start = std::chrono::steady_clock::now();
+    numberOfThreads = getNumberOfWorkerThreads(numberOfThreads);
+    const size_t numberOfRanges = (numberOfItems + rangeSize - 1) / rangeSize;
+    const size_t rangesPerBatch = size_t(numberOfThreads) * RANGES_PER_THREAD;
+    std::vector<CsvRows> buffers[2];
+    for (auto& batch : buffers)
+    {
+        batch.resize(rangesPerBatch);
+        for (auto& rows : batch)
+            rows.reserve(RANGE_BUFFER_SIZE);
+    }
+    std::future<bool> writing;
+    bool ok = true;
+    size_t numberOfRows = 0;
+    for (size_t firstRange = 0, batch = 0; firstRange < numberOfRanges; firstRange += rangesPerBatch, batch ^= 1)
+    {
+        std::vector<CsvRows>& ranges = buffers[batch];
+        const size_t count = std::min(rangesPerBatch, numberOfRanges - firstRange);
+        parallelFor(count, numberOfThreads, [&](size_t i)
+        {
+            const size_t first = (firstRange + i) * rangeSize;
+            ranges[i].clear();
+            format(first, std::min(rangeSize, numberOfItems - first), ranges[i]);
+        });
+        if (writing.valid())
+            ok = writing.get() && ok;
+        for (size_t i = 0; i < count; i++)
+            numberOfRows += ranges[i].numberOfRows();
+        writing = std::async(std::launch::async, [f, &ranges, count]()
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                if (fwrite(ranges[i].data(), 1, ranges[i].size(), f) != ranges[i].size())
+                    return false;
+            }
+            return true;
+        });
+    }
+    if (writing.valid())
+        ok = writing.get() && ok;
+    ok = (fclose(f) == 0) && ok;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!ok)
+    {
+        LOG("Failed to write %s\n", fileName);
+        return false;
+    }
+    LOG("Wrote %zu rows to %s in %.2f s (%.0f rows/s), worker threads: %d\n", numberOfRows, fileName, seconds,
+        seconds > 0 ? numberOfRows / seconds : 0.0, numberOfThreads);
+    return true;
+}
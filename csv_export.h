@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Rows of one range of a CSV export. Fields are appended to a byte buffer that keeps its capacity between ranges,
+// so formatting a row allocates nothing. Fields are not quoted, callers only write numbers, identities and names.
+class CsvRows
+{
+public:
+    CsvRows() : mSize(0), mNumberOfRows(0) {}
+
+    void clear() { mSize = 0; mNumberOfRows = 0; }
+    void reserve(size_t size);
+
+    CsvRows& text(const char* text, size_t length);
+    // Up to maxLength characters of text, stops at the first zero byte (for fixed-size name fields).
+    CsvRows& name(const char* text, size_t maxLength);
+    CsvRows& number(int64_t value);
+    CsvRows& unsignedNumber(uint64_t value);
+    CsvRows& comma() { return character(','); }
+    void endRow() { character('\n'); mNumberOfRows++; }
+
+    const char* data() const { return mData.data(); }
+    size_t size() const { return mSize; }
+    size_t numberOfRows() const { return mNumberOfRows; }
+
+    // Scratch buffers for the formatter of a range. They are not cleared, their capacity is reused between ranges.
+    std::vector<size_t>& indices() { return mIndices; }
+    std::vector<uint8_t>& publicKeys() { return mPublicKeys; }
+    std::vector<char>& identities() { return mIdentities; }
+
+private:
+    CsvRows& character(char c)
+    {
+        if (mSize == mData.size())
+            reserve(mSize + 1);
+        mData[mSize++] = c;
+        return *this;
+    }
+
+    std::vector<char> mData; // capacity, the first mSize bytes are used
+    size_t mSize;
+    size_t mNumberOfRows;
+    std::vector<size_t> mIndices;
+    std::vector<uint8_t> mPublicKeys;
+    std::vector<char> mIdentities;
+};
+
+// Format the rows of items [first, first + count) into rows. Called concurrently for different ranges.
+typedef std::function<void(size_t first, size_t count, CsvRows& rows)> CsvRangeFormatter;
+
+// Write header and the rows of items [0, numberOfItems) to fileName. Items are split into ranges of rangeSize that
+// are formatted on numberOfThreads threads (0 = one per core) and written in order, while the next ranges are
+// formatted. Print the number of rows and the throughput. Return false if the file cannot be written.
+bool exportCsv(const char* fileName, const char* header, size_t numberOfItems, size_t rangeSize,
+               const CsvRangeFormatter& format, int numberOfThreads = 0);
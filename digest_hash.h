@@ -0,0 +1,23 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// KangarooTwelve digests are uniformly distributed, their first bytes are a good hash.
+static inline uint64_t hashOfDigest(const uint8_t* digest)
+{
+    uint64_t hash;
+    memcpy(&hash, digest, sizeof(hash));
+    return hash;
+}
+
+// Hash of digests used as keys of unordered containers.
+struct DigestHash
+{
+    size_t operator()(const std::array<uint8_t, 32>& digest) const
+    {
+        return size_t(hashOfDigest(digest.data()));
+    }
+};
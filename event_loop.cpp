@@ -0,0 +1,524 @@
+#ifdef _MSC_VER
+#include <Winsock2.h>
+#include <Ws2tcpip.h>
+#define close(x) closesocket(x)
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <cerrno>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#endif
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "event_loop.h"
+#include "defines.h"
+#include "structs.h"
+
+// initial size of the receive buffer of a connection, also the least free space a recv is given
+#define RECEIVE_CHUNK_SIZE 65536
+#define MAX_EVENTS_PER_WAIT 256
+
+#if defined(__linux__)
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+static bool setNonBlocking(int socketFd)
+{
+#ifdef _MSC_VER
+    u_long mode = 1;
+    return ioctlsocket(socketFd, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(socketFd, F_GETFL, 0);
+    return flags >= 0 && fcntl(socketFd, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static bool lastErrorIsWouldBlock()
+{
+#ifdef _MSC_VER
+    int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS;
+#endif
+}
+
+QubicEventLoop::QubicEventLoop() : mNextConnectionId(0), mPollFd(-1)
+{
+#ifdef _MSC_VER
+    WSADATA wsa_data;
+    WSAStartup(MAKEWORD(2, 0), &wsa_data);
+#endif
+#ifdef __linux__
+    mPollFd = epoll_create1(0);
+    if (mPollFd < 0)
+        throw std::logic_error("Unable to create epoll instance.");
+#endif
+}
+
+QubicEventLoop::~QubicEventLoop()
+{
+    for (auto& it : mConnections)
+    {
+        if (!it.second.closed)
+            close(it.second.socket);
+    }
+#ifdef __linux__
+    close(mPollFd);
+#endif
+}
+
+int QubicEventLoop::addConnection(const char* nodeIp, int nodePort, int connectTimeoutMsec)
+{
+    sockaddr_in addr;
+    memset((char*)&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(nodePort);
+    if (inet_pton(AF_INET, nodeIp, &addr.sin_addr) <= 0)
+        return -1;
+
+    int socketFd = int(socket(AF_INET, SOCK_STREAM, 0));
+    if (socketFd < 0)
+        return -1;
+    if (!setNonBlocking(socketFd))
+    {
+        close(socketFd);
+        return -1;
+    }
+    if (connect(socketFd, (const sockaddr*)&addr, sizeof(addr)) < 0 && !lastErrorIsWouldBlock())
+    {
+        close(socketFd);
+        return -1;
+    }
+
+    int id = mNextConnectionId++;
+    Connection& connection = mConnections[id];
+    connection.id = id;
+    connection.socket = socketFd;
+    connection.connecting = true;
+    connection.handshaking = true;
+    connection.closed = false;
+    connection.wantWrite = true;
+    connection.connectDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(connectTimeoutMsec);
+    connection.sendOffset = 0;
+    connection.recvBuffer.resize(RECEIVE_CHUNK_SIZE);
+    connection.recvOffset = 0;
+    connection.recvSize = 0;
+#ifdef __linux__
+    epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.u64 = uint64_t(id);
+    if (epoll_ctl(mPollFd, EPOLL_CTL_ADD, socketFd, &event) != 0)
+    {
+        close(socketFd);
+        mConnections.erase(id);
+        return -1;
+    }
+#endif
+    return id;
+}
+
+void QubicEventLoop::setPacketHandler(int connectionId, PacketCallback handler)
+{
+    auto it = mConnections.find(connectionId);
+    if (it != mConnections.end())
+        it->second.packetHandler = handler;
+}
+
+bool QubicEventLoop::getHandshakeData(int connectionId, std::vector<uint8_t>& buffer)
+{
+    auto it = mConnections.find(connectionId);
+    if (it == mConnections.end() || it->second.handshaking)
+        return false;
+    buffer = it->second.handshakeData;
+    return true;
+}
+
+void QubicEventLoop::submit(int connectionId, const uint8_t* packet, int packetSize, unsigned char responseType, bool untilEndResponse,
+    int timeoutMsec, ResponseCallback callback)
+{
+    auto it = mConnections.find(connectionId);
+    if (it == mConnections.end() || it->second.closed)
+    {
+        EventLoopResponse response;
+        response.ok = false;
+        response.error = "No connection.";
+        response.latencyMsec = 0;
+        mDeferred.push_back([callback, response]() mutable { callback(response); });
+        return;
+    }
+    Connection& connection = it->second;
+
+    size_t offset = connection.sendBuffer.size();
+    connection.sendBuffer.insert(connection.sendBuffer.end(), packet, packet + packetSize);
+    RequestResponseHeader& header = (RequestResponseHeader&)connection.sendBuffer[offset];
+    do
+    {
+        header.randomizeDejavu();
+    } while (connection.pending.count(header.dejavu()));
+
+    Request& request = connection.pending[header.dejavu()];
+    request.responseType = responseType;
+    request.untilEndResponse = untilEndResponse;
+    request.start = std::chrono::steady_clock::now();
+    request.deadline = request.start + std::chrono::milliseconds(timeoutMsec);
+    request.callback = callback;
+    updateInterest(connection);
+}
+
+void QubicEventLoop::closeConnection(int connectionId)
+{
+    auto it = mConnections.find(connectionId);
+    if (it == mConnections.end())
+        return;
+    failConnection(it->second, "Connection closed.");
+    mConnections.erase(it);
+}
+
+void QubicEventLoop::complete(Request& request, bool ok, const std::string& error)
+{
+    EventLoopResponse response;
+    response.ok = ok;
+    response.error = error;
+    response.packets = std::move(request.packets);
+    response.latencyMsec = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - request.start).count();
+    ResponseCallback callback = request.callback;
+    mDeferred.push_back([callback, response]() mutable { callback(response); });
+}
+
+void QubicEventLoop::failConnection(Connection& connection, const std::string& error)
+{
+    if (!connection.closed)
+    {
+#ifdef __linux__
+        epoll_ctl(mPollFd, EPOLL_CTL_DEL, connection.socket, nullptr);
+#endif
+        close(connection.socket);
+        connection.closed = true;
+    }
+    connection.connecting = false;
+    connection.handshaking = false;
+    for (auto& it : connection.pending)
+        complete(it.second, false, error);
+    connection.pending.clear();
+    connection.sendBuffer.clear();
+    connection.sendOffset = 0;
+    connection.recvBuffer.clear();
+    connection.recvOffset = 0;
+    connection.recvSize = 0;
+}
+
+void QubicEventLoop::updateInterest(Connection& connection)
+{
+    if (connection.closed)
+        return;
+    bool wantWrite = connection.connecting || connection.sendOffset < connection.sendBuffer.size();
+    if (wantWrite == connection.wantWrite)
+        return;
+    connection.wantWrite = wantWrite;
+#ifdef __linux__
+    epoll_event event;
+    event.events = EPOLLIN | (wantWrite ? EPOLLOUT : 0);
+    event.data.u64 = uint64_t(connection.id);
+    epoll_ctl(mPollFd, EPOLL_CTL_MOD, connection.socket, &event);
+#endif
+}
+
+void QubicEventLoop::handleWritable(Connection& connection)
+{
+    if (connection.connecting)
+    {
+        int error = 0;
+        socklen_t errorSize = sizeof(error);
+        if (getsockopt(connection.socket, SOL_SOCKET, SO_ERROR, (char*)&error, &errorSize) != 0 || error != 0)
+        {
+            failConnection(connection, "Unable to establish connection.");
+            return;
+        }
+        connection.connecting = false;
+    }
+    while (connection.sendOffset < connection.sendBuffer.size())
+    {
+        int sentSize = send(connection.socket, (const char*)connection.sendBuffer.data() + connection.sendOffset,
+            int(connection.sendBuffer.size() - connection.sendOffset), SEND_FLAGS);
+        if (sentSize > 0)
+        {
+            connection.sendOffset += sentSize;
+            continue;
+        }
+        if (sentSize < 0 && lastErrorIsWouldBlock())
+            break;
+        failConnection(connection, "Failed to send request.");
+        return;
+    }
+    if (connection.sendOffset == connection.sendBuffer.size())
+    {
+        connection.sendBuffer.clear();
+        connection.sendOffset = 0;
+    }
+    updateInterest(connection);
+}
+
+void QubicEventLoop::handleReadable(Connection& connection)
+{
+    while (!connection.closed)
+    {
+        if (connection.recvBuffer.size() - connection.recvSize < RECEIVE_CHUNK_SIZE)
+        {
+            // make room by handing out the complete packets and moving the rest to the front, the buffer only grows
+            // for packets that do not fit
+            dispatchPackets(connection);
+            if (connection.closed)
+                return;
+            if (connection.recvOffset)
+            {
+                memmove(connection.recvBuffer.data(), connection.recvBuffer.data() + connection.recvOffset,
+                        connection.recvSize - connection.recvOffset);
+                connection.recvSize -= connection.recvOffset;
+                connection.recvOffset = 0;
+            }
+            if (connection.recvBuffer.size() - connection.recvSize < RECEIVE_CHUNK_SIZE)
+                connection.recvBuffer.resize(std::max(2 * connection.recvBuffer.size(), connection.recvSize + RECEIVE_CHUNK_SIZE));
+        }
+        int recvSize = recv(connection.socket, (char*)connection.recvBuffer.data() + connection.recvSize,
+            int(connection.recvBuffer.size() - connection.recvSize), 0);
+        if (recvSize > 0)
+        {
+            connection.recvSize += recvSize;
+            continue;
+        }
+        if (recvSize < 0 && lastErrorIsWouldBlock())
+            break;
+        // deliver what has been received before the node closed the connection
+        dispatchPackets(connection);
+        failConnection(connection, "Connection closed by node.");
+        return;
+    }
+    dispatchPackets(connection);
+}
+
+void QubicEventLoop::dispatchPackets(Connection& connection)
+{
+    while (!connection.closed && connection.recvSize - connection.recvOffset >= sizeof(RequestResponseHeader))
+    {
+        RequestResponseHeader& header = (RequestResponseHeader&)connection.recvBuffer[connection.recvOffset];
+        unsigned int packetSize = header.size();
+        if (packetSize < sizeof(RequestResponseHeader) || packetSize == INT32_MAX)
+        {
+            failConnection(connection, "Received broken packet header.");
+            return;
+        }
+        if (connection.recvSize - connection.recvOffset < packetSize)
+            break;
+
+        const uint8_t* payload = connection.recvBuffer.data() + connection.recvOffset + sizeof(RequestResponseHeader);
+        int payloadSize = int(packetSize - sizeof(RequestResponseHeader));
+        auto it = header.isDejavuZero() ? connection.pending.end() : connection.pending.find(header.dejavu());
+        if (it != connection.pending.end())
+        {
+            Request& request = it->second;
+            if (header.type() == END_RESPOND)
+            {
+                complete(request, true, "");
+                connection.pending.erase(it);
+            }
+            else if (header.type() == request.responseType)
+            {
+                request.packets.emplace_back(payload, payload + payloadSize);
+                if (!request.untilEndResponse)
+                {
+                    complete(request, true, "");
+                    connection.pending.erase(it);
+                }
+            }
+        }
+        else
+        {
+            if (connection.handshaking && header.type() == EXCHANGE_PUBLIC_PEERS)
+            {
+                connection.handshakeData.assign(payload, payload + payloadSize);
+                connection.handshaking = false;
+            }
+            if (connection.packetHandler)
+            {
+                PacketCallback handler = connection.packetHandler;
+                unsigned char type = header.type();
+                PacketPayload copy(payload, payload + payloadSize);
+                mDeferred.push_back([handler, type, copy]() { handler(type, copy.data(), int(copy.size())); });
+            }
+        }
+        connection.recvOffset += packetSize;
+    }
+    // a partial packet stays where it is until handleReadable needs the space
+    if (connection.recvOffset == connection.recvSize)
+        connection.recvOffset = connection.recvSize = 0;
+}
+
+void QubicEventLoop::expireDeadlines()
+{
+    auto now = std::chrono::steady_clock::now();
+    for (auto& connectionIt : mConnections)
+    {
+        Connection& connection = connectionIt.second;
+        if (connection.closed)
+            continue;
+        if ((connection.connecting || connection.handshaking) && connection.connectDeadline < now)
+        {
+            failConnection(connection, "Unable to establish connection.");
+            continue;
+        }
+        for (auto it = connection.pending.begin(); it != connection.pending.end();)
+        {
+            if (it->second.deadline < now)
+            {
+                complete(it->second, false, "Request timed out.");
+                it = connection.pending.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+}
+
+bool QubicEventLoop::hasWork()
+{
+    if (!mDeferred.empty())
+        return true;
+    for (auto& it : mConnections)
+    {
+        const Connection& connection = it.second;
+        if (!connection.closed && (connection.connecting || connection.handshaking || !connection.pending.empty()))
+            return true;
+    }
+    return false;
+}
+
+int QubicEventLoop::nextTimeoutMsec(std::chrono::steady_clock::time_point loopDeadline, bool limited)
+{
+    if (!mDeferred.empty())
+        return 0;
+    auto next = loopDeadline;
+    bool found = limited;
+    for (auto& it : mConnections)
+    {
+        const Connection& connection = it.second;
+        if (connection.closed)
+            continue;
+        if ((connection.connecting || connection.handshaking) && (!found || connection.connectDeadline < next))
+        {
+            next = connection.connectDeadline;
+            found = true;
+        }
+        for (auto& request : connection.pending)
+        {
+            if (!found || request.second.deadline < next)
+            {
+                next = request.second.deadline;
+                found = true;
+            }
+        }
+    }
+    if (!found)
+        return -1;
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(next - std::chrono::steady_clock::now()).count();
+    // round up so that the deadline has passed when the wait returns
+    return (remaining < 0) ? 0 : int(remaining + 1);
+}
+
+void QubicEventLoop::runDeferred()
+{
+    while (!mDeferred.empty())
+    {
+        std::vector<std::function<void()>> deferred;
+        deferred.swap(mDeferred);
+        for (auto& callback : deferred)
+            callback();
+    }
+}
+
+void QubicEventLoop::run(int timeoutMsec)
+{
+    bool limited = timeoutMsec >= 0;
+    auto loopDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(limited ? timeoutMsec : 0);
+    while (true)
+    {
+        runDeferred();
+        if (!hasWork() || (limited && std::chrono::steady_clock::now() >= loopDeadline))
+            break;
+        int waitMsec = nextTimeoutMsec(loopDeadline, limited);
+
+        // collect (connection id, readable, writable, error) events
+        struct Event
+        {
+            int id;
+            bool readable;
+            bool writable;
+            bool error;
+        };
+        std::vector<Event> events;
+#ifdef __linux__
+        epoll_event epollEvents[MAX_EVENTS_PER_WAIT];
+        int count = epoll_wait(mPollFd, epollEvents, MAX_EVENTS_PER_WAIT, waitMsec);
+        for (int i = 0; i < count; i++)
+        {
+            uint32_t flags = epollEvents[i].events;
+            events.push_back({ int(epollEvents[i].data.u64), (flags & EPOLLIN) != 0, (flags & EPOLLOUT) != 0, (flags & (EPOLLERR | EPOLLHUP)) != 0 });
+        }
+#else
+        std::vector<pollfd> pollFds;
+        std::vector<int> ids;
+        for (auto& it : mConnections)
+        {
+            if (it.second.closed)
+                continue;
+            pollfd entry;
+            entry.fd = it.second.socket;
+            entry.events = POLLIN | (it.second.wantWrite ? POLLOUT : 0);
+            entry.revents = 0;
+            pollFds.push_back(entry);
+            ids.push_back(it.first);
+        }
+#ifdef _MSC_VER
+        int count = WSAPoll(pollFds.data(), ULONG(pollFds.size()), waitMsec);
+#else
+        int count = poll(pollFds.data(), pollFds.size(), waitMsec);
+#endif
+        for (size_t i = 0; count > 0 && i < pollFds.size(); i++)
+        {
+            short flags = pollFds[i].revents;
+            if (flags)
+                events.push_back({ ids[i], (flags & POLLIN) != 0, (flags & POLLOUT) != 0, (flags & (POLLERR | POLLHUP)) != 0 });
+        }
+#endif
+
+        for (auto& event : events)
+        {
+            auto it = mConnections.find(event.id);
+            if (it == mConnections.end() || it->second.closed)
+                continue;
+            Connection& connection = it->second;
+            if (event.error && connection.connecting)
+            {
+                failConnection(connection, "Unable to establish connection.");
+                continue;
+            }
+            if (event.writable)
+                handleWritable(connection);
+            if (event.readable || event.error)
+                handleReadable(connection);
+        }
+        expireDeadlines();
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "connection.h"
+
+struct EventLoopResponse
+{
+    bool ok;
+    std::string error;
+    std::vector<PacketPayload> packets;
+    long long latencyMsec;
+};
+
+typedef std::function<void(EventLoopResponse& response)> ResponseCallback;
+
+// Called for received packets that do not belong to a pending request, such as the handshake or broadcasts.
+typedef std::function<void(unsigned char type, const uint8_t* payload, int payloadSize)> PacketCallback;
+
+// Single-threaded event loop driving many node connections with non-blocking sockets (epoll on Linux, poll
+// elsewhere). A connection counts as established once the node's handshake (ExchangePublicPeers) has arrived.
+// Instead of socket-wide receive timeouts every request has its own deadline, and a request completes
+// as soon as its response is complete: on the first packet of the expected type, or on END_RESPOND if
+// untilEndResponse is set. Responses are matched to requests by dejavu.
+// Callbacks are invoked from run() and may submit further requests or add connections.
+// Not thread safe.
+class QubicEventLoop
+{
+public:
+    QubicEventLoop();
+    ~QubicEventLoop();
+
+    // Start connecting to the node without blocking. Return the connection id, or -1 if the socket could not be
+    // created. Connection failures are reported through the callbacks of the requests submitted to it.
+    int addConnection(const char* nodeIp, int nodePort, int connectTimeoutMsec = 1000);
+
+    void setPacketHandler(int connectionId, PacketCallback handler);
+
+    // Queue packet (starting with a RequestResponseHeader with size and type set, the dejavu is overwritten).
+    // Requests may be submitted while the connection is still being established.
+    void submit(int connectionId, const uint8_t* packet, int packetSize, unsigned char responseType, bool untilEndResponse,
+        int timeoutMsec, ResponseCallback callback);
+
+    void closeConnection(int connectionId);
+
+    // Return false if the connection failed or the handshake has not been received yet.
+    bool getHandshakeData(int connectionId, std::vector<uint8_t>& buffer);
+
+    // Process events until no request is pending and no connection is being established, or until timeoutMsec
+    // has passed (negative for no limit).
+    void run(int timeoutMsec = -1);
+
+private:
+    struct Request
+    {
+        unsigned char responseType;
+        bool untilEndResponse;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point deadline;
+        std::vector<PacketPayload> packets;
+        ResponseCallback callback;
+    };
+
+    struct Connection
+    {
+        int id;
+        int socket;
+        bool connecting;
+        bool handshaking;
+        bool closed;
+        bool wantWrite;
+        std::chrono::steady_clock::time_point connectDeadline;
+        std::vector<uint8_t> sendBuffer;
+        size_t sendOffset;
+        std::vector<uint8_t> recvBuffer; // bytes [recvOffset, recvSize) are received and not dispatched yet
+        size_t recvOffset;
+        size_t recvSize;
+        std::map<uint32_t, Request> pending;
+        PacketCallback packetHandler;
+        std::vector<uint8_t> handshakeData;
+    };
+
+    void complete(Request& request, bool ok, const std::string& error);
+    void failConnection(Connection& connection, const std::string& error);
+    void handleWritable(Connection& connection);
+    void handleReadable(Connection& connection);
+    void dispatchPackets(Connection& connection);
+    void updateInterest(Connection& connection);
+    void expireDeadlines();
+    bool hasWork();
+    int nextTimeoutMsec(std::chrono::steady_clock::time_point loopDeadline, bool limited);
+    void runDeferred();
+
+    std::map<int, Connection> mConnections;
+    // callbacks are never invoked while connection state is being processed
+    std::vector<std::function<void()>> mDeferred;
+    int mNextConnectionId;
+    int mPollFd;
+};
@@ -1,3 +1,4 @@
+#include <cctype>
 #include <cstring>
 #include <vector>
 #include <cstdlib>
@@ -10,21 +11,37 @@
 #include <cinttypes>
 #include <fstream>
 #include <fcntl.h>
+#include <set>
+#include <unordered_map>
 
 #include "structs.h"
 #include "connection.h"
 #include "node_utils.h"
+#include "packet_stream.h"
+#include "signer.h"
 #include "logger.h"
+#include "lz_codec.h"
 #include "k12_and_key_utils.h"
 #include "key_utils.h"
+#include "tick_watcher.h"
+#include "utils.h"
 #include "wallet_utils.h"
 
 
 constexpr int fullFragmentSize = 1024 - FileFragmentTransactionPrefix::minInputSize();
-struct fullFragment{
-    RequestResponseHeader header;
-    FileFragmentTransactionPrefix fragmentHeader;
-    uint8_t content[fullFragmentSize];
+// Fragments broadcast for the same tick. Fragments of a file form a chain and a fragment missing from its tick forces
+// everything after it to be signed again, so stay well below NUMBER_OF_TRANSACTIONS_PER_TICK to leave room for others.
+constexpr int uploadFragmentsPerTick = 32;
+static_assert(uploadFragmentsPerTick < NUMBER_OF_TRANSACTIONS_PER_TICK, "Too many fragments per tick");
+
+#define RECONNECT_MIN_MSEC 500
+#define RECONNECT_MAX_MSEC 16000
+
+// Broadcast packet of the file header or of one fragment, signed for a scheduled tick.
+struct UploadTransaction
+{
+    std::vector<uint8_t> packet;
+    uint8_t digest[32];
 };
 
 static std::string getExtension(std::string fn)
@@ -32,127 +49,101 @@ static std::string getExtension(std::string fn)
     return fn.substr(fn.find_last_of(".") + 1);
 }
 
-bool uploadHeader(QCPtr& qc, const char* seed, size_t fileSize, int numberOfFragments, std::string extension, uint8_t* txHash, const uint32_t scheduledTickOffset)
+static UploadTransaction makeHeaderTransaction(const uint8_t* sourcePublicKey, size_t fileSize, int numberOfFragments, const std::string& extension)
 {
-    struct {
-        RequestResponseHeader header;
-        FileHeaderTransaction fh;
-    } payload;
-    FileHeaderTransaction& file_header = payload.fh;
-
-    uint32_t currentTick = getTickNumberFromNode(qc);
-    uint32_t txTick = currentTick + scheduledTickOffset;
-
-    getPublicKeyFromSeed(seed, file_header.sourcePublicKey);
-    memset(file_header.destinationPublicKey, 0, 32);
-    file_header.amount = FileHeaderTransaction::minAmount();
-    file_header.tick = txTick;
-    file_header.fileSize = fileSize;
-    file_header.numberOfFragments = numberOfFragments;
-    memset(file_header.fileFormat, 0, 8);
-    memcpy(file_header.fileFormat, extension.data(), extension.size());
-    file_header.inputType = FileHeaderTransaction::transactionType();
-    file_header.inputSize = FileHeaderTransaction::minInputSize();
-
-    payload.header.setSize(sizeof(payload));
-    payload.header.zeroDejavu();
-    payload.header.setType(BROADCAST_TRANSACTION);
-
-    signData(seed, (uint8_t*)&payload.fh, sizeof(payload.fh) - SIGNATURE_SIZE, payload.fh.signature);
-    qc->sendData((uint8_t *) &payload, payload.header.size());
-
-    KangarooTwelve((uint8_t*)&payload.fh, sizeof(payload.fh), txHash, 32);
-    LOG("Waiting for tx to be included at tick %d\n", txTick);
-    currentTick = getTickNumberFromNode(qc);
-    while (currentTick < txTick + 1)
-    {
-        LOG("Current tick %u\n", currentTick);
-        Q_SLEEP(3000);
-        currentTick = getTickNumberFromNode(qc);
-    }
-    LOG("Verifying transaction\n");
-    char txHashQubic[64] = {0};
-    getIdentityFromPublicKey(txHash, txHashQubic, true);
-    int ret = _GetTxInfo(qc, txHashQubic);
-    while (ret == 2)
-    {
-        ret = _GetTxInfo(qc, txHashQubic);
-        Q_SLEEP(1000);
-    }
-    if (ret == 0)
-    {
-        LOG("Transaction %s is included\n", txHashQubic);
-        return true;
-    }
-    else
+    UploadTransaction tx;
+    tx.packet.resize(sizeof(RequestResponseHeader) + sizeof(FileHeaderTransaction));
+    auto header = (RequestResponseHeader*)tx.packet.data();
+    auto fileHeader = (FileHeaderTransaction*)(tx.packet.data() + sizeof(RequestResponseHeader));
+    memcpy(fileHeader->sourcePublicKey, sourcePublicKey, 32);
+    memset(fileHeader->destinationPublicKey, 0, 32);
+    fileHeader->amount = FileHeaderTransaction::minAmount();
+    fileHeader->fileSize = fileSize;
+    fileHeader->numberOfFragments = numberOfFragments;
+    memset(fileHeader->fileFormat, 0, 8);
+    memcpy(fileHeader->fileFormat, extension.data(), std::min(extension.size(), size_t(8)));
+    fileHeader->inputType = FileHeaderTransaction::transactionType();
+    fileHeader->inputSize = FileHeaderTransaction::minInputSize();
+    header->setSize(unsigned(tx.packet.size()));
+    header->zeroDejavu();
+    header->setType(BROADCAST_TRANSACTION);
+    return tx;
+}
+
+static UploadTransaction makeFragmentTransaction(const uint8_t* sourcePublicKey, const uint64_t fragmentId,
+                                                 const uint8_t* fragmentData, const size_t fragmentSize)
+{
+    UploadTransaction tx;
+    tx.packet.resize(sizeof(RequestResponseHeader) + sizeof(FileFragmentTransactionPrefix) + fragmentSize + SIGNATURE_SIZE);
+    auto header = (RequestResponseHeader*)tx.packet.data();
+    auto fftp = (FileFragmentTransactionPrefix*)(tx.packet.data() + sizeof(RequestResponseHeader));
+    memcpy(fftp->sourcePublicKey, sourcePublicKey, 32);
+    memset(fftp->destinationPublicKey, 0, 32);
+    fftp->amount = FileFragmentTransactionPrefix::minAmount();
+    fftp->fragmentIndex = fragmentId;
+    memcpy(tx.packet.data() + sizeof(RequestResponseHeader) + sizeof(FileFragmentTransactionPrefix), fragmentData, fragmentSize);
+    fftp->inputType = FileFragmentTransactionPrefix::transactionType();
+    fftp->inputSize = uint16_t(FileFragmentTransactionPrefix::minInputSize() + fragmentSize);
+    header->setSize(unsigned(tx.packet.size()));
+    header->zeroDejavu();
+    header->setType(BROADCAST_TRANSACTION);
+    return tx;
+}
+
+static Transaction& transactionOf(UploadTransaction& tx)
+{
+    return *(Transaction*)(tx.packet.data() + sizeof(RequestResponseHeader));
+}
+
+// Schedule the chain from index first onward: tx first gets firstTick, uploadFragmentsPerTick transactions share a tick.
+// Every fragment references the digest of its predecessor (tx 0 is the file header), so the digests have to be
+// recomputed in chain order.
+static void signUploadChain(const Signer& signer, std::vector<UploadTransaction>& txs, size_t first, uint32_t firstTick)
+{
+    for (size_t i = first; i < txs.size(); i++)
     {
-        LOG("Transaction %s is NOT included.\n", txHashQubic);
-        memset(txHash, 0, 32);
+        Transaction& tx = transactionOf(txs[i]);
+        tx.tick = firstTick + uint32_t((i - first) / uploadFragmentsPerTick);
+        if (i > 0)
+            memcpy(((FileFragmentTransactionPrefix&)tx).prevFileFragmentTransactionDigest, txs[i - 1].digest, 32);
+        size_t txSize = txs[i].packet.size() - sizeof(RequestResponseHeader);
+        uint8_t* signature = (uint8_t*)&tx + txSize - SIGNATURE_SIZE;
+        signer.signData((uint8_t*)&tx, txSize - SIGNATURE_SIZE, signature);
+        KangarooTwelve((uint8_t*)&tx, txSize, txs[i].digest, 32);
+    }
+}
+
+// Mark which transactions scheduled for the tick are in its tick data. Return false if tick data could not be fetched.
+static bool checkUploadTick(QCPtr& qc, std::vector<UploadTransaction>& txs, size_t first, size_t end, uint32_t tick, std::vector<bool>& included)
+{
+    TickData td;
+    if (!getTickData(qc, tick, td))
         return false;
+    for (size_t i = first; i < end; i++)
+    {
+        included[i] = false;
+        if (td.epoch == 0)
+            continue; // empty tick
+        for (int j = 0; j < NUMBER_OF_TRANSACTIONS_PER_TICK && !included[i]; j++)
+            included[i] = (memcmp(td.transactionDigests[j], txs[i].digest, 32) == 0);
     }
+    return true;
 }
 
-bool uploadFragment(QCPtr& qc, const char* seed, const uint64_t fragmentId,
-                    const uint8_t* fragmentData, const size_t fragmentSize,
-                    const uint8_t* prevFragmentTxHash,
-                    uint8_t* outTxHash,
-                    const uint32_t scheduledTickOffset)
+// Wait delayMsec, then reconnect to the node and double the delay for the next attempt. Return false if the
+// connection could not be established.
+static bool reconnectWithBackoff(QCPtr& qc, int& delayMsec)
 {
-#pragma pack(push, 1) // this is important
-    struct {
-        RequestResponseHeader header;
-        FileFragmentTransactionPrefix fftp;
-        uint8_t fragmentPostfix[fullFragmentSize + SIGNATURE_SIZE];
-    } payload; // be aware: not always submit full payload
-#pragma pack(pop)
-    auto& fftp = payload.fftp;
-    uint32_t currentTick = getTickNumberFromNode(qc);
-    uint32_t txTick = currentTick + scheduledTickOffset;
-
-    getPublicKeyFromSeed(seed, fftp.sourcePublicKey);
-    memset(fftp.destinationPublicKey, 0, 32);
-    fftp.amount = FileFragmentTransactionPrefix::minAmount();
-    fftp.tick = txTick;
-    fftp.fragmentIndex = fragmentId;
-    memcpy(fftp.prevFileFragmentTransactionDigest, prevFragmentTxHash, 32);
-    memcpy(payload.fragmentPostfix, fragmentData, fragmentSize);
-    fftp.inputType = FileFragmentTransactionPrefix::transactionType();
-    fftp.inputSize = uint16_t(FileFragmentTransactionPrefix::minInputSize() + fragmentSize);
-    uint8_t* ptr_signature =  payload.fragmentPostfix + fragmentSize;
-    size_t payloadSize = sizeof(RequestResponseHeader) + sizeof(FileFragmentTransactionPrefix) + fragmentSize + SIGNATURE_SIZE; // not send full in trailer
-    payload.header.setSize(uint16_t(payloadSize));
-    payload.header.zeroDejavu();
-    payload.header.setType(BROADCAST_TRANSACTION);
-    signData(seed, (uint8_t*)&payload.fftp, sizeof(FileFragmentTransactionPrefix) + fragmentSize, ptr_signature);
-
-    qc->sendData((uint8_t *) &payload, payload.header.size());
-    KangarooTwelve((uint8_t*)&payload.fftp, uint16_t(sizeof(FileFragmentTransactionPrefix) + fragmentSize + SIGNATURE_SIZE), outTxHash, 32);
-    LOG("Waiting for tx to be included at tick %d\n", txTick);
-    currentTick = getTickNumberFromNode(qc);
-    while (currentTick < txTick + 1)
-    {
-        LOG("Current tick %u\n", currentTick);
-        Q_SLEEP(3000);
-        currentTick = getTickNumberFromNode(qc);
-    }
-    LOG("Verifying transaction\n");
-    char txHashQubic[64] = {0};
-    getIdentityFromPublicKey(outTxHash, txHashQubic, true);
-    int ret = _GetTxInfo(qc, txHashQubic);
-    while (ret == 2)
-    {
-        ret = _GetTxInfo(qc, txHashQubic);
-        Q_SLEEP(1000);
-    }
-    if (ret == 0)
-    {
-        LOG("Transaction %s is included\n", txHashQubic);
+    Q_SLEEP(delayMsec);
+    delayMsec = std::min(2 * delayMsec, RECONNECT_MAX_MSEC);
+    try
+    {
+        qc->resolveConnection();
         return true;
     }
-    else
+    catch (std::logic_error& e)
     {
-        LOG("Transaction %s is NOT included.\n", txHashQubic);
-        memset(outTxHash, 0, 32);
+        LOG("%s\n", e.what());
         return false;
     }
 }
@@ -219,11 +210,51 @@ int decompressFileWithTool(const char* inputFile, const char* tool)
     return 0;
 }
 
+// Read the file to upload, compressing it on the fly with the built-in codec if originalExtension is given.
+static bool readFileForUpload(const char* fileName, size_t fileSize, const std::string* originalExtension, std::vector<uint8_t>& data)
+{
+    FILE* f = fopen(fileName, "rb");
+    if (!f)
+        return false;
+    data.clear();
+    if (!originalExtension)
+    {
+        data.resize(fileSize);
+        bool ok = (fread(data.data(), 1, fileSize, f) == fileSize);
+        fclose(f);
+        return ok;
+    }
+    QlzCompressor compressor(*originalExtension, fileSize, [&](const uint8_t* chunk, size_t size)
+    {
+        data.insert(data.end(), chunk, chunk + size);
+    });
+    std::vector<uint8_t> buffer(QLZ_BLOCK_SIZE);
+    size_t total = 0, read = 0;
+    while ((read = fread(buffer.data(), 1, buffer.size(), f)) > 0)
+    {
+        compressor.write(buffer.data(), read);
+        total += read;
+    }
+    fclose(f);
+    compressor.finish();
+    return total == fileSize;
+}
+
 void uploadFile(const char* nodeIp, const int nodePort, const char* filePath, const char* seed, const uint32_t scheduledTickOffset, const char* compressTool)
 {
+    // a transaction scheduled for the current tick can no longer be included, it would be rescheduled forever
+    const uint32_t tickOffset = std::max<uint32_t>(scheduledTickOffset, 1);
+    // the keys are derived once for the whole chain
+    Signer signer(seed);
+    if (!signer.valid())
+    {
+        LOG("Invalid seed. Exit\n");
+        return;
+    }
     std::string filePathStr = filePath;
+    bool builtinCompression = compressTool && strcmp(compressTool, QLZ_FILE_FORMAT) == 0;
     // Run the compression if there is any provided
-    if (compressTool)
+    if (compressTool && !builtinCompression)
     {
         filePathStr = compressFileWithTool(filePath, compressTool);
     }
@@ -245,68 +276,123 @@ void uploadFile(const char* nodeIp, const int nodePort, const char* filePath, co
         return;
     }
 
-    std::vector<fullFragment> file_fragments;
-    int numberOfFragments = int((fileSize + fullFragmentSize - 1) / fullFragmentSize);
     auto qc = make_qc(nodeIp, nodePort);
     std::vector<uint8_t> fragmentData;
-    fragmentData.resize(fileSize);
-    FILE* f = fopen(filePathStr.c_str(), "rb");
-    if (fread(fragmentData.data(), 1, fileSize, f) != fileSize)
+    if (!readFileForUpload(filePathStr.c_str(), fileSize, builtinCompression ? &extension : nullptr, fragmentData))
     {
         LOG("Failed to read file\n");
-        fclose(f);
         return;
     }
-    fclose(f);
+    if (builtinCompression)
+    {
+        LOG("Compressed %zu bytes to %zu bytes\n", fileSize, fragmentData.size());
+        fileSize = fragmentData.size();
+        extension = QLZ_FILE_FORMAT;
+    }
+    int numberOfFragments = int((fileSize + fullFragmentSize - 1) / fullFragmentSize);
 
-    TxHash32Struct fileHeaderTxDigest;
-    LOG("Uploading file header...\n");
-    while (!uploadHeader(qc, seed, fileSize, numberOfFragments, extension, fileHeaderTxDigest.ptr, scheduledTickOffset))
+    // tx 0 is the file header, tx i + 1 is fragment i
+    const uint8_t* sourcePublicKey = signer.publicKey();
+    std::vector<UploadTransaction> txs;
+    txs.reserve(numberOfFragments + 1);
+    txs.push_back(makeHeaderTransaction(sourcePublicKey, fileSize, numberOfFragments, extension));
+    for (int i = 0; i < numberOfFragments; i++)
     {
-        LOG("Failed to upload file header, retry in 3 seconds\n");
-        Q_SLEEP(3000);
+        size_t segmentStart = size_t(i) * fullFragmentSize;
+        size_t segmentSize = std::min(size_t(fullFragmentSize), fileSize - segmentStart);
+        txs.push_back(makeFragmentTransaction(sourcePublicKey, i, fragmentData.data() + segmentStart, segmentSize));
     }
-    std::vector<TxHash32Struct> fragmentTxDigests;
-    fragmentTxDigests.resize(numberOfFragments);
-    std::vector<int> segmentStart, segmentSize;
-    segmentStart.resize(numberOfFragments);
-    segmentSize.resize(numberOfFragments);
-    size_t tmp = fileSize;
 
-    segmentStart[0] = 0;
-    segmentSize[0] = std::min(int(fullFragmentSize), int(tmp));
-    tmp -= segmentSize[0];
-    for (int i = 1; i < numberOfFragments; i++)
+    // Pipeline: the whole chain is signed up front with uploadFragmentsPerTick transactions per tick, each batch is
+    // broadcast once its tick is tickOffset ticks ahead, and each tick is checked as soon as it has passed
+    // while later batches are in flight. A missing transaction invalidates the digests of all transactions after it,
+    // so the chain is signed again from there for upcoming ticks.
+    auto watcher = TickWatcher::forNode(nodeIp, nodePort);
+    uint32_t currentTick = watcher->getCurrentTick();
+    if (currentTick == 0)
     {
-        segmentStart[i] = segmentStart[i-1] + segmentSize[i-1];
-        segmentSize[i] = std::min(int(fullFragmentSize), int(tmp));
-        tmp -= segmentSize[i];
+        LOG("Failed to get current tick. Exit\n");
+        return;
     }
-    LOG("Uploading fragments...\n");
+    LOG("Uploading file header and %d fragments, %d per tick...\n", numberOfFragments, uploadFragmentsPerTick);
+    signUploadChain(signer, txs, 0, currentTick + tickOffset);
+    std::vector<bool> included(txs.size(), false);
+    size_t nextToSend = 0, confirmed = 0;
+    int retries = 0;
+    int reconnectDelayMsec = RECONNECT_MIN_MSEC;
+    auto start = std::chrono::steady_clock::now();
+    while (confirmed < txs.size())
     {
-        int i = 0;
-        while (!uploadFragment(qc, seed, i, fragmentData.data() + segmentStart[i], segmentSize[i], fileHeaderTxDigest.ptr, fragmentTxDigests[i].ptr, scheduledTickOffset))
+        currentTick = watcher->getCurrentTick();
+        while (nextToSend < txs.size() && transactionOf(txs[nextToSend]).tick <= currentTick + tickOffset)
         {
-            LOG("Failed to upload fragment %d, retry in 3 seconds\n", i);
-            Q_SLEEP(3000);
+            if (transactionOf(txs[nextToSend]).tick <= currentTick)
+            {
+                // fell behind the network, move the rest of the chain to upcoming ticks
+                signUploadChain(signer, txs, nextToSend, currentTick + tickOffset);
+                continue;
+            }
+            int packetSize = int(txs[nextToSend].packet.size());
+            if (qc->sendData(txs[nextToSend].packet.data(), packetSize) != packetSize)
+            {
+                // resend the same transaction on the new connection, the tick is checked again after the wait
+                LOG("Failed to broadcast transaction %zu, reconnecting in %d ms\n", nextToSend, reconnectDelayMsec);
+                reconnectWithBackoff(qc, reconnectDelayMsec);
+                break;
+            }
+            reconnectDelayMsec = RECONNECT_MIN_MSEC;
+            nextToSend++;
         }
-    }
-    for (int i = 1; i < numberOfFragments; i++)
-    {
-        LOG("Uploading fragment #%d\n", i);
-        while (!uploadFragment(qc, seed, i, fragmentData.data() + segmentStart[i], segmentSize[i], fragmentTxDigests[i-1].ptr, fragmentTxDigests[i].ptr, scheduledTickOffset))
+
+        uint32_t oldestTick = transactionOf(txs[confirmed]).tick;
+        if (confirmed < nextToSend && currentTick > oldestTick)
         {
-            LOG("Failed to upload fragment %d, retry in 3 seconds\n", i);
-            Q_SLEEP(3000);
+            size_t end = confirmed;
+            while (end < nextToSend && transactionOf(txs[end]).tick == oldestTick)
+                end++;
+            if (!checkUploadTick(qc, txs, confirmed, end, oldestTick, included))
+            {
+                LOG("Failed to get tick data of tick %u, reconnecting in %d ms\n", oldestTick, reconnectDelayMsec);
+                reconnectWithBackoff(qc, reconnectDelayMsec);
+                continue;
+            }
+            reconnectDelayMsec = RECONNECT_MIN_MSEC;
+            size_t firstMissing = confirmed;
+            while (firstMissing < end && included[firstMissing])
+                firstMissing++;
+            if (firstMissing < end)
+            {
+                retries++;
+                size_t missing = std::count(included.begin() + confirmed, included.begin() + end, false);
+                LOG("%zu of %zu transactions missing on tick %u, signing the chain again from %s\n", missing, end - confirmed, oldestTick,
+                    firstMissing == 0 ? "the file header" : ("fragment #" + std::to_string(firstMissing - 1)).c_str());
+                signUploadChain(signer, txs, firstMissing, currentTick + tickOffset);
+                nextToSend = firstMissing;
+            }
+            else
+            {
+                LOG("Tick %u: %zu/%zu transactions included\n", oldestTick, end, txs.size());
+            }
+            confirmed = firstMissing;
+            continue;
         }
+
+        // wait for the next batch to become due or for the oldest tick in flight to pass
+        uint32_t waitTick = oldestTick + 1;
+        if (nextToSend < txs.size())
+            waitTick = std::min(waitTick, transactionOf(txs[nextToSend]).tick - tickOffset);
+        watcher->waitForTick(waitTick);
     }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG("Uploaded %zu transactions in %.1f s (%d retries)\n", txs.size(), elapsed, retries);
+
     LOG("Successfully uploaded file. List of all hashes:\n");
     char qubicHash[64] = {0};
-    getIdentityFromPublicKey(fileHeaderTxDigest.ptr, qubicHash, true);
+    getIdentityFromPublicKey(txs[0].digest, qubicHash, true);
     LOG("File header: %s\n", qubicHash);
     for (int i = 0; i < numberOfFragments; i++)
     {
-        getIdentityFromPublicKey(fragmentTxDigests[i].ptr, qubicHash, true);
+        getIdentityFromPublicKey(txs[i + 1].digest, qubicHash, true);
         if (i != numberOfFragments - 1)
         {
             LOG("Fragment #%d: %s\n", i, qubicHash);
@@ -318,84 +404,408 @@ void uploadFile(const char* nodeIp, const int nodePort, const char* filePath, co
     }
 }
 
-void downloadFile(const char* nodeIp, const int nodePort, const char* trailer, const char* outFilePath, const char* decompressTool)
+#define DOWNLOAD_TICKS_IN_FLIGHT 8
+#define DOWNLOAD_PROGRESS_INTERVAL 64
+
+// Transaction (with input and signature) of an uploaded file, keyed by its digest.
+typedef std::unordered_map<std::string, PacketPayload> FileTransactionCache;
+
+static std::string digestKey(const uint8_t* digest)
 {
-    std::vector<uint8_t> fileData;
-    uint8_t buffer[1024];
-    auto qc = make_qc(nodeIp, nodePort);
-    int dataSize = 0;
-    int ret = _GetInputDataFromTxHash(qc, trailer, buffer, dataSize);
-    while (ret == 2)
+    return std::string((const char*)digest, 32);
+}
+
+// Size of the transaction with input and signature, 0 if the buffer does not hold a valid transaction.
+static size_t transactionSizeOf(const uint8_t* data, size_t size)
+{
+    if (size < sizeof(Transaction))
+        return 0;
+    size_t txSize = sizeof(Transaction) + ((const Transaction*)data)->inputSize + SIGNATURE_SIZE;
+    return (txSize <= size) ? txSize : 0;
+}
+
+// Request one transaction by digest. Return false if the node does not know it. May throw std::logic_error.
+static bool requestTransaction(QCPtr& qc, const uint8_t* digest, PacketPayload& tx)
+{
+    struct {
+        RequestResponseHeader header;
+        RequestedTransactionInfo txs;
+    } packet;
+    packet.header.setSize(sizeof(packet));
+    packet.header.randomizeDejavu();
+    packet.header.setType(REQUEST_TRANSACTION_INFO);
+    memcpy(packet.txs.transactionDigest, digest, 32);
+    qc->sendData((uint8_t *) &packet, packet.header.size());
+
+    // other packets may arrive on the connection in between, only END_RESPOND tells that the node does not know it
+    PacketStreamReader reader(qc);
+    PacketView view;
+    while (reader.next(view))
     {
-        ret = _GetInputDataFromTxHash(qc, trailer, buffer, dataSize);
-        Q_SLEEP(1000);
+        if (view.type() == END_RESPOND)
+            return false;
+        if (view.type() != BROADCAST_TRANSACTION)
+            continue;
+        size_t txSize = transactionSizeOf(view.payload, view.payloadSize);
+        uint8_t receivedDigest[32];
+        KangarooTwelve(view.payload, txSize, receivedDigest, 32);
+        if (!txSize || memcmp(receivedDigest, digest, 32) != 0)
+            continue;
+        tx.assign(view.payload, view.payload + txSize);
+        return true;
     }
-    if (ret == 1)
+    throw std::logic_error("No response to transaction request.");
+}
+
+// Collect the file header and fragment transactions of the source in the tick. Return their number.
+static size_t requestFileTransactionsOfTick(QCPtr& qc, uint32_t tick, const uint8_t* sourcePublicKey, FileTransactionCache& cache)
+{
+    struct {
+        RequestResponseHeader header;
+        RequestedTickTransactions txs;
+    } packet;
+    packet.header.setSize(sizeof(packet));
+    packet.header.randomizeDejavu();
+    packet.header.setType(REQUEST_TICK_TRANSACTIONS);
+    packet.txs.tick = tick;
+    memset(packet.txs.transactionFlags, 0, sizeof(packet.txs.transactionFlags));
+    qc->sendData((uint8_t *) &packet, packet.header.size());
+
+    PacketStreamReader reader(qc);
+    return reader.forEachPacketOfType(BROADCAST_TRANSACTION, [&](const PacketView& view)
     {
-        LOG("Cannot find trailer %s is included\n", trailer);
-        return;
+        size_t txSize = transactionSizeOf(view.payload, view.payloadSize);
+        const Transaction& tx = view.as<Transaction>();
+        if (!txSize || memcmp(tx.sourcePublicKey, sourcePublicKey, 32) != 0)
+            return false;
+        if (tx.inputType != FileHeaderTransaction::transactionType() && tx.inputType != FileFragmentTransactionPrefix::transactionType())
+            return false;
+        uint8_t digest[32];
+        KangarooTwelve(view.payload, txSize, digest, 32);
+        cache[digestKey(digest)].assign(view.payload, view.payload + txSize);
+        return true;
+    });
+}
+
+// Fetch the file transactions of several ticks concurrently, one pooled connection per tick in flight.
+static void prefetchFileTransactions(const char* nodeIp, int nodePort, const std::vector<uint32_t>& ticks,
+                                     const uint8_t* sourcePublicKey, FileTransactionCache& cache)
+{
+    std::vector<FileTransactionCache> results(ticks.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < ticks.size(); i++)
+    {
+        threads.emplace_back([&, i]()
+        {
+            try
+            {
+                auto qc = make_qc(nodeIp, nodePort);
+                requestFileTransactionsOfTick(qc, ticks[i], sourcePublicKey, results[i]);
+            }
+            catch (std::logic_error&)
+            {
+                // not fatal, missing fragments are requested one by one
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (auto& result : results)
+    {
+        for (auto& tx : result)
+            cache[tx.first] = std::move(tx.second);
+    }
+}
+
+// Progress of an interrupted download: the fragments after nextIndex are in the part file, nextDigest is the
+// transaction to fetch next (fragment nextIndex, or the file header once nextIndex is -1).
+struct DownloadProgress
+{
+    std::string trailer;
+    int64_t numberOfFragments;
+    int64_t fileSize;
+    int64_t nextIndex;
+    uint8_t nextDigest[32];
+};
+
+static bool loadDownloadProgress(const std::string& fileName, const char* trailer, DownloadProgress& progress)
+{
+    std::ifstream in(fileName);
+    std::string digestHex;
+    if (!(in >> progress.trailer >> progress.numberOfFragments >> progress.fileSize >> progress.nextIndex >> digestHex))
+        return false;
+    if (strcasecmp(progress.trailer.c_str(), trailer) != 0 || digestHex.size() != 64)
+        return false;
+    hexToByte(digestHex.c_str(), progress.nextDigest, 32);
+    return true;
+}
+
+static void saveDownloadProgress(const std::string& fileName, const DownloadProgress& progress)
+{
+    char digestHex[65] = {0};
+    byteToHex(progress.nextDigest, digestHex, 32);
+    std::ofstream out(fileName, std::ofstream::trunc);
+    out << progress.trailer << "\n" << progress.numberOfFragments << "\n" << progress.fileSize << "\n"
+        << progress.nextIndex << "\n" << digestHex << "\n";
+}
+
+// Whether the downloaded file starts like a qlz stream.
+static bool isQlzFile(const std::string& path)
+{
+    uint8_t head[4];
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+    size_t read = fread(head, 1, sizeof(head), f);
+    fclose(f);
+    return isQlzStream(head, read);
+}
+
+// Decompress a downloaded qlz stream into outFilePath + "." + the original extension.
+static bool decompressDownloadedFile(const std::string& inPath, const char* outFilePath, std::string& outPath)
+{
+    FILE* in = fopen(inPath.c_str(), "rb");
+    if (!in)
+        return false;
+    FILE* out = nullptr;
+    bool writeFailed = false;
+    QlzDecompressor decompressor([&](const uint8_t* data, size_t size)
+    {
+        if (!out && !writeFailed)
+        {
+            outPath = std::string(outFilePath) + "." + decompressor.extension();
+            out = fopen(outPath.c_str(), "wb");
+            writeFailed = (out == nullptr);
+        }
+        if (out && fwrite(data, 1, size, out) != size)
+            writeFailed = true;
+    });
+    std::vector<uint8_t> buffer(QLZ_BLOCK_SIZE);
+    size_t read = 0;
+    bool ok = true;
+    while (ok && (read = fread(buffer.data(), 1, buffer.size(), in)) > 0)
+        ok = decompressor.write(buffer.data(), read);
+    fclose(in);
+    if (!out && ok && decompressor.finished())
+    {
+        // empty original file
+        outPath = std::string(outFilePath) + "." + decompressor.extension();
+        out = fopen(outPath.c_str(), "wb");
+        writeFailed = (out == nullptr);
     }
-    int contentSize = dataSize - 40;
-    fileData.resize(contentSize);
-    memcpy(fileData.data(), buffer + 40, contentSize);
+    if (out)
+        fclose(out);
+    return ok && decompressor.finished() && !writeFailed;
+}
+
+void downloadFile(const char* nodeIp, const int nodePort, const char* trailer, const char* outFilePath, const char* decompressTool)
+{
+    // Fragments link backwards from the trailer, so the chain is walked serially. Lookups are parallelized across
+    // ticks instead: the transactions of the ticks before the current fragment are fetched concurrently, and the
+    // following chain links are resolved locally. Every fragment except the trailer has fullFragmentSize bytes, so
+    // each one is written at its final offset of the part file, which the trailer written first extends to full size.
+    std::string partPath = std::string(outFilePath) + ".part";
+    std::string progressPath = std::string(outFilePath) + ".progress";
+    auto qc = make_qc(nodeIp, nodePort);
+    FileTransactionCache cache;
+    std::set<uint32_t> fetchedTicks;
+    uint8_t sourcePublicKey[32] = {0};
+    DownloadProgress progress;
+    FILE* f = nullptr;
 
-    uint64_t nFragment = ((uint64_t*)buffer)[0] + 1;
-    LOG("Number of fragment: %d\n", nFragment);
-    LOG("Downloaded fragment #%" PRIu64 "\n", nFragment - 1);
-    char nextTxHash[64] = {0};
-    getIdentityFromPublicKey(buffer + 8, nextTxHash, true);
+    // Keep the DOWNLOAD_TICKS_IN_FLIGHT ticks up to the tick of the current fragment prefetched. The window is refilled
+    // once half of it is consumed, so that each refill fetches a full batch of ticks concurrently.
+    auto prefetchBefore = [&](uint32_t tick)
+    {
+        std::vector<uint32_t> ticks;
+        for (uint32_t t = tick; t > 0 && tick - t < DOWNLOAD_TICKS_IN_FLIGHT; t--)
+        {
+            if (!fetchedTicks.count(t))
+                ticks.push_back(t);
+        }
+        if (ticks.empty() || (fetchedTicks.count(tick) && ticks.size() < DOWNLOAD_TICKS_IN_FLIGHT / 2))
+            return;
+        for (uint32_t t = ticks.back() - 1; t > 0 && ticks.size() < DOWNLOAD_TICKS_IN_FLIGHT; t--)
+        {
+            if (!fetchedTicks.count(t))
+                ticks.push_back(t);
+        }
+        fetchedTicks.insert(ticks.begin(), ticks.end());
+        prefetchFileTransactions(nodeIp, nodePort, ticks, sourcePublicKey, cache);
+    };
 
-    for (int i = 0; i < nFragment - 1; i++)
+    // Fetch a transaction of the file, from the prefetched ticks if possible. moreToCome prefetches the ticks of the
+    // fragments that follow in the chain.
+    auto fetch = [&](const uint8_t* digest, PacketPayload& tx, bool moreToCome) -> bool
     {
-        ret = _GetInputDataFromTxHash(qc, nextTxHash, buffer, dataSize);
-        while (ret == 2)
+        auto cached = cache.find(digestKey(digest));
+        if (cached != cache.end())
         {
-            ret = _GetInputDataFromTxHash(qc, nextTxHash, buffer, dataSize);
-            Q_SLEEP(1000);
+            tx = std::move(cached->second);
+            cache.erase(cached);
         }
-        if (dataSize)
+        else
         {
-            if (dataSize < 40)
+            int retry = 0;
+            int reconnectDelayMsec = RECONNECT_MIN_MSEC;
+            while (true)
             {
-                LOG("Malformed data size, please check this tx hash %s\n", nextTxHash);
+                try
+                {
+                    if (!requestTransaction(qc, digest, tx))
+                        return false;
+                    break;
+                }
+                catch (std::logic_error& e)
+                {
+                    if (++retry > 3)
+                        return false;
+                    LOG("%s Retry in %d ms\n", e.what(), reconnectDelayMsec);
+                    reconnectWithBackoff(qc, reconnectDelayMsec);
+                }
             }
-            uint64_t fragmentId = ((uint64_t*)(buffer))[0];
-            LOG("Downloaded fragment #%" PRIu64 "\n", fragmentId);
-            getIdentityFromPublicKey(buffer + 8, nextTxHash, true);
-            std::vector<uint8_t> tmp;
-            contentSize = dataSize - 40;
-            tmp.resize(fileData.size() + contentSize);
-            memcpy(tmp.data(), buffer + 40, contentSize);
-            memcpy(tmp.data() + contentSize, fileData.data(), fileData.size());
-            std::swap(fileData, tmp);
+        }
+        const Transaction& found = *(const Transaction*)tx.data();
+        memcpy(sourcePublicKey, found.sourcePublicKey, 32);
+        if (moreToCome)
+            prefetchBefore(found.tick);
+        return true;
+    };
+
+    PacketPayload tx;
+    if (loadDownloadProgress(progressPath, trailer, progress) && (f = fopen(partPath.c_str(), "r+b")) != nullptr)
+    {
+        LOG("Resuming download: %" PRId64 " of %" PRId64 " fragments left\n", progress.nextIndex + 1, progress.numberOfFragments);
+    }
+    else
+    {
+        char trailerUpper[61] = {0};
+        for (int i = 0; i < 60 && trailer[i] != '\0'; ++i)
+            trailerUpper[i] = char(std::toupper(trailer[i]));
+        uint8_t trailerDigest[32] = {0};
+        getPublicKeyFromIdentity(trailerUpper, trailerDigest);
+        if (!fetch(trailerDigest, tx, true) || tx.size() < sizeof(FileFragmentTransactionPrefix) + SIGNATURE_SIZE)
+        {
+            LOG("Cannot find trailer %s\n", trailer);
+            return;
+        }
+        auto& fftp = *(const FileFragmentTransactionPrefix*)tx.data();
+        size_t contentSize = tx.size() - sizeof(FileFragmentTransactionPrefix) - SIGNATURE_SIZE;
+        progress.trailer = trailer;
+        progress.numberOfFragments = int64_t(fftp.fragmentIndex) + 1;
+        progress.fileSize = int64_t(fftp.fragmentIndex) * fullFragmentSize + int64_t(contentSize);
+        progress.nextIndex = int64_t(fftp.fragmentIndex) - 1;
+        memcpy(progress.nextDigest, fftp.prevFileFragmentTransactionDigest, 32);
+        LOG("Number of fragment: %" PRId64 "\n", progress.numberOfFragments);
+        f = fopen(partPath.c_str(), "w+b");
+        if (!f)
+        {
+            LOG("Failed to open %s\n", partPath.c_str());
+            return;
+        }
+        if (!seekFile(f, fftp.fragmentIndex * fullFragmentSize)
+            || fwrite(tx.data() + sizeof(FileFragmentTransactionPrefix), 1, contentSize, f) != contentSize)
+        {
+            LOG("Failed to write fragment #%" PRIu64 " to %s\n", fftp.fragmentIndex, partPath.c_str());
+            fclose(f);
+            return;
+        }
+        LOG("Downloaded fragment #%" PRIu64 "\n", fftp.fragmentIndex);
+        saveDownloadProgress(progressPath, progress);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int64_t downloaded = 0;
+    while (progress.nextIndex >= 0)
+    {
+        char nextTxHash[64] = {0};
+        getIdentityFromPublicKey(progress.nextDigest, nextTxHash, true);
+        if (!fetch(progress.nextDigest, tx, true) || tx.size() < sizeof(FileFragmentTransactionPrefix) + SIGNATURE_SIZE)
+        {
+            LOG("Failed to download fragment #%" PRId64 " (tx hash %s). Run the same command again to resume\n", progress.nextIndex, nextTxHash);
+            fclose(f);
+            saveDownloadProgress(progressPath, progress);
+            return;
+        }
+        auto& fftp = *(const FileFragmentTransactionPrefix*)tx.data();
+        size_t contentSize = tx.size() - sizeof(FileFragmentTransactionPrefix) - SIGNATURE_SIZE;
+        if (int64_t(fftp.fragmentIndex) != progress.nextIndex || contentSize != fullFragmentSize)
+        {
+            LOG("Malformed fragment, please check this tx hash %s\n", nextTxHash);
+            fclose(f);
+            return;
+        }
+        if (!seekFile(f, fftp.fragmentIndex * fullFragmentSize)
+            || fwrite(tx.data() + sizeof(FileFragmentTransactionPrefix), 1, contentSize, f) != contentSize)
+        {
+            LOG("Failed to write fragment #%" PRIu64 " to %s\n", fftp.fragmentIndex, partPath.c_str());
+            fclose(f);
+            saveDownloadProgress(progressPath, progress);
+            return;
+        }
+        memcpy(progress.nextDigest, fftp.prevFileFragmentTransactionDigest, 32);
+        progress.nextIndex--;
+        downloaded++;
+        if (downloaded % DOWNLOAD_PROGRESS_INTERVAL == 0)
+        {
+            fflush(f);
+            saveDownloadProgress(progressPath, progress);
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            LOG("Downloaded %" PRId64 "/%" PRId64 " fragments, %.1f fragments/s\n", progress.numberOfFragments - progress.nextIndex - 1,
+                progress.numberOfFragments, downloaded / std::max(elapsed, 0.001));
         }
     }
-    ret = _GetInputDataFromTxHash(qc, nextTxHash, buffer, dataSize);
-    while (ret == 2)
+    fclose(f);
+    saveDownloadProgress(progressPath, progress);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG("Downloaded %" PRId64 " fragments in %.2f s (%.1f fragments/s)\n", downloaded, elapsed, downloaded / std::max(elapsed, 0.001));
+
+    if (!fetch(progress.nextDigest, tx, false) || tx.size() < sizeof(FileHeaderTransaction))
     {
-        ret = _GetInputDataFromTxHash(qc, nextTxHash, buffer, dataSize);
-        Q_SLEEP(1000);
+        LOG("Failed to download file header. Run the same command again to resume\n");
+        return;
     }
     LOG("Downloaded header\n");
-    uint64_t fileSize = ((uint64_t*)buffer)[0];
-    uint64_t numberOfFragments = ((uint64_t*)(buffer+8))[0];
-    char fileFormat[8] = {0};
-    memcpy(fileFormat, buffer + 16, 8);
-    if (fileSize != fileData.size())
+    auto& fileHeader = *(const FileHeaderTransaction*)tx.data();
+    char fileFormat[9] = {0};
+    memcpy(fileFormat, fileHeader.fileFormat, 8);
+    if (int64_t(fileHeader.fileSize) != progress.fileSize)
     {
-        LOG("mismatched file size. Header tell %d | have %d\n", fileSize, fileData.size());
+        LOG("mismatched file size. Header tell %" PRIu64 " | have %" PRId64 "\n", fileHeader.fileSize, progress.fileSize);
         return;
     }
-    if (numberOfFragments != nFragment)
+    if (int64_t(fileHeader.numberOfFragments) != progress.numberOfFragments)
     {
-        LOG("mismatched number of fragment. Header tell %d | have %d\n", numberOfFragments, nFragment);
+        LOG("mismatched number of fragment. Header tell %" PRIu64 " | have %" PRId64 "\n", fileHeader.numberOfFragments, progress.numberOfFragments);
+        return;
+    }
+    // the header only names the format, the stream itself must confirm it before it is decoded
+    const bool qlzFormat = strcmp(fileFormat, QLZ_FILE_FORMAT) == 0;
+    if (qlzFormat && !isQlzFile(partPath))
+        LOG("The file is marked as %s but is not a %s stream, it is kept as is\n", QLZ_FILE_FORMAT, QLZ_FILE_FORMAT);
+    else if (qlzFormat)
+    {
+        // compressed with the built-in codec, decompress straight into the output file
+        std::string outPath;
+        if (!decompressDownloadedFile(partPath, outFilePath, outPath))
+        {
+            LOG("Failed to decompress %s\n", partPath.c_str());
+            return;
+        }
+        remove(partPath.c_str());
+        remove(progressPath.c_str());
+        LOG("Data have been decompressed and written to %s\n", outPath.c_str());
         return;
     }
     LOG("File extension: %s\n", fileFormat);
     std::string outPath = std::string(outFilePath) + "." + std::string(fileFormat);
-    FILE* f = fopen(outPath.c_str(), "wb");
-    fwrite(fileData.data(), 1, fileData.size(), f);
-    fclose(f);
+    remove(outPath.c_str());
+    if (rename(partPath.c_str(), outPath.c_str()) != 0)
+    {
+        LOG("Failed to move %s to %s\n", partPath.c_str(), outPath.c_str());
+        return;
+    }
+    remove(progressPath.c_str());
     LOG("Data have been written to %s\n", outPath.c_str());
 
     // Run the decompression if there is any provided
@@ -403,5 +813,4 @@ void downloadFile(const char* nodeIp, const int nodePort, const char* trailer, c
     {
         decompressFileWithTool(outPath.c_str(), decompressTool);
     }
-
 }
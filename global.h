@@ -19,6 +19,7 @@ const char* g_voteValueString = "";
 const char* g_paramString1 = "";
 const char* g_paramString2 = "";
 bool g_force = false;
+int g_numberOfThreads = 0;
 
 int64_t g_txAmount = 0;
 uint16_t g_txType = 0;
@@ -40,6 +41,7 @@ char* g_compChatString = nullptr;
 char* g_dumpBinaryFileInput = nullptr;
 char* g_dumpBinaryFileOutput = nullptr;
 uint32_t g_dumpBinaryContractId = 0;
+uint64_t g_merkleLeafIndex = 0;
 
 // IPO bid
 uint32_t g_IPOContractIndex = 0;
@@ -48,6 +50,7 @@ uint64_t g_makeIPOBidPricePerShare = 0;
 
 // qx
 uint32_t g_requestedTickNumber = 0;
+uint32_t g_requestedEndTickNumber = 0;
 uint32_t g_offsetScheduledTick = DEFAULT_SCHEDULED_TICK_OFFSET;
 int g_waitUntilFinish = 0;
 uint8_t g_txExtraData[1024] = {0};
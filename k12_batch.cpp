@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <cstring>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+#include <vector>
+
+#include "k12_and_key_utils.h"
+#include "k12_batch.h"
+#include "parallel.h"
+
+// kernels in k12_batch_avx2.cpp and k12_batch_avx512.cpp, return false if they were not compiled in
+bool KeccakSpongeBatchAvx2(const uint8_t* const* inputs, unsigned int inputByteLen, const uint8_t* suffix, unsigned int suffixByteLen,
+                           uint8_t* const* outputs, unsigned int outputByteLen, size_t count);
+bool KeccakSpongeBatchAvx512(const uint8_t* const* inputs, unsigned int inputByteLen, const uint8_t* suffix, unsigned int suffixByteLen,
+                             uint8_t* const* outputs, unsigned int outputByteLen, size_t count);
+
+#define MAX_BATCH_INPUT 8191
+#define MAX_BATCH_OUTPUT K12_rateInBytes
+// pointers prepared at once by the back to back variant
+#define POINTER_CHUNK 64
+// leaves of the KangarooTwelve tree hashed by one task of KangarooTwelveParallel (512 KB)
+#define LEAVES_PER_TASK 64
+#define K12_CHAINING_VALUE_SIZE 32
+
+static const uint8_t SHORT_INPUT_SUFFIX[2] = { 0x00, 0x07 };
+static const uint8_t LEAF_SUFFIX[1] = { K12_suffixLeaf };
+
+enum BatchImplementation
+{
+    PORTABLE,
+    AVX2,
+    AVX512,
+};
+
+static BatchImplementation detectImplementation()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 0x06) == 0x06);
+    bool osSavesZmm = osSavesYmm && ((_xgetbv(0) & 0xE6) == 0xE6);
+    __cpuidex(info, 7, 0);
+    if (osSavesZmm && (info[1] & (1 << 16)) && KeccakSpongeBatchAvx512(nullptr, 0, nullptr, 0, nullptr, 0, 0))
+        return AVX512;
+    if (osSavesYmm && (info[1] & (1 << 5)) && KeccakSpongeBatchAvx2(nullptr, 0, nullptr, 0, nullptr, 0, 0))
+        return AVX2;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && KeccakSpongeBatchAvx512(nullptr, 0, nullptr, 0, nullptr, 0, 0))
+        return AVX512;
+    if (__builtin_cpu_supports("avx2") && KeccakSpongeBatchAvx2(nullptr, 0, nullptr, 0, nullptr, 0, 0))
+        return AVX2;
+#endif
+    return PORTABLE;
+}
+
+static BatchImplementation getImplementation()
+{
+    static const BatchImplementation implementation = detectImplementation();
+    return implementation;
+}
+
+const char* getKangarooTwelveBatchImplementation()
+{
+    switch (getImplementation())
+    {
+    case AVX512:
+        return "avx512";
+    case AVX2:
+        return "avx2";
+    default:
+        return "portable";
+    }
+}
+
+// Sponge over input || suffix with the domain separation bits in the last suffix byte, like KangarooTwelve_F.
+static void keccakSponge(const uint8_t* input, unsigned int inputByteLen, const uint8_t* suffix, unsigned int suffixByteLen,
+                         uint8_t* output, unsigned int outputByteLen)
+{
+    KangarooTwelve_F node;
+    memset(&node, 0, sizeof(KangarooTwelve_F));
+    KangarooTwelve_F_Absorb(&node, input, inputByteLen);
+    KangarooTwelve_F_Absorb(&node, suffix, suffixByteLen - 1);
+    node.state[node.byteIOIndex] ^= suffix[suffixByteLen - 1];
+    node.state[K12_rateInBytes - 1] ^= 0x80;
+    KeccakP1600_Permute_12rounds(node.state);
+    memcpy(output, node.state, outputByteLen);
+}
+
+static void keccakSpongeBatch(const uint8_t* const* inputs, unsigned int inputByteLen, const uint8_t* suffix, unsigned int suffixByteLen,
+                              uint8_t* const* outputs, unsigned int outputByteLen, size_t count)
+{
+    if (count > 1)
+    {
+        switch (getImplementation())
+        {
+        case AVX512:
+            KeccakSpongeBatchAvx512(inputs, inputByteLen, suffix, suffixByteLen, outputs, outputByteLen, count);
+            return;
+        case AVX2:
+            KeccakSpongeBatchAvx2(inputs, inputByteLen, suffix, suffixByteLen, outputs, outputByteLen, count);
+            return;
+        default:
+            break;
+        }
+    }
+    for (size_t i = 0; i < count; i++)
+        keccakSponge(inputs[i], inputByteLen, suffix, suffixByteLen, outputs[i], outputByteLen);
+}
+
+void KangarooTwelveBatch(const uint8_t* const* inputs, unsigned int inputByteLen, uint8_t* const* outputs, unsigned int outputByteLen, size_t count)
+{
+    if (count > 1 && inputByteLen <= MAX_BATCH_INPUT && outputByteLen <= MAX_BATCH_OUTPUT && getImplementation() != PORTABLE)
+    {
+        keccakSpongeBatch(inputs, inputByteLen, SHORT_INPUT_SUFFIX, sizeof(SHORT_INPUT_SUFFIX), outputs, outputByteLen, count);
+        return;
+    }
+    for (size_t i = 0; i < count; i++)
+        KangarooTwelve(inputs[i], inputByteLen, outputs[i], outputByteLen);
+}
+
+void KangarooTwelveBatch(const uint8_t* input, unsigned int inputByteLen, uint8_t* output, unsigned int outputByteLen, size_t count)
+{
+    const uint8_t* inputs[POINTER_CHUNK];
+    uint8_t* outputs[POINTER_CHUNK];
+    for (size_t first = 0; first < count; first += POINTER_CHUNK)
+    {
+        size_t chunk = std::min<size_t>(POINTER_CHUNK, count - first);
+        for (size_t i = 0; i < chunk; i++)
+        {
+            inputs[i] = input + (first + i) * inputByteLen;
+            outputs[i] = output + (first + i) * outputByteLen;
+        }
+        KangarooTwelveBatch(inputs, inputByteLen, outputs, outputByteLen, chunk);
+    }
+}
+
+void KangarooTwelveParallel(const uint8_t* input, size_t inputByteLen, uint8_t* output, unsigned int outputByteLen, int numberOfThreads)
+{
+    if (inputByteLen < K12_chunkSize)
+    {
+        KangarooTwelve(input, unsigned(inputByteLen), output, outputByteLen);
+        return;
+    }
+
+    // The tree hashes S = input || 0x00 (empty customization string) in chunks of K12_chunkSize bytes: the first chunk
+    // goes into the final node, every other chunk is a leaf that contributes a 32-byte chaining value. All leaves but
+    // the last one (the end of the input and the 0x00) are whole chunks of the input and are hashed in parallel.
+    const size_t numberOfFullLeaves = (inputByteLen - K12_chunkSize) / K12_chunkSize;
+    const size_t numberOfLeaves = numberOfFullLeaves + 1;
+    std::vector<uint8_t> chainingValues(K12_CHAINING_VALUE_SIZE * numberOfLeaves);
+    const size_t numberOfTasks = (numberOfFullLeaves + LEAVES_PER_TASK - 1) / LEAVES_PER_TASK;
+    parallelFor(numberOfTasks, numberOfThreads, [&](size_t task)
+    {
+        const size_t first = task * LEAVES_PER_TASK;
+        const size_t count = std::min<size_t>(LEAVES_PER_TASK, numberOfFullLeaves - first);
+        const uint8_t* leaves[LEAVES_PER_TASK];
+        uint8_t* leafOutputs[LEAVES_PER_TASK];
+        for (size_t i = 0; i < count; i++)
+        {
+            leaves[i] = input + (first + i + 1) * K12_chunkSize;
+            leafOutputs[i] = &chainingValues[(first + i) * K12_CHAINING_VALUE_SIZE];
+        }
+        keccakSpongeBatch(leaves, K12_chunkSize, LEAF_SUFFIX, sizeof(LEAF_SUFFIX), leafOutputs, K12_CHAINING_VALUE_SIZE, count);
+    });
+    const size_t lastLeafOffset = (numberOfFullLeaves + 1) * K12_chunkSize;
+    const uint8_t lastLeafSuffix[2] = { 0x00, K12_suffixLeaf };
+    keccakSponge(input + lastLeafOffset, unsigned(inputByteLen - lastLeafOffset), lastLeafSuffix, sizeof(lastLeafSuffix),
+                 &chainingValues[numberOfFullLeaves * K12_CHAINING_VALUE_SIZE], K12_CHAINING_VALUE_SIZE);
+
+    // final node: first chunk || 0x03 0^7 || chaining values || length_encode(number of leaves) || 0xFF 0xFF, domain 0x06
+    KangarooTwelve_F finalNode;
+    memset(&finalNode, 0, sizeof(KangarooTwelve_F));
+    KangarooTwelve_F_Absorb(&finalNode, input, K12_chunkSize);
+    const uint8_t treeMarker[8] = { 0x03 };
+    KangarooTwelve_F_Absorb(&finalNode, treeMarker, sizeof(treeMarker));
+    KangarooTwelve_F_Absorb(&finalNode, chainingValues.data(), chainingValues.size());
+    uint8_t encodedLength[sizeof(unsigned long long) + 3];
+    unsigned int n = 0;
+    for (unsigned long long v = numberOfLeaves; v; v >>= 8)
+        n++;
+    for (unsigned int i = 0; i < n; i++)
+        encodedLength[i] = uint8_t(numberOfLeaves >> (8 * (n - 1 - i)));
+    encodedLength[n] = uint8_t(n);
+    encodedLength[n + 1] = 0xFF;
+    encodedLength[n + 2] = 0xFF;
+    KangarooTwelve_F_Absorb(&finalNode, encodedLength, n + 3);
+    finalNode.state[finalNode.byteIOIndex] ^= 0x06;
+    finalNode.state[K12_rateInBytes - 1] ^= 0x80;
+    KeccakP1600_Permute_12rounds(finalNode.state);
+    memcpy(output, finalNode.state, outputByteLen);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// KangarooTwelve of many independent inputs of the same length: outputs[i] = K12(inputs[i]) for i < count, each
+// input inputByteLen and each output outputByteLen bytes, same results as KangarooTwelve().
+// Inputs shorter than 8 KB with outputs of at most 168 bytes (one Keccak block, which covers keys, digests, Merkle
+// pairs and transaction headers) are hashed 8 at a time with AVX-512 or 4 at a time with AVX2 if the CPU supports
+// it, one Keccak state per vector lane. Everything else, and CPUs without these extensions, use KangarooTwelve()
+// one input at a time.
+void KangarooTwelveBatch(const uint8_t* const* inputs, unsigned int inputByteLen, uint8_t* const* outputs, unsigned int outputByteLen, size_t count);
+
+// Same for inputs and outputs stored back to back (input i at input + i * inputByteLen).
+void KangarooTwelveBatch(const uint8_t* input, unsigned int inputByteLen, uint8_t* output, unsigned int outputByteLen, size_t count);
+
+// KangarooTwelve of a large input, same result as KangarooTwelve() (with outputByteLen <= 200). The 8 KB leaves of the
+// KangarooTwelve tree are hashed 8 or 4 at a time with AVX-512 or AVX2, in tasks of 512 KB spread over numberOfThreads
+// threads (0 = one per core). Inputs below 8 KB have no leaves and are hashed by KangarooTwelve().
+void KangarooTwelveParallel(const uint8_t* input, size_t inputByteLen, uint8_t* output, unsigned int outputByteLen, int numberOfThreads = 0);
+
+// Name of the implementation selected for this CPU: "avx512", "avx2" or "portable".
+const char* getKangarooTwelveBatchImplementation();
@@ -0,0 +1,42 @@
+// Compiled with AVX2 enabled (see CMakeLists.txt), only called if the CPU supports it.
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+#include "k12_batch_lanes.h"
+
+namespace
+{
+
+struct Avx2Lanes
+{
+    typedef __m256i Vector;
+    enum { COUNT = 4 };
+
+    static Vector bitXor(Vector a, Vector b) { return _mm256_xor_si256(a, b); }
+    static Vector andNot(Vector a, Vector b) { return _mm256_andnot_si256(a, b); }
+    static Vector rotateLeft(Vector a, unsigned int n)
+    {
+        return _mm256_or_si256(_mm256_sllv_epi64(a, _mm256_set1_epi64x(n)), _mm256_srlv_epi64(a, _mm256_set1_epi64x(64 - n)));
+    }
+    static Vector broadcast(unsigned long long value) { return _mm256_set1_epi64x((long long)value); }
+    static Vector load(const unsigned long long* words) { return _mm256_loadu_si256((const __m256i*)words); }
+    static void store(Vector a, unsigned long long* words) { _mm256_storeu_si256((__m256i*)words, a); }
+};
+
+}
+
+bool KeccakSpongeBatchAvx2(const uint8_t* const* inputs, unsigned int inputByteLen, const uint8_t* suffix, unsigned int suffixByteLen,
+                           uint8_t* const* outputs, unsigned int outputByteLen, size_t count)
+{
+    spongeBatch<Avx2Lanes>(inputs, inputByteLen, suffix, suffixByteLen, outputs, outputByteLen, count);
+    return true;
+}
+#else
+bool KeccakSpongeBatchAvx2(const uint8_t* const*, unsigned int, const uint8_t*, unsigned int, uint8_t* const*, unsigned int, size_t)
+{
+    return false;
+}
+#endif
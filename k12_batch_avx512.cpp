@@ -0,0 +1,39 @@
+// Compiled with AVX-512F enabled (see CMakeLists.txt), only called if the CPU supports it.
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+#include "k12_batch_lanes.h"
+
+namespace
+{
+
+struct Avx512Lanes
+{
+    typedef __m512i Vector;
+    enum { COUNT = 8 };
+
+    static Vector bitXor(Vector a, Vector b) { return _mm512_xor_si512(a, b); }
+    static Vector andNot(Vector a, Vector b) { return _mm512_andnot_si512(a, b); }
+    static Vector rotateLeft(Vector a, unsigned int n) { return _mm512_rolv_epi64(a, _mm512_set1_epi64(n)); }
+    static Vector broadcast(unsigned long long value) { return _mm512_set1_epi64((long long)value); }
+    static Vector load(const unsigned long long* words) { return _mm512_loadu_si512((const void*)words); }
+    static void store(Vector a, unsigned long long* words) { _mm512_storeu_si512((void*)words, a); }
+};
+
+}
+
+bool KeccakSpongeBatchAvx512(const uint8_t* const* inputs, unsigned int inputByteLen, const uint8_t* suffix, unsigned int suffixByteLen,
+                             uint8_t* const* outputs, unsigned int outputByteLen, size_t count)
+{
+    spongeBatch<Avx512Lanes>(inputs, inputByteLen, suffix, suffixByteLen, outputs, outputByteLen, count);
+    return true;
+}
+#else
+bool KeccakSpongeBatchAvx512(const uint8_t* const*, unsigned int, const uint8_t*, unsigned int, uint8_t* const*, unsigned int, size_t)
+{
+    return false;
+}
+#endif
@@ -0,0 +1,142 @@
+#pragma once
+
+// Multi-buffer KangarooTwelve kernel, included by the kernels compiled for one instruction set (k12_batch_avx2.cpp,
+// k12_batch_avx512.cpp). Lanes provides the vector type and operations: Vector holds lane i of Lanes::COUNT Keccak
+// states. Only use intrinsics and plain C here: these files are compiled with extra instruction sets, and any inline
+// function shared with other translation units could end up with instructions the CPU does not support.
+
+#include <cstdint>
+#include <cstring>
+
+#define K12_BATCH_RATE 168
+
+namespace
+{
+
+const unsigned long long keccakRoundConstants[12] = {
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL,
+};
+
+// rotation of lane x + 5 * y
+const unsigned int keccakRhoOffsets[25] = {
+    0, 1, 62, 28, 27,
+    36, 44, 6, 55, 20,
+    3, 10, 43, 25, 39,
+    41, 45, 15, 21, 8,
+    18, 2, 61, 56, 14,
+};
+
+template <typename Lanes>
+void keccakP1600Rounds12(typename Lanes::Vector* A)
+{
+    typedef typename Lanes::Vector Vector;
+    Vector B[25], C[5], D[5];
+    for (int round = 0; round < 12; round++)
+    {
+        // theta
+        for (int x = 0; x < 5; x++)
+            C[x] = Lanes::bitXor(Lanes::bitXor(Lanes::bitXor(A[x], A[x + 5]), Lanes::bitXor(A[x + 10], A[x + 15])), A[x + 20]);
+        for (int x = 0; x < 5; x++)
+            D[x] = Lanes::bitXor(C[(x + 4) % 5], Lanes::rotateLeft(C[(x + 1) % 5], 1));
+        // rho and pi: B[y, 2x + 3y] = rot(A[x, y])
+        for (int y = 0; y < 5; y++)
+        {
+            for (int x = 0; x < 5; x++)
+                B[y + 5 * ((2 * x + 3 * y) % 5)] = Lanes::rotateLeft(Lanes::bitXor(A[x + 5 * y], D[x]), keccakRhoOffsets[x + 5 * y]);
+        }
+        // chi
+        for (int y = 0; y < 5; y++)
+        {
+            for (int x = 0; x < 5; x++)
+                A[x + 5 * y] = Lanes::bitXor(B[x + 5 * y], Lanes::andNot(B[(x + 1) % 5 + 5 * y], B[(x + 2) % 5 + 5 * y]));
+        }
+        // iota
+        A[0] = Lanes::bitXor(A[0], Lanes::broadcast(keccakRoundConstants[round]));
+    }
+}
+
+// Sponge of Keccak-p[1600, 12] with rate K12_BATCH_RATE over Lanes::COUNT inputs of inputByteLen bytes, each followed
+// by the suffix bytes (1 or 2, the last one holding the domain separation bits) and padding, squeezed into outputs of
+// outputByteLen <= K12_BATCH_RATE bytes. KangarooTwelve of an input below 8 KB is this sponge with the suffix
+// 0x00 0x07 (empty customization string), a leaf of the KangarooTwelve tree uses the suffix 0x0B.
+template <typename Lanes>
+void spongeLanes(const uint8_t* const* inputs, unsigned int inputByteLen, const uint8_t* suffix, unsigned int suffixByteLen,
+                 uint8_t* const* outputs, unsigned int outputByteLen)
+{
+    typedef typename Lanes::Vector Vector;
+    const int COUNT = Lanes::COUNT;
+    Vector A[25];
+    for (int i = 0; i < 25; i++)
+        A[i] = Lanes::broadcast(0);
+
+    unsigned long long words[COUNT];
+    const unsigned int numberOfFullBlocks = inputByteLen / K12_BATCH_RATE;
+    for (unsigned int block = 0; block < numberOfFullBlocks; block++)
+    {
+        for (int lane = 0; lane < K12_BATCH_RATE / 8; lane++)
+        {
+            for (int k = 0; k < COUNT; k++)
+                memcpy(&words[k], inputs[k] + block * K12_BATCH_RATE + 8 * lane, 8);
+            A[lane] = Lanes::bitXor(A[lane], Lanes::load(words));
+        }
+        keccakP1600Rounds12<Lanes>(A);
+    }
+
+    // rest of the input, the suffix, zero padding, 0x80 in the last byte; this takes a second block if the suffix does
+    // not fit in the first one
+    uint8_t tail[COUNT][2 * K12_BATCH_RATE];
+    const unsigned int offset = numberOfFullBlocks * K12_BATCH_RATE;
+    const unsigned int rest = inputByteLen - offset;
+    const unsigned int tailByteLen = (rest + suffixByteLen <= K12_BATCH_RATE) ? K12_BATCH_RATE : 2 * K12_BATCH_RATE;
+    for (int k = 0; k < COUNT; k++)
+    {
+        memset(tail[k], 0, tailByteLen);
+        memcpy(tail[k], inputs[k] + offset, rest);
+        for (unsigned int i = 0; i < suffixByteLen; i++)
+            tail[k][rest + i] ^= suffix[i];
+        tail[k][tailByteLen - 1] ^= 0x80;
+    }
+    for (unsigned int block = 0; block < tailByteLen / K12_BATCH_RATE; block++)
+    {
+        for (int lane = 0; lane < K12_BATCH_RATE / 8; lane++)
+        {
+            for (int k = 0; k < COUNT; k++)
+                memcpy(&words[k], tail[k] + block * K12_BATCH_RATE + 8 * lane, 8);
+            A[lane] = Lanes::bitXor(A[lane], Lanes::load(words));
+        }
+        keccakP1600Rounds12<Lanes>(A);
+    }
+
+    for (unsigned int lane = 0; lane * 8 < outputByteLen; lane++)
+    {
+        Lanes::store(A[lane], words);
+        unsigned int bytes = (outputByteLen - lane * 8 < 8) ? outputByteLen - lane * 8 : 8;
+        for (int k = 0; k < COUNT; k++)
+            memcpy(outputs[k] + lane * 8, &words[k], bytes);
+    }
+}
+
+// Sponge of count inputs, Lanes::COUNT at a time. A partial last group repeats its first input in the unused lanes.
+template <typename Lanes>
+void spongeBatch(const uint8_t* const* inputs, unsigned int inputByteLen, const uint8_t* suffix, unsigned int suffixByteLen,
+                 uint8_t* const* outputs, unsigned int outputByteLen, size_t count)
+{
+    const int COUNT = Lanes::COUNT;
+    uint8_t discarded[COUNT][K12_BATCH_RATE];
+    for (size_t first = 0; first < count; first += COUNT)
+    {
+        const uint8_t* groupInputs[COUNT];
+        uint8_t* groupOutputs[COUNT];
+        for (int k = 0; k < COUNT; k++)
+        {
+            bool used = first + k < count;
+            groupInputs[k] = inputs[used ? first + k : first];
+            groupOutputs[k] = used ? outputs[first + k] : discarded[k];
+        }
+        spongeLanes<Lanes>(groupInputs, inputByteLen, suffix, suffixByteLen, groupOutputs, outputByteLen);
+    }
+}
+
+}
@@ -1,7 +1,11 @@
+#include <algorithm>
+#include <cctype>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 
 #include "k12_and_key_utils.h"
+#include "k12_batch.h"
 #include "logger.h"
 
 bool getSubseedFromSeed(const uint8_t* seed, uint8_t* subseed)
@@ -32,30 +36,95 @@ void getPublicKeyFromPrivateKey(const uint8_t* privateKey, uint8_t* publicKey)
     encode(P, publicKey);
 }
 
-void getIdentityFromPublicKey(const uint8_t* pubkey, char* dstIdentity, bool isLowerCase)
+// Base-26 conversion of a 64-bit fragment (14 letters, least significant first). The fragment is split into limbs
+// of 6, 6 and 2 letters below 26^6 < 2^32, so every letter takes a 32-bit multiplication by the reciprocal of 26
+// instead of a 64-bit one, and the three limbs are independent chains.
+#define POWER_26_6 308915776u
+
+// identities converted together, so their checksums can be hashed by the multi-buffer KangarooTwelve
+#define IDENTITY_BATCH_SIZE 64
+
+static void encodeLimb(uint32_t limb, int numberOfLetters, char base, char* dst)
+{
+    for (int j = 0; j < numberOfLetters; j++)
+    {
+        uint32_t quotient = uint32_t((uint64_t(limb) * 0x4EC4EC4Fu) >> 35); // limb / 26
+        dst[j] = char(limb - quotient * 26 + base);
+        limb = quotient;
+    }
+}
+
+static void encodeIdentity(const uint8_t* publicKey, unsigned int identityBytesChecksum, char* dstIdentity, bool isLowerCase)
 {
-    uint8_t publicKey[32] ;
-    memcpy(publicKey, pubkey, 32);
-    uint16_t identity[61] = {0};
+    const char base = isLowerCase ? 'a' : 'A';
     for (int i = 0; i < 4; i++)
     {
-        unsigned long long publicKeyFragment = *((unsigned long long*)&publicKey[i << 3]);
-        for (int j = 0; j < 14; j++)
-        {
-            identity[i * 14 + j] = publicKeyFragment % 26 + (isLowerCase ? L'a' : L'A');
-            publicKeyFragment /= 26;
-        }
+        unsigned long long publicKeyFragment;
+        memcpy(&publicKeyFragment, &publicKey[i << 3], 8);
+        unsigned long long high = publicKeyFragment / POWER_26_6;
+        encodeLimb(uint32_t(publicKeyFragment - high * POWER_26_6), 6, base, dstIdentity + i * 14);
+        encodeLimb(uint32_t(high % POWER_26_6), 6, base, dstIdentity + i * 14 + 6);
+        encodeLimb(uint32_t(high / POWER_26_6), 2, base, dstIdentity + i * 14 + 12);
     }
-    unsigned int identityBytesChecksum;
-    KangarooTwelve(publicKey, 32, (uint8_t*)&identityBytesChecksum, 3);
-    identityBytesChecksum &= 0x3FFFF;
+    encodeLimb(identityBytesChecksum & 0x3FFFF, 4, base, dstIdentity + 56);
+}
+
+static bool decodeLimb(const char* src, int numberOfLetters, uint32_t& limb)
+{
+    limb = 0;
+    for (int j = numberOfLetters; j-- > 0; )
+    {
+        if (src[j] < 'A' || src[j] > 'Z')
+            return false;
+        limb = limb * 26 + uint32_t(src[j] - 'A');
+    }
+    return true;
+}
+
+// Public key of the first 56 letters of an uppercase identity. Return false if one of them is not in A..Z.
+static bool decodeIdentity(const char* identity, uint8_t* publicKey)
+{
     for (int i = 0; i < 4; i++)
     {
-        identity[56 + i] = identityBytesChecksum % 26 + (isLowerCase ? L'a' : L'A');
-        identityBytesChecksum /= 26;
+        uint32_t low, middle, high;
+        if (!decodeLimb(identity + i * 14, 6, low) || !decodeLimb(identity + i * 14 + 6, 6, middle) || !decodeLimb(identity + i * 14 + 12, 2, high))
+            return false;
+        // same value modulo 2^64 as evaluating all 14 letters in 64 bits
+        unsigned long long publicKeyFragment = ((unsigned long long)high * POWER_26_6 + middle) * POWER_26_6 + low;
+        memcpy(&publicKey[i << 3], &publicKeyFragment, 8);
+    }
+    return true;
+}
+
+static bool checksumMatches(const char* identity, unsigned int identityBytesChecksum)
+{
+    char expected[4];
+    encodeLimb(identityBytesChecksum & 0x3FFFF, 4, 'A', expected);
+    return memcmp(expected, identity + 56, 4) == 0;
+}
+
+void getIdentityFromPublicKey(const uint8_t* pubkey, char* dstIdentity, bool isLowerCase)
+{
+    unsigned int identityBytesChecksum = 0;
+    KangarooTwelve(pubkey, 32, (uint8_t*)&identityBytesChecksum, 3);
+    encodeIdentity(pubkey, identityBytesChecksum, dstIdentity, isLowerCase);
+}
+
+void getIdentitiesFromPublicKeys(const uint8_t* publicKeys, size_t count, char* identities, bool isLowerCase)
+{
+    uint8_t checksums[IDENTITY_BATCH_SIZE][4];
+    for (size_t first = 0; first < count; first += IDENTITY_BATCH_SIZE)
+    {
+        size_t n = std::min<size_t>(IDENTITY_BATCH_SIZE, count - first);
+        KangarooTwelveBatch(publicKeys + 32 * first, 32, &checksums[0][0], 4, n);
+        for (size_t i = 0; i < n; i++)
+        {
+            unsigned int identityBytesChecksum;
+            memcpy(&identityBytesChecksum, checksums[i], 4);
+            encodeIdentity(publicKeys + 32 * (first + i), identityBytesChecksum, identities + 61 * (first + i), isLowerCase);
+            identities[61 * (first + i) + 60] = 0;
+        }
     }
-    identity[60] = 0;
-    for (int i = 0; i < 60; i++) dstIdentity[i] = char(identity[i]);
 }
 
 void getTxHashFromDigest(const uint8_t* digest, char* txHash)
@@ -64,53 +133,60 @@ void getTxHashFromDigest(const uint8_t* digest, char* txHash)
     getIdentityFromPublicKey(digest, txHash, isLowerCase);
 }
 
+void getDigestFromTxHash(const char* txHash, uint8_t* digest)
+{
+    char identity[61] = {0};
+    for (int i = 0; i < 60; i++)
+        identity[i] = char(toupper(txHash[i]));
+    memset(digest, 0, 32);
+    getPublicKeyFromIdentity(identity, digest);
+}
+
 void getPublicKeyFromIdentity(const char* identity, uint8_t* publicKey)
 {
     unsigned char publicKeyBuffer[32];
-    for (int i = 0; i < 4; i++)
-    {
-        *((unsigned long long*)&publicKeyBuffer[i << 3]) = 0;
-        for (int j = 14; j-- > 0; )
-        {
-            if (identity[i * 14 + j] < 'A' || identity[i * 14 + j] > 'Z')
-            {
-                return;
-            }
-
-            *((unsigned long long*)&publicKeyBuffer[i << 3]) = *((unsigned long long*)&publicKeyBuffer[i << 3]) * 26 + (identity[i * 14 + j] - 'A');
-        }
-    }
-    memcpy(publicKey, publicKeyBuffer, 32);
+    if (decodeIdentity(identity, publicKeyBuffer))
+        memcpy(publicKey, publicKeyBuffer, 32);
 }
 
 bool checkSumIdentity(const char* identity)
 {
     unsigned char publicKeyBuffer[32];
-    for (int i = 0; i < 4; i++)
+    if (!decodeIdentity(identity, publicKeyBuffer))
+        return false;
+    unsigned int identityBytesChecksum = 0;
+    KangarooTwelve(publicKeyBuffer, 32, (unsigned char*)&identityBytesChecksum, 3);
+    return checksumMatches(identity, identityBytesChecksum);
+}
+
+size_t getPublicKeysFromIdentities(const char* identities, size_t count, uint8_t* publicKeys, uint8_t* valid)
+{
+    size_t numberOfValid = 0;
+    uint8_t checksums[IDENTITY_BATCH_SIZE][4];
+    bool decoded[IDENTITY_BATCH_SIZE];
+    for (size_t first = 0; first < count; first += IDENTITY_BATCH_SIZE)
     {
-        *((unsigned long long*) & publicKeyBuffer[i << 3]) = 0;
-        for (int j = 14; j-- > 0; )
+        size_t n = std::min<size_t>(IDENTITY_BATCH_SIZE, count - first);
+        for (size_t i = 0; i < n; i++)
         {
-            if (identity[i * 14 + j] < 'A' || identity[i * 14 + j] > 'Z')
-            {
-                return false;
-            }
-
-            *((unsigned long long*) & publicKeyBuffer[i << 3]) = *((unsigned long long*) & publicKeyBuffer[i << 3]) * 26 + (identity[i * 14 + j] - 'A');
+            decoded[i] = decodeIdentity(identities + 61 * (first + i), publicKeys + 32 * (first + i));
+            if (!decoded[i])
+                memset(publicKeys + 32 * (first + i), 0, 32);
         }
-    }
-    unsigned int identityBytesChecksum;
-    KangarooTwelve(publicKeyBuffer, 32, (unsigned char*)&identityBytesChecksum, 3);
-    identityBytesChecksum &= 0x3FFFF;
-    for (int i = 0; i < 4; i++)
-    {
-        if (identityBytesChecksum % 26 + 'A' != identity[56 + i])
+        KangarooTwelveBatch(publicKeys + 32 * first, 32, &checksums[0][0], 4, n);
+        for (size_t i = 0; i < n; i++)
         {
-            return false;
+            unsigned int identityBytesChecksum;
+            memcpy(&identityBytesChecksum, checksums[i], 4);
+            bool isValid = decoded[i] && checksumMatches(identities + 61 * (first + i), identityBytesChecksum);
+            if (!isValid)
+                memset(publicKeys + 32 * (first + i), 0, 32);
+            if (valid)
+                valid[first + i] = isValid ? 1 : 0;
+            numberOfValid += isValid ? 1 : 0;
         }
-        identityBytesChecksum /= 26;
     }
-    return true;
+    return numberOfValid;
 }
 
 template <unsigned int hashByteLen>
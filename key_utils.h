@@ -4,9 +4,17 @@ bool getSubseedFromSeed(const uint8_t* seed, uint8_t* subseed);
 void getPrivateKeyFromSubSeed(const uint8_t* seed, uint8_t* privateKey);
 void getPublicKeyFromPrivateKey(const uint8_t* privateKey, uint8_t* publicKey);
 void getIdentityFromPublicKey(const uint8_t* pubkey, char* identity, bool isLowerCase);
+// Identities of count back to back 32-byte public keys, written to identities as 61-byte zero-terminated strings.
+void getIdentitiesFromPublicKeys(const uint8_t* publicKeys, size_t count, char* identities, bool isLowerCase);
 void getTxHashFromDigest(const uint8_t* digest, char* txHash);
+// Digest of a (lowercase) transaction hash, the inverse of getTxHashFromDigest().
+void getDigestFromTxHash(const char* txHash, uint8_t* digest);
 void getPublicKeyFromIdentity(const char* identity, uint8_t* publicKey);
 bool checkSumIdentity(const char* identity);
+// Public keys of count uppercase identities stored 61 bytes apart (as written by getIdentitiesFromPublicKeys), written
+// back to back. valid (optional, count bytes) is set to 1 for identities with valid letters and checksum, the public
+// key of any other identity is zero. Return the number of valid identities.
+size_t getPublicKeysFromIdentities(const char* identities, size_t count, uint8_t* publicKeys, uint8_t* valid);
 
 // Compute the digest (root hash) from siblings of Merkle tree
 template <unsigned int hashByteLen>
@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <cstring>
+
+#include "lz_codec.h"
+
+#define QLZ_MAGIC "QLZ1"
+#define QLZ_MAX_EXTENSION 7
+#define QLZ_STORED_FLAG 0x80000000u
+#define MIN_MATCH 4
+#define MAX_OFFSET 65535
+#define HASH_BITS 16
+#define MAX_CHAIN_DEPTH 8
+// stop searching once a match is this long
+#define GOOD_MATCH 64
+// the last bytes of a block are always literals, so matching never reads past the end
+#define LAST_LITERALS 12
+
+static uint32_t read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static void write32(uint8_t* p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = uint8_t(v >> (8 * i));
+}
+
+static uint32_t load32(const uint8_t* p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static uint32_t hashOf(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static uint8_t* writeLength(uint8_t* op, size_t length)
+{
+    while (length >= 255)
+    {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = uint8_t(length);
+    return op;
+}
+
+static uint8_t* writeSequence(uint8_t* op, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength)
+{
+    uint8_t* token = op++;
+    *token = uint8_t((literalLength >= 15 ? 15 : literalLength) << 4);
+    if (literalLength >= 15)
+        op = writeLength(op, literalLength - 15);
+    memcpy(op, literals, literalLength);
+    op += literalLength;
+    if (matchLength)
+    {
+        *op++ = uint8_t(offset);
+        *op++ = uint8_t(offset >> 8);
+        size_t length = matchLength - MIN_MATCH;
+        *token |= uint8_t(length >= 15 ? 15 : length);
+        if (length >= 15)
+            op = writeLength(op, length - 15);
+    }
+    return op;
+}
+
+// Worst case output size of compressBlock.
+static size_t compressBound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+// Compress src into dst (at least compressBound(size) bytes). Return the compressed size.
+// Matches are searched along hash chains (up to MAX_CHAIN_DEPTH candidates within the 64 KB window), since the
+// data is written to chain once and the ratio matters more than compression speed.
+static size_t compressBlock(const uint8_t* src, size_t size, uint8_t* dst, std::vector<int32_t>& head, std::vector<int32_t>& chain)
+{
+    head.assign(size_t(1) << HASH_BITS, -1);
+    chain.resize(size);
+    uint8_t* op = dst;
+    size_t anchor = 0;
+    if (size > LAST_LITERALS)
+    {
+        const size_t limit = size - LAST_LITERALS;
+        auto insert = [&](size_t position)
+        {
+            uint32_t h = hashOf(read32(src + position));
+            chain[position] = head[h];
+            head[h] = int32_t(position);
+        };
+        auto findMatch = [&](size_t position, size_t& bestOffset) -> size_t
+        {
+            size_t bestLength = 0;
+            int32_t candidate = head[hashOf(read32(src + position))];
+            for (int depth = 0; candidate >= 0 && depth < MAX_CHAIN_DEPTH; depth++, candidate = chain[candidate])
+            {
+                if (position - size_t(candidate) > MAX_OFFSET)
+                    break;
+                // a candidate can only be better if it also matches at the current best length
+                if (bestLength && (position + bestLength >= limit || src[candidate + bestLength] != src[position + bestLength]))
+                    continue;
+                size_t length = 0;
+                while (position + length < limit && src[candidate + length] == src[position + length])
+                    length++;
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestOffset = position - size_t(candidate);
+                    if (length >= GOOD_MATCH)
+                        break;
+                }
+            }
+            return (bestLength >= MIN_MATCH) ? bestLength : 0;
+        };
+
+        size_t ip = 0;
+        while (ip < limit)
+        {
+            size_t offset = 0;
+            size_t matchLength = findMatch(ip, offset);
+            insert(ip);
+            if (!matchLength)
+            {
+                ip++;
+                continue;
+            }
+            // lazy matching: prefer a longer match starting at the next byte
+            if (matchLength < GOOD_MATCH && ip + 1 < limit)
+            {
+                size_t nextOffset = 0;
+                size_t nextLength = findMatch(ip + 1, nextOffset);
+                if (nextLength > matchLength + 1)
+                {
+                    insert(ip + 1);
+                    ip++;
+                    matchLength = nextLength;
+                    offset = nextOffset;
+                }
+            }
+            op = writeSequence(op, src + anchor, ip - anchor, offset, matchLength);
+            for (size_t i = ip + 1; i < ip + matchLength && i < limit; i++)
+                insert(i);
+            ip += matchLength;
+            anchor = ip;
+        }
+    }
+    op = writeSequence(op, src + anchor, size - anchor, 0, 0);
+    return size_t(op - dst);
+}
+
+static bool readLength(const uint8_t*& ip, const uint8_t* end, size_t& length)
+{
+    uint8_t b;
+    do
+    {
+        if (ip >= end)
+            return false;
+        b = *ip++;
+        length += b;
+    } while (b == 255);
+    return true;
+}
+
+// Decompress exactly rawSize bytes from src into dst. Return false on malformed input.
+static bool decompressBlock(const uint8_t* src, size_t size, uint8_t* dst, size_t rawSize)
+{
+    const uint8_t* ip = src;
+    const uint8_t* end = src + size;
+    uint8_t* op = dst;
+    uint8_t* opEnd = dst + rawSize;
+    while (ip < end)
+    {
+        uint8_t token = *ip++;
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(ip, end, literalLength))
+            return false;
+        if (literalLength > size_t(end - ip) || literalLength > size_t(opEnd - op))
+            return false;
+        memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+        if (ip == end)
+            break; // last sequence has literals only
+
+        if (end - ip < 2)
+            return false;
+        size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+        ip += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(ip, end, matchLength))
+            return false;
+        matchLength += MIN_MATCH;
+        if (offset == 0 || offset > size_t(op - dst) || matchLength > size_t(opEnd - op))
+            return false;
+        const uint8_t* match = op - offset;
+        for (size_t i = 0; i < matchLength; i++)
+            op[i] = match[i]; // may overlap
+        op += matchLength;
+    }
+    return op == opEnd;
+}
+
+QlzCompressor::QlzCompressor(const std::string& extension, uint64_t originalSize, QlzSink sink) : mSink(std::move(sink))
+{
+    uint8_t header[4 + 1 + QLZ_MAX_EXTENSION + 8];
+    size_t extensionLength = std::min(extension.size(), size_t(QLZ_MAX_EXTENSION));
+    memcpy(header, QLZ_MAGIC, 4);
+    header[4] = uint8_t(extensionLength);
+    memcpy(header + 5, extension.data(), extensionLength);
+    for (int i = 0; i < 8; i++)
+        header[5 + extensionLength + i] = uint8_t(originalSize >> (8 * i));
+    mSink(header, 5 + extensionLength + 8);
+    mInput.reserve(QLZ_BLOCK_SIZE);
+}
+
+void QlzCompressor::write(const uint8_t* data, size_t size)
+{
+    while (size)
+    {
+        size_t chunk = std::min(size, QLZ_BLOCK_SIZE - mInput.size());
+        mInput.insert(mInput.end(), data, data + chunk);
+        data += chunk;
+        size -= chunk;
+        if (mInput.size() == QLZ_BLOCK_SIZE)
+            flushBlock();
+    }
+}
+
+void QlzCompressor::flushBlock()
+{
+    if (mInput.empty())
+        return;
+    mOutput.resize(8 + compressBound(mInput.size()));
+    size_t compressedSize = compressBlock(mInput.data(), mInput.size(), mOutput.data() + 8, mHashHead, mHashChain);
+    uint32_t storedSize = uint32_t(compressedSize);
+    if (compressedSize >= mInput.size())
+    {
+        memcpy(mOutput.data() + 8, mInput.data(), mInput.size());
+        storedSize = uint32_t(mInput.size()) | QLZ_STORED_FLAG;
+        compressedSize = mInput.size();
+    }
+    write32(mOutput.data(), storedSize);
+    write32(mOutput.data() + 4, uint32_t(mInput.size()));
+    mSink(mOutput.data(), 8 + compressedSize);
+    mInput.clear();
+}
+
+void QlzCompressor::finish()
+{
+    flushBlock();
+    uint8_t terminator[8] = {0};
+    mSink(terminator, sizeof(terminator));
+}
+
+QlzDecompressor::QlzDecompressor(QlzSink sink)
+    : mSink(std::move(sink)), mOriginalSize(0), mOutputSize(0), mHeaderParsed(false), mFinished(false), mCorrupt(false)
+{
+}
+
+bool QlzDecompressor::write(const uint8_t* data, size_t size)
+{
+    if (mCorrupt)
+        return false;
+    if (mFinished)
+        return size == 0;
+    mPending.insert(mPending.end(), data, data + size);
+    size_t consumed = 0;
+    while (!mFinished)
+    {
+        const uint8_t* p = mPending.data() + consumed;
+        size_t available = mPending.size() - consumed;
+        if (!mHeaderParsed)
+        {
+            if (available < 5)
+                break;
+            if (memcmp(p, QLZ_MAGIC, 4) != 0 || p[4] > QLZ_MAX_EXTENSION)
+            {
+                mCorrupt = true;
+                return false;
+            }
+            size_t headerSize = 5 + p[4] + 8;
+            if (available < headerSize)
+                break;
+            mExtension.assign((const char*)p + 5, p[4]);
+            mOriginalSize = 0;
+            for (int i = 0; i < 8; i++)
+                mOriginalSize |= uint64_t(p[5 + p[4] + i]) << (8 * i);
+            mHeaderParsed = true;
+            consumed += headerSize;
+            continue;
+        }
+
+        if (available < 8)
+            break;
+        uint32_t storedSize = load32(p);
+        uint32_t rawSize = load32(p + 4);
+        bool stored = (storedSize & QLZ_STORED_FLAG) != 0;
+        storedSize &= ~QLZ_STORED_FLAG;
+        if (storedSize == 0 && rawSize == 0)
+        {
+            consumed += 8;
+            mFinished = true;
+            if (mOutputSize != mOriginalSize)
+            {
+                mCorrupt = true;
+                return false;
+            }
+            break;
+        }
+        if (rawSize > QLZ_BLOCK_SIZE || storedSize > compressBound(QLZ_BLOCK_SIZE) || (stored && storedSize != rawSize))
+        {
+            mCorrupt = true;
+            return false;
+        }
+        if (available < 8 + size_t(storedSize))
+            break;
+        if (stored)
+        {
+            mSink(p + 8, rawSize);
+        }
+        else
+        {
+            mBlock.resize(rawSize);
+            if (!decompressBlock(p + 8, storedSize, mBlock.data(), rawSize))
+            {
+                mCorrupt = true;
+                return false;
+            }
+            mSink(mBlock.data(), rawSize);
+        }
+        mOutputSize += rawSize;
+        consumed += 8 + size_t(storedSize);
+    }
+    mPending.erase(mPending.begin(), mPending.begin() + consumed);
+    return true;
+}
+
+bool isQlzStream(const uint8_t* data, size_t size)
+{
+    return size >= 4 && memcmp(data, QLZ_MAGIC, 4) == 0;
+}
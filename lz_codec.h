@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Built-in streaming LZ77 codec for file upload/download ("qlz" file format).
+//
+// Stream layout: "QLZ1", extension length (1 byte), extension of the original file (up to 7 bytes), original size
+// (8 bytes), then blocks of up to QLZ_BLOCK_SIZE input bytes, each with stored size (4 bytes, bit 31 set if the
+// block is stored uncompressed) and raw size (4 bytes), and an empty block (8 zero bytes) as terminator.
+// Blocks are compressed independently with an LZ4-style sequence format (64 KB window), so a stream can be produced
+// and consumed block by block. All integers are little endian.
+
+#define QLZ_FILE_FORMAT "qlz"
+#define QLZ_BLOCK_SIZE (1 << 20)
+
+// Receives output as it is produced.
+typedef std::function<void(const uint8_t* data, size_t size)> QlzSink;
+
+class QlzCompressor
+{
+public:
+    QlzCompressor(const std::string& extension, uint64_t originalSize, QlzSink sink);
+
+    // Compress the next part of the input. Full blocks are passed to the sink immediately.
+    void write(const uint8_t* data, size_t size);
+
+    // Flush the last block and write the terminator.
+    void finish();
+
+private:
+    void flushBlock();
+
+    QlzSink mSink;
+    std::vector<uint8_t> mInput;
+    std::vector<uint8_t> mOutput;
+    std::vector<int32_t> mHashHead;
+    std::vector<int32_t> mHashChain;
+};
+
+class QlzDecompressor
+{
+public:
+    explicit QlzDecompressor(QlzSink sink);
+
+    // Decompress the next part of the stream. Return false if the stream is corrupt.
+    bool write(const uint8_t* data, size_t size);
+
+    // Whether the terminator was reached and the output size matches the size in the stream header.
+    bool finished() const { return mFinished; }
+
+    // Extension of the original file, available once the stream header is parsed.
+    const std::string& extension() const { return mExtension; }
+
+private:
+    std::vector<uint8_t> mPending;
+    std::vector<uint8_t> mBlock;
+    QlzSink mSink;
+    std::string mExtension;
+    uint64_t mOriginalSize;
+    uint64_t mOutputSize;
+    bool mHeaderParsed;
+    bool mFinished;
+    bool mCorrupt;
+};
+
+// Whether the data starts like a qlz stream.
+bool isQlzStream(const uint8_t* data, size_t size);
@@ -17,9 +17,16 @@
 #include "qearn.h"
 #include "qvault.h"
 #include "msvault.h"
+#include "multi_node.h"
 #include "qswap.h"
 #include "test_utils.h"
 #include "nostromo.h"
+#include "benchmark.h"
+#include "merkle_tree.h"
+#include "tick_archive.h"
+#include "quorum_range.h"
+#include "tick_follower.h"
+#include "tick_verifier.h"
 
 int run(int argc, char* argv[])
 {
@@ -46,6 +53,11 @@ int run(int argc, char* argv[])
             sanityCheckNode(g_nodeIp, g_nodePort);
             printBalance(g_requestedIdentity, g_nodeIp, g_nodePort);
             break;
+        case GET_BALANCES:
+            sanityFileExist(g_requestedFileName);
+            sanityCheckNode(g_nodeIp, g_nodePort);
+            printBalances(g_requestedFileName, g_nodeIp, g_nodePort);
+            break;
         case GET_ASSET:
             sanityCheckIdentity(g_requestedIdentity);
             sanityCheckNode(g_nodeIp, g_nodePort);
@@ -104,14 +116,37 @@ int run(int argc, char* argv[])
             sanityCheckNode(g_nodeIp, g_nodePort);
             getTickDataToFile(g_nodeIp, g_nodePort, g_requestedTickNumber, g_requestedFileName);
             break;
+        case GET_TICK_RANGE:
+            sanityCheckNode(g_nodeIp, g_nodePort);
+            downloadTickRange(g_nodeIp, g_nodePort, g_requestedTickNumber, g_requestedEndTickNumber, g_requestedFileName, g_numberOfThreads);
+            break;
+        case EXTRACT_TICK_FROM_ARCHIVE:
+            sanityFileExist(g_requestedFileName);
+            extractTickFromArchive(g_requestedFileName, g_requestedTickNumber, g_requestedFileName2);
+            break;
+        case FOLLOW_TICKS:
+            sanityCheckNode(g_nodeIp, g_nodePort);
+            followTicks(g_nodeIp, g_nodePort, g_requestedTickNumber, g_requestedFileName, strcmp(g_paramString1, "binary") == 0);
+            break;
         case GET_QUORUM_TICK:
             sanityCheckNode(g_nodeIp, g_nodePort);
             getQuorumTick(g_nodeIp, g_nodePort, g_requestedTickNumber, g_requestedFileName);
             break;
+        case GET_QUORUM_RANGE:
+            sanityCheckNode(g_nodeIp, g_nodePort);
+            analyzeQuorumRange(g_nodeIp, g_nodePort, g_requestedFileName, g_requestedTickNumber, g_requestedEndTickNumber, g_numberOfThreads);
+            break;
         case READ_TICK_DATA:
             sanityFileExist(g_requestedFileName);
+            if (strcmp(g_requestedFileName2, "-") != 0)
+                sanityFileExist(g_requestedFileName2);
+            printTickDataFromFile(g_requestedFileName, g_requestedFileName2, g_nodeIp, g_nodePort);
+            break;
+        case VERIFY_TICK_FILES:
+            if (strcmp(g_requestedFileName, "-") != 0)
+                sanityFileExist(g_requestedFileName);
             sanityFileExist(g_requestedFileName2);
-            printTickDataFromFile(g_requestedFileName, g_requestedFileName2);
+            verifyTickFilesFromList(g_requestedFileName, g_requestedFileName2, g_numberOfThreads, g_nodeIp, g_nodePort);
             break;
         case CHECK_TX_ON_FILE:
             sanityFileExist(g_requestedFileName);
@@ -225,6 +260,10 @@ int run(int argc, char* argv[])
             sanityCheckNode(g_nodeIp, g_nodePort);
             getNodeIpList(g_nodeIp, g_nodePort);
             break;
+        case COMPARE_NODES:
+            sanityCheckNode(g_nodeIp, g_nodePort);
+            compareNodes(g_nodeIp, g_nodePort, g_paramString1, g_paramString2, g_requestedIdentity);
+            break;
         case UPLOAD_FILE:
             sanityCheckNode(g_nodeIp, g_nodePort);
             sanityCheckSeed(g_seed);
@@ -245,6 +284,18 @@ int run(int argc, char* argv[])
             sanityCheckValidString(g_dumpBinaryFileOutput);
             dumpUniverseToCSV(g_dumpBinaryFileInput, g_dumpBinaryFileOutput);
             break;
+        case SPECTRUM_DIGEST_OF_FILE:
+            sanityFileExist(g_dumpBinaryFileInput);
+            printSpectrumDigestOfFile(g_dumpBinaryFileInput, g_dumpBinaryFileOutput);
+            break;
+        case UNIVERSE_DIGEST_OF_FILE:
+            sanityFileExist(g_dumpBinaryFileInput);
+            printUniverseDigestOfFile(g_dumpBinaryFileInput, g_dumpBinaryFileOutput);
+            break;
+        case MERKLE_PROOF_FROM_FILE:
+            sanityFileExist(g_dumpBinaryFileInput);
+            printMerkleProofFromTreeFile(g_dumpBinaryFileInput, size_t(g_merkleLeafIndex));
+            break;
         case DUMP_CONTRACT_FILE:
             sanityFileExist(g_dumpBinaryFileInput);
             sanityCheckValidString(g_dumpBinaryFileOutput);
@@ -1031,6 +1082,10 @@ int run(int argc, char* argv[])
             testBidInIpoThroughContract(g_nodeIp, g_nodePort, g_seed, g_paramString1, g_IPOContractIndex, g_makeIPOBidPricePerShare, g_makeIPOBidNumberOfShare, g_offsetScheduledTick);
             break;
         }
+        case RUN_BENCHMARK:
+            sanityCheckNode(g_nodeIp, g_nodePort);
+            runBenchmark(g_nodeIp, g_nodePort, g_paramString1, g_paramString2);
+            break;
         default:
             printf("Unexpected command!\n");
             break;
@@ -0,0 +1,98 @@
+#ifdef _MSC_VER
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+bool MappedFile::open(const char* fileName, bool sequential)
+{
+    close();
+#ifdef _MSC_VER
+    HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    mFileHandle = file;
+    mMappingHandle = mapping;
+    mData = (const uint8_t*)view;
+    mSize = size_t(fileSize.QuadPart);
+#else
+    int fd = ::open(fileName, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file open
+    if (view == MAP_FAILED)
+        return false;
+    if (sequential)
+        madvise(view, size_t(status.st_size), MADV_SEQUENTIAL);
+    mData = (const uint8_t*)view;
+    mSize = size_t(status.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (!mData)
+        return;
+#ifdef _MSC_VER
+    UnmapViewOfFile(mData);
+    CloseHandle(mMappingHandle);
+    CloseHandle(mFileHandle);
+    mFileHandle = mMappingHandle = nullptr;
+#else
+    munmap((void*)mData, mSize);
+#endif
+    mData = nullptr;
+    mSize = 0;
+}
+
+void MappedFile::release(size_t offset, size_t length) const
+{
+    if (!mData || offset >= mSize)
+        return;
+    if (length > mSize - offset)
+        length = mSize - offset;
+#ifdef _MSC_VER
+    // unlocking pages that are not locked removes them from the working set (the call reports an error)
+    VirtualUnlock((LPVOID)(mData + offset), length);
+#else
+    // madvise wants page aligned ranges, pages partially outside of the range are kept
+    const size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+    size_t begin = (offset + pageSize - 1) / pageSize * pageSize;
+    size_t end = (offset + length == mSize) ? mSize : (offset + length) / pageSize * pageSize;
+    if (end > begin)
+        madvise((void*)(mData + begin), end - begin, MADV_DONTNEED);
+#endif
+}
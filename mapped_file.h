@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "structs.h"
+
+// Read-only memory mapping of a whole file. Pages are loaded on first access and shared with every other process
+// mapping the same file, so opening a multi-GB snapshot is instant and costs no private memory.
+class MappedFile
+{
+public:
+    MappedFile() : mData(nullptr), mSize(0)
+#ifdef _MSC_VER
+        , mFileHandle(nullptr), mMappingHandle(nullptr)
+#endif
+    {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map fileName. If sequential is set, the kernel is told the file will be read front to back, so it reads ahead
+    // aggressively. Return false if the file cannot be opened, is empty or cannot be mapped.
+    bool open(const char* fileName, bool sequential = false);
+    void close();
+
+    const uint8_t* data() const { return mData; }
+    size_t size() const { return mSize; }
+
+    // Drop the pages of [offset, offset + length) from the resident set of this process. The content stays valid and
+    // is read again from the file (or the page cache) on the next access. Used to scan large files with flat RSS.
+    void release(size_t offset, size_t length) const;
+
+private:
+    const uint8_t* mData;
+    size_t mSize;
+#ifdef _MSC_VER
+    void* mFileHandle;
+    void* mMappingHandle;
+#endif
+};
+
+// Typed view of a mapped file holding records of type T back to back. A trailing partial record is ignored.
+template <typename T>
+class MappedArray
+{
+public:
+    bool open(const char* fileName, bool sequential = false) { return mFile.open(fileName, sequential); }
+
+    size_t size() const { return mFile.size() / sizeof(T); }
+    const T* data() const { return (const T*)mFile.data(); }
+    const T& operator[](size_t index) const { return data()[index]; }
+
+    // Drop records [first, first + count) from the resident set, see MappedFile::release().
+    void release(size_t first, size_t count) const { mFile.release(first * sizeof(T), count * sizeof(T)); }
+
+private:
+    MappedFile mFile;
+};
+
+// spectrum.XXX as saved by the node: 2^24 entities
+typedef MappedArray<Entity> MappedSpectrum;
+// universe.XXX as saved by the node: 2^24 asset records
+typedef MappedArray<AssetRecord> MappedUniverse;
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "defines.h"
+#include "k12_batch.h"
+#include "logger.h"
+#include "mapped_file.h"
+#include "merkle_tree.h"
+#include "parallel.h"
+#include "structs.h"
+#include "utils.h"
+
+#define MERKLE_TREE_MAGIC "QMT1"
+// nodes of one level hashed by one task
+#define NODES_PER_TASK 4096
+// the node keeps 2^24 spectrum entities and 2^24 asset records
+#define MERKLE_FILE_CAPACITY 0x1000000ULL
+
+size_t MerkleTree::levelOffset(unsigned int level) const
+{
+    // levels are stored leaves first, level l has 2^(depth - l) nodes
+    return 32 * ((size_t(2) << mDepth) - (size_t(2) << (mDepth - level)));
+}
+
+const uint8_t* MerkleTree::node(unsigned int level, size_t position) const
+{
+    return mNodes.data() + levelOffset(level) + 32 * position;
+}
+
+// Hash numberOfNodes nodes of a level from input (records for the leaves, pairs of children stored back to back for
+// the levels above) in blocks spread over numberOfThreads threads.
+static void hashLevel(const uint8_t* input, size_t inputSize, size_t numberOfNodes, uint8_t* output, int numberOfThreads)
+{
+    parallelFor((numberOfNodes + NODES_PER_TASK - 1) / NODES_PER_TASK, numberOfThreads, [&](size_t task)
+    {
+        const size_t first = task * NODES_PER_TASK;
+        const size_t count = std::min<size_t>(NODES_PER_TASK, numberOfNodes - first);
+        KangarooTwelveBatch(input + first * inputSize, unsigned(inputSize), output + 32 * first, 32, count);
+    });
+}
+
+void MerkleTree::build(const uint8_t* records, size_t recordSize, unsigned int depth, int numberOfThreads)
+{
+    mDepth = depth;
+    mNodes.resize(32 * ((size_t(2) << depth) - 1));
+    for (unsigned int level = 0; level <= depth; level++)
+    {
+        const uint8_t* input = level ? mNodes.data() + levelOffset(level - 1) : records;
+        hashLevel(input, level ? 64 : recordSize, size_t(1) << (depth - level), mNodes.data() + levelOffset(level), numberOfThreads);
+    }
+}
+
+void MerkleTree::computeRoot(const uint8_t* records, size_t recordSize, unsigned int depth, uint8_t* root, int numberOfThreads)
+{
+    std::vector<uint8_t> level(32 * (size_t(1) << depth));
+    hashLevel(records, recordSize, size_t(1) << depth, level.data(), numberOfThreads);
+    for (unsigned int l = 1; l <= depth; l++)
+    {
+        std::vector<uint8_t> parents(32 * (size_t(1) << (depth - l)));
+        hashLevel(level.data(), 64, size_t(1) << (depth - l), parents.data(), numberOfThreads);
+        level.swap(parents);
+    }
+    memcpy(root, level.data(), 32);
+}
+
+void MerkleTree::getSiblings(size_t index, uint8_t (*siblings)[32]) const
+{
+    for (unsigned int level = 0; level < mDepth; level++)
+        memcpy(siblings[level], node(level, (index >> level) ^ 1), 32);
+}
+
+bool MerkleTree::save(const char* fileName) const
+{
+    FILE* f = fopen(fileName, "wb");
+    if (!f)
+        return false;
+    uint32_t depth = mDepth;
+    bool ok = fwrite(MERKLE_TREE_MAGIC, 1, 4, f) == 4
+        && fwrite(&depth, 1, sizeof(depth), f) == sizeof(depth)
+        && fwrite(mNodes.data(), 1, mNodes.size(), f) == mNodes.size();
+    ok &= (fclose(f) == 0);
+    return ok;
+}
+
+bool MerkleTree::readProof(const char* fileName, size_t index, unsigned int& depth, uint8_t* leafDigest, uint8_t (*siblings)[32], uint8_t* root)
+{
+    FILE* f = fopen(fileName, "rb");
+    if (!f)
+        return false;
+    char magic[4];
+    uint32_t storedDepth = 0;
+    bool ok = fread(magic, 1, 4, f) == 4 && memcmp(magic, MERKLE_TREE_MAGIC, 4) == 0
+        && fread(&storedDepth, 1, sizeof(storedDepth), f) == sizeof(storedDepth)
+        && storedDepth < 48 && index < (size_t(1) << storedDepth);
+    depth = storedDepth;
+    auto readNode = [&](unsigned int level, size_t position, uint8_t* nodeOut)
+    {
+        uint64_t offset = 8 + 32 * uint64_t((size_t(2) << storedDepth) - (size_t(2) << (storedDepth - level)) + position);
+        return seekFile(f, offset) && fread(nodeOut, 1, 32, f) == 32;
+    };
+    ok = ok && readNode(0, index, leafDigest);
+    for (unsigned int level = 0; ok && level < storedDepth; level++)
+        ok = readNode(level, (index >> level) ^ 1, siblings[level]);
+    ok = ok && readNode(storedDepth, 0, root);
+    fclose(f);
+    return ok;
+}
+
+// Read a whole spectrum / universe file of MERKLE_FILE_CAPACITY records, build its tree and print the root.
+static void printDigestOfFile(const char* fileName, size_t recordSize, unsigned int depth, const char* name, const char* treeFile)
+{
+    MappedFile records;
+    if (!records.open(fileName, true))
+    {
+        LOG("Failed to open %s\n", fileName);
+        return;
+    }
+    if (records.size() < MERKLE_FILE_CAPACITY * recordSize)
+    {
+        LOG("Failed to read %s: expected %zu bytes, got %zu\n", fileName, size_t(MERKLE_FILE_CAPACITY * recordSize), records.size());
+        return;
+    }
+
+    // the whole tree is only kept if it is saved
+    auto start = std::chrono::steady_clock::now();
+    MerkleTree tree;
+    uint8_t root[32];
+    if (treeFile)
+    {
+        tree.build(records.data(), recordSize, depth);
+        memcpy(root, tree.root(), 32);
+    }
+    else
+    {
+        MerkleTree::computeRoot(records.data(), recordSize, depth, root);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    char hex[65];
+    byteToHex(root, hex, 32);
+    LOG("%s digest: %s\n", name, hex);
+    LOG("Built tree of depth %u in %.2f s, worker threads: %d\n", depth, seconds, getNumberOfWorkerThreads(0));
+    if (treeFile)
+    {
+        if (tree.save(treeFile))
+            LOG("Saved tree to %s\n", treeFile);
+        else
+            LOG("Failed to save tree to %s\n", treeFile);
+    }
+}
+
+void printSpectrumDigestOfFile(const char* spectrumFile, const char* treeFile)
+{
+    printDigestOfFile(spectrumFile, sizeof(Entity), SPECTRUM_DEPTH, "Spectrum", treeFile);
+}
+
+void printUniverseDigestOfFile(const char* universeFile, const char* treeFile)
+{
+    printDigestOfFile(universeFile, sizeof(AssetRecord), ASSETS_DEPTH, "Universe", treeFile);
+}
+
+void printMerkleProofFromTreeFile(const char* treeFile, size_t index)
+{
+    unsigned int depth = 0;
+    uint8_t leafDigest[32], root[32], siblings[64][32];
+    if (!MerkleTree::readProof(treeFile, index, depth, leafDigest, siblings, root))
+    {
+        LOG("Failed to read proof of index %zu from %s\n", index, treeFile);
+        return;
+    }
+    char hex[65];
+    byteToHex(leafDigest, hex, 32);
+    LOG("Index: %zu\n", index);
+    LOG("Leaf digest: %s\n", hex);
+    for (unsigned int level = 0; level < depth; level++)
+    {
+        byteToHex(siblings[level], hex, 32);
+        LOG("Sibling %2u: %s\n", level, hex);
+    }
+    byteToHex(root, hex, 32);
+    LOG("Root digest: %s\n", hex);
+}
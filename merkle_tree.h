@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Merkle tree over 2^depth fixed-size records (spectrum entities, universe asset records) as the node computes it:
+// leaf i is the KangarooTwelve digest of record i, every parent the digest of its two children, the root is the
+// spectrum / universe digest. All levels are kept, so proofs for any index can be served locally.
+class MerkleTree
+{
+public:
+    MerkleTree() : mDepth(0) {}
+
+    // Build from 2^depth records of recordSize bytes stored back to back. Every level is hashed in blocks spread over
+    // numberOfThreads threads (0 = one per core) with the multi-buffer KangarooTwelve.
+    void build(const uint8_t* records, size_t recordSize, unsigned int depth, int numberOfThreads = 0);
+
+    // Compute only the root of the tree over the same records. Levels are hashed one after the other and every level
+    // is freed once its parents are hashed, so at most a level and a half are held instead of the whole tree.
+    static void computeRoot(const uint8_t* records, size_t recordSize, unsigned int depth, uint8_t* root, int numberOfThreads = 0);
+
+    unsigned int depth() const { return mDepth; }
+    const uint8_t* root() const { return node(mDepth, 0); }
+    // Node at position of level (level 0 are the leaf digests).
+    const uint8_t* node(unsigned int level, size_t position) const;
+    // Siblings of every level from the leaf up, as in RespondedEntity / RespondAssetsWithSiblings.
+    void getSiblings(size_t index, uint8_t (*siblings)[32]) const;
+
+    // Persist all levels, "QMT1", depth (4 bytes), then the nodes level by level. Return false on I/O errors.
+    bool save(const char* fileName) const;
+
+    // Read the leaf digest, siblings and root for index from a tree file written by save(), without loading the
+    // whole tree. depth receives the depth of the tree, siblings needs room for it. Return false on errors.
+    static bool readProof(const char* fileName, size_t index, unsigned int& depth, uint8_t* leafDigest, uint8_t (*siblings)[32], uint8_t* root);
+
+private:
+    size_t levelOffset(unsigned int level) const;
+
+    unsigned int mDepth;
+    std::vector<uint8_t> mNodes;
+};
+
+// Compute and print the spectrum digest of a spectrum file (and save the tree if treeFile is not null).
+void printSpectrumDigestOfFile(const char* spectrumFile, const char* treeFile);
+
+// Compute and print the universe digest of a universe file (and save the tree if treeFile is not null).
+void printUniverseDigestOfFile(const char* universeFile, const char* treeFile);
+
+// Print the proof of a leaf from a tree file written by -spectrumdigest / -universedigest.
+void printMerkleProofFromTreeFile(const char* treeFile, size_t index);
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cstring>
+
+#include "k12_batch.h"
+#include "merkle_verify.h"
+
+// proofs processed together, bounded so that all buffers fit on the stack
+#define PROOF_GROUP_SIZE 64
+
+void verifyMerkleProofs(const MerkleProof* proofs, size_t count, unsigned int depth, unsigned int leafByteLen,
+                        const uint8_t* expectedRoot, uint8_t* valid)
+{
+    uint8_t digests[PROOF_GROUP_SIZE][32];
+    uint8_t pairs[PROOF_GROUP_SIZE][64];
+    uint8_t parents[PROOF_GROUP_SIZE][32];
+    const uint8_t* leaves[PROOF_GROUP_SIZE];
+    uint8_t* leafDigests[PROOF_GROUP_SIZE];
+    unsigned char order[PROOF_GROUP_SIZE];   // proofs of the group sorted by index
+    unsigned char parentOf[PROOF_GROUP_SIZE]; // slot in pairs / parents of the proof's node at the current level
+    for (size_t first = 0; first < count; first += PROOF_GROUP_SIZE)
+    {
+        const size_t n = std::min<size_t>(PROOF_GROUP_SIZE, count - first);
+        const MerkleProof* group = proofs + first;
+        for (size_t i = 0; i < n; i++)
+        {
+            order[i] = (unsigned char)i;
+            leaves[i] = group[i].leaf;
+            leafDigests[i] = digests[i];
+        }
+        std::sort(order, order + n, [&](unsigned char a, unsigned char b) { return group[a].index < group[b].index; });
+        KangarooTwelveBatch(leaves, leafByteLen, leafDigests, 32, n);
+
+        for (unsigned int level = 0; level < depth; level++)
+        {
+            // ordered pairs of children; proofs meeting in the same parent with the same children share one hash
+            size_t numberOfPairs = 0;
+            for (size_t k = 0; k < n; k++)
+            {
+                const size_t i = order[k];
+                const bool right = ((group[i].index >> level) & 1) != 0;
+                uint8_t* pair = pairs[numberOfPairs];
+                memcpy(pair, right ? group[i].siblings[level] : digests[i], 32);
+                memcpy(pair + 32, right ? digests[i] : group[i].siblings[level], 32);
+                if (numberOfPairs && (group[order[k - 1]].index >> (level + 1)) == (group[i].index >> (level + 1))
+                    && memcmp(pairs[numberOfPairs - 1], pair, 64) == 0)
+                {
+                    parentOf[i] = (unsigned char)(numberOfPairs - 1);
+                    continue;
+                }
+                parentOf[i] = (unsigned char)numberOfPairs++;
+            }
+            KangarooTwelveBatch(&pairs[0][0], 64, &parents[0][0], 32, numberOfPairs);
+            for (size_t i = 0; i < n; i++)
+                memcpy(digests[i], parents[parentOf[i]], 32);
+        }
+
+        for (size_t i = 0; i < n; i++)
+            valid[first + i] = (memcmp(digests[i], expectedRoot, 32) == 0) ? 1 : 0;
+    }
+}
+
+void verifySpectrumProofs(const RespondedEntity* entities, size_t count, const uint8_t* spectrumDigest, uint8_t* valid)
+{
+    MerkleProof proofs[PROOF_GROUP_SIZE];
+    for (size_t first = 0; first < count; first += PROOF_GROUP_SIZE)
+    {
+        const size_t n = std::min<size_t>(PROOF_GROUP_SIZE, count - first);
+        for (size_t i = 0; i < n; i++)
+        {
+            const RespondedEntity& entity = entities[first + i];
+            proofs[i] = { (const uint8_t*)&entity.entity, (unsigned int)entity.spectrumIndex, entity.siblings };
+        }
+        verifyMerkleProofs(proofs, n, SPECTRUM_DEPTH, sizeof(Entity), spectrumDigest, valid + first);
+        for (size_t i = 0; i < n; i++)
+        {
+            if (entities[first + i].spectrumIndex < 0)
+                valid[first + i] = 0;
+        }
+    }
+}
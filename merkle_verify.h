@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "structs.h"
+
+// One Merkle proof (leaf and the sibling of every level, from the leaf up), all pointers are borrowed.
+struct MerkleProof
+{
+    const uint8_t* leaf;
+    unsigned int index;              // position of the leaf, bit i tells whether the node of level i is a right child
+    const uint8_t (*siblings)[32];
+};
+
+// Check count proofs of the given depth with leaves of leafByteLen bytes against one expected root, valid[i] = 1 if
+// proof i leads to expectedRoot (same as getDigestFromSiblings<32>() == expectedRoot). The proofs are processed in
+// groups of up to 64 sorted by index: at every level, parents that several proofs of the group share (same position,
+// same children) are hashed once, and the remaining hashes of the level are computed together by the multi-buffer
+// KangarooTwelve. Needs no heap memory.
+void verifyMerkleProofs(const MerkleProof* proofs, size_t count, unsigned int depth, unsigned int leafByteLen,
+                        const uint8_t* expectedRoot, uint8_t* valid);
+
+// verifyMerkleProofs() for entities with their spectrum siblings against a spectrum digest.
+void verifySpectrumProofs(const RespondedEntity* entities, size_t count, const uint8_t* spectrumDigest, uint8_t* valid);
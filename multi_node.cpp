@@ -0,0 +1,251 @@
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#include "multi_node.h"
+#include "key_utils.h"
+#include "logger.h"
+#include "node_utils.h"
+#include "utils.h"
+#include "wallet_utils.h"
+
+std::vector<std::string> getNodeIpsFromListOrDiscovery(const char* nodeIp, int nodePort, const char* nodeListFile)
+{
+    std::vector<std::string> nodeIps;
+    if (strcmp(nodeListFile, "discover") == 0)
+    {
+        nodeIps = discoverNodeIps(nodeIp, nodePort);
+        if (std::find(nodeIps.begin(), nodeIps.end(), std::string(nodeIp)) == nodeIps.end())
+            nodeIps.insert(nodeIps.begin(), nodeIp);
+        return nodeIps;
+    }
+
+    std::ifstream file(nodeListFile);
+    if (!file.is_open())
+    {
+        LOG("Failed to open node list file %s\n", nodeListFile);
+        return nodeIps;
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() && line[0] != '#')
+            nodeIps.push_back(line);
+    }
+    return nodeIps;
+}
+
+// Most frequent value and the number of results voting for it. Return false if there are no values.
+template <typename T>
+static bool getMajority(const std::vector<T>& values, T& majority, int& count)
+{
+    std::map<T, int> votes;
+    for (const auto& value : values)
+        votes[value]++;
+    count = 0;
+    for (const auto& vote : votes)
+    {
+        if (vote.second > count)
+        {
+            majority = vote.first;
+            count = vote.second;
+        }
+    }
+    return count > 0;
+}
+
+template <typename R>
+static void printLatencySummary(const std::vector<NodeResult<R>>& results)
+{
+    int okCount = 0;
+    long long totalMsec = 0, maxMsec = 0;
+    for (const auto& result : results)
+    {
+        if (!result.ok)
+            continue;
+        okCount++;
+        long long msec = result.connectMsec + result.queryMsec;
+        totalMsec += msec;
+        maxMsec = std::max(maxMsec, msec);
+    }
+    LOG("Responding nodes: %d / %zu\n", okCount, results.size());
+    if (okCount)
+        LOG("Latency: average %lld ms, max %lld ms\n", totalMsec / okCount, maxMsec);
+}
+
+static void compareTickInfo(const std::vector<std::string>& nodeIps, int nodePort)
+{
+    auto results = scatterGather<CurrentTickInfo>(nodeIps, nodePort, getTickInfoFromNode);
+    std::vector<unsigned int> ticks;
+    std::vector<unsigned short> epochs;
+    for (auto& result : results)
+    {
+        if (result.ok && result.value.epoch == 0)
+        {
+            result.ok = false;
+            result.error = "no tick info received";
+        }
+        if (!result.ok)
+        {
+            LOG("%-16s FAILED  %s\n", result.nodeIp.c_str(), result.error.c_str());
+            continue;
+        }
+        LOG("%-16s tick %u  epoch %u  aligned %u  misaligned %u  (connect %lld ms, query %lld ms)\n",
+            result.nodeIp.c_str(), result.value.tick, result.value.epoch, result.value.numberOfAlignedVotes,
+            result.value.numberOfMisalignedVotes, result.connectMsec, result.queryMsec);
+        ticks.push_back(result.value.tick);
+        epochs.push_back(result.value.epoch);
+    }
+    printLatencySummary(results);
+
+    unsigned int majorityTick = 0;
+    unsigned short majorityEpoch = 0;
+    int tickCount = 0, epochCount = 0;
+    if (!getMajority(ticks, majorityTick, tickCount))
+        return;
+    getMajority(epochs, majorityEpoch, epochCount);
+    LOG("Majority epoch: %u (%d nodes)\n", majorityEpoch, epochCount);
+    LOG("Majority tick: %u (%d nodes), highest tick: %u, lowest tick: %u\n", majorityTick, tickCount,
+        *std::max_element(ticks.begin(), ticks.end()), *std::min_element(ticks.begin(), ticks.end()));
+    for (const auto& result : results)
+    {
+        if (result.ok && result.value.epoch != majorityEpoch)
+            LOG("Epoch divergence: %s is on epoch %u\n", result.nodeIp.c_str(), result.value.epoch);
+    }
+}
+
+static void compareSystemInfo(const std::vector<std::string>& nodeIps, int nodePort)
+{
+    auto results = scatterGather<CurrentSystemInfo>(nodeIps, nodePort, getSystemInfoFromNode);
+    std::vector<unsigned int> ticks;
+    std::vector<unsigned short> epochs;
+    std::vector<short> versions;
+    for (auto& result : results)
+    {
+        if (result.ok && result.value.epoch == 0)
+        {
+            result.ok = false;
+            result.error = "no system info received";
+        }
+        if (!result.ok)
+        {
+            LOG("%-16s FAILED  %s\n", result.nodeIp.c_str(), result.error.c_str());
+            continue;
+        }
+        LOG("%-16s version %d  epoch %u  tick %u  entities %u  (connect %lld ms, query %lld ms)\n",
+            result.nodeIp.c_str(), result.value.version, result.value.epoch, result.value.tick,
+            result.value.numberOfEntities, result.connectMsec, result.queryMsec);
+        ticks.push_back(result.value.tick);
+        epochs.push_back(result.value.epoch);
+        versions.push_back(result.value.version);
+    }
+    printLatencySummary(results);
+
+    unsigned int majorityTick = 0;
+    unsigned short majorityEpoch = 0;
+    short majorityVersion = 0;
+    int tickCount = 0, epochCount = 0, versionCount = 0;
+    if (!getMajority(ticks, majorityTick, tickCount))
+        return;
+    getMajority(epochs, majorityEpoch, epochCount);
+    getMajority(versions, majorityVersion, versionCount);
+    LOG("Majority version: %d (%d nodes)\n", majorityVersion, versionCount);
+    LOG("Majority epoch: %u (%d nodes)\n", majorityEpoch, epochCount);
+    LOG("Majority tick: %u (%d nodes)\n", majorityTick, tickCount);
+    for (const auto& result : results)
+    {
+        if (!result.ok)
+            continue;
+        if (result.value.version != majorityVersion)
+            LOG("Version divergence: %s runs version %d\n", result.nodeIp.c_str(), result.value.version);
+        if (result.value.epoch != majorityEpoch)
+            LOG("Epoch divergence: %s is on epoch %u\n", result.nodeIp.c_str(), result.value.epoch);
+    }
+}
+
+static void compareBalance(const std::vector<std::string>& nodeIps, int nodePort, const char* identity)
+{
+    uint8_t publicKey[32] = {0};
+    getPublicKeyFromIdentity(identity, publicKey);
+    auto results = scatterGather<RespondedEntity>(nodeIps, nodePort, [&](QCPtr qc)
+    {
+        return getBalance(qc, publicKey);
+    });
+
+    // spectrum digests reported per tick; nodes on the same tick must agree
+    std::map<unsigned int, std::map<std::string, std::vector<std::string>>> digestsByTick;
+    for (auto& result : results)
+    {
+        if (result.ok && result.value.tick == 0)
+        {
+            result.ok = false;
+            result.error = "no entity received";
+        }
+        if (!result.ok)
+        {
+            LOG("%-16s FAILED  %s\n", result.nodeIp.c_str(), result.error.c_str());
+            continue;
+        }
+        uint8_t digest[32] = {0};
+        char hex[65] = {0};
+        getSpectrumDigest(result.value, digest);
+        byteToHex(digest, hex, 32);
+        long long balance = result.value.entity.incomingAmount - result.value.entity.outgoingAmount;
+        LOG("%-16s tick %u  balance %lld  digest %s  (connect %lld ms, query %lld ms)\n",
+            result.nodeIp.c_str(), result.value.tick, balance, hex, result.connectMsec, result.queryMsec);
+        digestsByTick[result.value.tick][hex].push_back(result.nodeIp);
+    }
+    printLatencySummary(results);
+
+    bool divergent = false;
+    for (const auto& tick : digestsByTick)
+    {
+        if (tick.second.size() <= 1)
+            continue;
+        divergent = true;
+        LOG("Spectrum digest divergence on tick %u:\n", tick.first);
+        for (const auto& digest : tick.second)
+        {
+            LOG("\t%s:", digest.first.c_str());
+            for (const auto& ip : digest.second)
+                LOG(" %s", ip.c_str());
+            LOG("\n");
+        }
+    }
+    if (!digestsByTick.empty() && !divergent)
+        LOG("No spectrum digest divergence among nodes on the same tick\n");
+}
+
+void compareNodes(const char* nodeIp, int nodePort, const char* nodeListFile, const char* query, const char* identity)
+{
+    std::vector<std::string> nodeIps = getNodeIpsFromListOrDiscovery(nodeIp, nodePort, nodeListFile);
+    if (nodeIps.empty())
+    {
+        LOG("No nodes to query\n");
+        return;
+    }
+    LOG("Querying %zu nodes\n", nodeIps.size());
+    if (strcmp(query, "tickinfo") == 0)
+    {
+        compareTickInfo(nodeIps, nodePort);
+    }
+    else if (strcmp(query, "systeminfo") == 0)
+    {
+        compareSystemInfo(nodeIps, nodePort);
+    }
+    else if (strcmp(query, "balance") == 0)
+    {
+        if (!identity || strlen(identity) != 60)
+        {
+            LOG("Query balance requires a 60-character identity\n");
+            return;
+        }
+        compareBalance(nodeIps, nodePort, identity);
+    }
+    else
+    {
+        LOG("Unknown query %s. Supported queries: tickinfo, systeminfo, balance\n", query);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "connection.h"
+#include "parallel.h"
+
+// Outcome of one query on one node. value is only meaningful if ok is true.
+template <typename R>
+struct NodeResult
+{
+    std::string nodeIp;
+    bool ok;
+    std::string error;
+    long long connectMsec;
+    long long queryMsec;
+    R value;
+};
+
+// Run query on every node concurrently, using at most maxWorkers threads, and return the results in the order of
+// nodeIps. Connections come from the connection pool. query may throw std::logic_error to report failure; return a
+// value that the caller recognizes as invalid (like a zero tick) for soft failures.
+template <typename R>
+std::vector<NodeResult<R>> scatterGather(const std::vector<std::string>& nodeIps, int nodePort,
+                                         const std::function<R(QCPtr)>& query, int maxWorkers = 16)
+{
+    std::vector<NodeResult<R>> results(nodeIps.size());
+    parallelFor(nodeIps.size(), std::max(1, maxWorkers), [&](size_t i)
+    {
+        NodeResult<R>& result = results[i];
+        result.nodeIp = nodeIps[i];
+        result.ok = false;
+        result.connectMsec = result.queryMsec = 0;
+        auto start = std::chrono::steady_clock::now();
+        try
+        {
+            QCPtr qc = make_qc(nodeIps[i].c_str(), nodePort);
+            auto connected = std::chrono::steady_clock::now();
+            result.connectMsec = std::chrono::duration_cast<std::chrono::milliseconds>(connected - start).count();
+            result.value = query(qc);
+            result.queryMsec = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - connected).count();
+            result.ok = true;
+        }
+        catch (std::logic_error& e)
+        {
+            result.error = e.what();
+        }
+    });
+    return results;
+}
+
+// Read node IPs from a file (one per line, empty lines and lines starting with # are ignored).
+// The keyword "discover" instead asks nodeIp for its peers and includes nodeIp itself.
+std::vector<std::string> getNodeIpsFromListOrDiscovery(const char* nodeIp, int nodePort, const char* nodeListFile);
+
+// Send the same query (tickinfo, systeminfo, or balance of identity) to all listed nodes in parallel and print per-node
+// results with latency, the majority tick/epoch, and whether spectrum digests of nodes on the same tick diverge.
+void compareNodes(const char* nodeIp, int nodePort, const char* nodeListFile, const char* query, const char* identity);
@@ -1,4 +1,6 @@
+#include <array>
 #include <cstring>
+#include <unordered_map>
 #include <vector>
 #include <cstdlib>
 #include <ctime>
@@ -8,16 +10,26 @@
 #include <stdexcept>
 #include <cinttypes>
 
+#include "batch_verify.h"
+#include "computor_list.h"
+#include "csv_export.h"
 #include "defines.h"
+#include "digest_hash.h"
 #include "structs.h"
 #include "connection.h"
+#include "packet_stream.h"
+#include "parallel.h"
+#include "event_loop.h"
 #include "node_utils.h"
 #include "logger.h"
 #include "k12_and_key_utils.h"
 #include "key_utils.h"
+#include "mapped_file.h"
+#include "tick_archive.h"
+#include "tick_file.h"
 #include "wallet_utils.h"
 
-static CurrentTickInfo getTickInfoFromNode(QCPtr qc)
+CurrentTickInfo getTickInfoFromNode(QCPtr qc)
 {
     CurrentTickInfo result;
     struct {
@@ -40,6 +52,39 @@ static CurrentTickInfo getTickInfoFromNode(QCPtr qc)
     return result;
 }
 
+bool limitTickRangeToNode(const char* nodeIp, int nodePort, const char* what, uint32_t& startTick, uint32_t& endTick)
+{
+    CurrentTickInfo tickInfo;
+    try
+    {
+        tickInfo = getTickInfoFromNode(make_qc(nodeIp, nodePort));
+    }
+    catch (const std::logic_error& e)
+    {
+        LOG("%s\n", e.what());
+        return false;
+    }
+    if (tickInfo.tick == 0)
+    {
+        LOG("Failed to get the current tick from %s:%d\n", nodeIp, nodePort);
+        return false;
+    }
+    // older ticks are not stored by the node and later ones are not complete yet
+    if (startTick < tickInfo.initialTick || endTick >= tickInfo.tick)
+    {
+        startTick = std::max(startTick, tickInfo.initialTick);
+        endTick = std::min(endTick, tickInfo.tick - 1);
+        LOG("The node has %s %u - %u of epoch %u, limiting the range to %u - %u\n", what, tickInfo.initialTick, tickInfo.tick - 1,
+            tickInfo.epoch, startTick, endTick);
+    }
+    if (startTick > endTick)
+    {
+        LOG("The node has no %s in the range\n", what);
+        return false;
+    }
+    return true;
+}
+
 uint32_t getTickNumberFromNode(QCPtr qc)
 {
     auto curTickInfo = getTickInfoFromNode(qc);
@@ -156,61 +201,50 @@ static void getTickTransactions(QCPtr qc, const uint32_t requestedTick, int nTx,
     for (int i = (nTx+7)/8; i < NUMBER_OF_TRANSACTIONS_PER_TICK/8; i++) packet.txs.transactionFlags[i] = 0xff;
     qc->sendData((uint8_t *) &packet, packet.header.size());
 
-    constexpr unsigned long long bufferSize = sizeof(RequestResponseHeader) + MAX_TRANSACTION_SIZE;
-    uint8_t buffer[bufferSize];
-    int recvByte = qc->receiveData(buffer, sizeof(RequestResponseHeader));
-    int recvTx = 0;
-    while (recvByte == sizeof(RequestResponseHeader))
+    // transactions are processed in place in the stream buffer, the response ends with END_RESPOND
+    PacketStreamReader reader(qc);
+    reader.forEachPacketOfType(BROADCAST_TRANSACTION, [&](const PacketView& view)
     {
-        auto header = (RequestResponseHeader*)buffer;
-        if (header->type() == BROADCAST_TRANSACTION)
+        if (view.payloadSize < int(sizeof(Transaction)))
+            return false;
+        auto tx = &view.as<Transaction>();
+        if (tx->inputSize > MAX_INPUT_SIZE || view.payloadSize < int(sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE))
         {
-            recvByte = qc->receiveAllDataOrThrowException(buffer + sizeof(RequestResponseHeader), sizeof(Transaction));
-            auto tx = (Transaction*)(buffer + sizeof(RequestResponseHeader));
-            txs.push_back(*tx);
-            if (tx->inputSize > MAX_INPUT_SIZE)
-            {
-                LOG("Received tx with invalid inputSize!\n");
-                exit(1);
-            }
-            ++recvTx;
-            recvByte = qc->receiveAllDataOrThrowException(buffer + sizeof(RequestResponseHeader) + sizeof(Transaction), tx->inputSize + SIGNATURE_SIZE);
-            if (hashes != nullptr)
-            {
-                TxhashStruct hash;
-                uint8_t digest[32] = {0};
-                char txHash[128] = {0};
-                KangarooTwelve(reinterpret_cast<const uint8_t*>(tx),
-                               sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE,
-                               digest,
-                               32);
-                getTxHashFromDigest(digest, txHash);
-                memcpy(hash.hash, txHash, 60);
-                hashes->push_back(hash);
-            }
-            if (extraData != nullptr)
-            {
-                extraDataStruct ed;
-                ed.vecU8.resize(tx->inputSize);
-                if (tx->inputSize != 0)
-                {
-                    memcpy(ed.vecU8.data(), reinterpret_cast<const uint8_t*>(tx) + sizeof(Transaction), tx->inputSize);
-                }
-                extraData->push_back(ed);
-            }
-            if (sigs != nullptr)
+            LOG("Received tx with invalid inputSize!\n");
+            exit(1);
+        }
+        txs.push_back(*tx);
+        if (hashes != nullptr)
+        {
+            TxhashStruct hash;
+            uint8_t digest[32] = {0};
+            char txHash[128] = {0};
+            KangarooTwelve(reinterpret_cast<const uint8_t*>(tx),
+                           sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE,
+                           digest,
+                           32);
+            getTxHashFromDigest(digest, txHash);
+            memcpy(hash.hash, txHash, 60);
+            hashes->push_back(hash);
+        }
+        if (extraData != nullptr)
+        {
+            extraDataStruct ed;
+            ed.vecU8.resize(tx->inputSize);
+            if (tx->inputSize != 0)
             {
-                SignatureStruct sig;
-                memcpy(sig.sig, reinterpret_cast<const uint8_t*>(tx) + sizeof(Transaction) + tx->inputSize, SIGNATURE_SIZE);
-                sigs->push_back(sig);
+                memcpy(ed.vecU8.data(), reinterpret_cast<const uint8_t*>(tx) + sizeof(Transaction), tx->inputSize);
             }
+            extraData->push_back(ed);
         }
-        recvByte = qc->receiveData(buffer, sizeof(RequestResponseHeader));
-        // check only after receive because response has an EndResponse header at the end
-        if (recvTx == nTx)
-            break;
-    }
-
+        if (sigs != nullptr)
+        {
+            SignatureStruct sig;
+            memcpy(sig.sig, reinterpret_cast<const uint8_t*>(tx) + sizeof(Transaction) + tx->inputSize, SIGNATURE_SIZE);
+            sigs->push_back(sig);
+        }
+        return true;
+    });
 }
 
 static bool getTickData(const char* nodeIp, const int nodePort, const uint32_t tick, TickData& result)
@@ -527,6 +561,51 @@ bool compareVote(const Tick&A, const Tick&B, bool compareExpectedNextTickDigest)
            (memcmp(A.transactionDigest, B.transactionDigest, 32) == 0);
 }
 
+// Digest of the fields compared by compareVote(), equal for equal votes.
+static std::array<uint8_t, 32> voteKey(const Tick& vote)
+{
+    uint8_t data[2 + 4 + 8 + 4 + 4 * 32];
+    size_t size = 0;
+    auto append = [&](const void* field, size_t fieldSize)
+    {
+        memcpy(data + size, field, fieldSize);
+        size += fieldSize;
+    };
+    append(&vote.epoch, sizeof(vote.epoch));
+    append(&vote.tick, sizeof(vote.tick));
+    append(&vote.millisecond, sizeof(vote.millisecond));
+    const uint8_t time[6] = { vote.second, vote.minute, vote.hour, vote.day, vote.month, vote.year };
+    append(time, sizeof(time));
+    append(&vote.prevResourceTestingDigest, sizeof(vote.prevResourceTestingDigest));
+    append(vote.prevSpectrumDigest, 32);
+    append(vote.prevUniverseDigest, 32);
+    append(vote.prevComputerDigest, 32);
+    append(vote.transactionDigest, 32);
+    std::array<uint8_t, 32> key;
+    KangarooTwelve(data, unsigned(size), key.data(), 32);
+    return key;
+}
+
+void groupVotes(const std::vector<Tick>& votes, const std::vector<bool>& included, VoteGroups& groups)
+{
+    groups.groupOfVote.assign(votes.size(), -1);
+    groups.groupSizes.clear();
+    groups.largestGroup = -1;
+    std::unordered_map<std::array<uint8_t, 32>, int, DigestHash> groupOfKey(2 * votes.size());
+    for (size_t i = 0; i < votes.size(); i++)
+    {
+        if (!included.empty() && !included[i])
+            continue;
+        auto inserted = groupOfKey.emplace(voteKey(votes[i]), int(groups.groupSizes.size()));
+        if (inserted.second)
+            groups.groupSizes.push_back(0);
+        int group = inserted.first->second;
+        groups.groupOfVote[i] = group;
+        if (++groups.groupSizes[group] > (groups.largestGroup < 0 ? 0 : groups.groupSizes[groups.largestGroup]))
+            groups.largestGroup = group;
+    }
+}
+
 bool verifyVoteWithSalt(const Tick&A,
                         const BroadcastComputors& bc,
                         const unsigned int prevResourceDigest,
@@ -534,7 +613,8 @@ bool verifyVoteWithSalt(const Tick&A,
                         const uint8_t* prevUniverseDigest,
                         const uint8_t* prevComputerDigest,
                         const unsigned int prevTransactionBodyDigest,
-                        const uint8_t* nextTickTransactionDigest)
+                        const uint8_t* nextTickTransactionDigest,
+                        bool printMismatch)
 {
     int cid = A.computorIndex;
     uint8_t saltedData[64];
@@ -545,14 +625,16 @@ bool verifyVoteWithSalt(const Tick&A,
     KangarooTwelve(saltedData, 36, saltedDigest, 4);
     if (A.saltedResourceTestingDigest != *((unsigned int*)(saltedDigest)))
     {
-        LOG("Mismatched saltedResourceTestingDigest. Computor index: %d\n", cid);
+        if (printMismatch)
+            LOG("Mismatched saltedResourceTestingDigest. Computor index: %d\n", cid);
         return false;
     }
     memcpy(saltedData+32, prevSpectrumDigest, 32);
     KangarooTwelve(saltedData, 64, saltedDigest, 32);
     if (memcmp(saltedDigest, A.saltedSpectrumDigest, 32) != 0)
     {
-        LOG("Mismatched saltedSpectrumDigest. Computor index: %d\n", cid);
+        if (printMismatch)
+            LOG("Mismatched saltedSpectrumDigest. Computor index: %d\n", cid);
         return false;
     }
 
@@ -560,7 +642,8 @@ bool verifyVoteWithSalt(const Tick&A,
     KangarooTwelve(saltedData, 64, saltedDigest, 32);
     if (memcmp(saltedDigest, A.saltedUniverseDigest, 32) != 0)
     {
-        LOG("Mismatched saltedUniverseDigest. Computor index: %d\n", cid);
+        if (printMismatch)
+            LOG("Mismatched saltedUniverseDigest. Computor index: %d\n", cid);
         return false;
     }
 
@@ -568,7 +651,8 @@ bool verifyVoteWithSalt(const Tick&A,
     KangarooTwelve(saltedData, 64, saltedDigest, 32);
     if (memcmp(saltedDigest, A.saltedComputerDigest, 32) != 0)
     {
-        LOG("Mismatched saltedComputerDigest. Computor index: %d\n", cid);
+        if (printMismatch)
+            LOG("Mismatched saltedComputerDigest. Computor index: %d\n", cid);
         return false;
     }
     bool should_check_txBodyDigest = isArrayZero(A.expectedNextTickTransactionDigest, 32) == isArrayZero(nextTickTransactionDigest, 32);
@@ -585,7 +669,8 @@ bool verifyVoteWithSalt(const Tick&A,
         KangarooTwelve(saltedData, 36, saltedDigest, 4);
         if (A.saltedTransactionBodyDigest != *((unsigned int*)(saltedDigest)))
         {
-            LOG("Mismatched saltedTransactionBodyDigest. Computor index: %d\n%u\n%u\n", cid, A.saltedTransactionBodyDigest, *((unsigned int*)(saltedDigest)));
+            if (printMismatch)
+                LOG("Mismatched saltedTransactionBodyDigest. Computor index: %d\n%u\n%u\n", cid, A.saltedTransactionBodyDigest, *((unsigned int*)(saltedDigest)));
             return false;
         }
     }
@@ -599,108 +684,43 @@ std::string indexToAlphabet(int index){
     return result;
 }
 
-void getUniqueVotes(std::vector<Tick>& votes, std::vector<Tick>& uniqueVote, std::vector<std::vector<int>>& voteIndices, int N,
-                    bool verifySalt = false,
-                    bool compareExpectedNextTickDigest = false,
-                    BroadcastComputors* pBC = nullptr,
-                    const unsigned int prevResourceDigest = 0,
-                    const uint8_t* prevSpectrumDigest = nullptr,
-                    const uint8_t* prevUniverseDigest = nullptr,
-                    const uint8_t* prevComputerDigest = nullptr,
-                    const unsigned int prevTransactionBodyDigest = 0,
-                    const uint8_t* nextTickTransactionDigest = 0)
+std::vector<Tick> getQuorumVotes(QCPtr qc, uint32_t requestedTick)
 {
-    if (votes.size() == 0) return;
-    if (verifySalt)
+    struct
     {
-        std::vector<Tick> new_votes;
-        LOG("Performing salt check...\n");
-        bool all_passed = true;
-        for (int i = 0; i < N; i++)
-        {
-            if (!verifyVoteWithSalt(votes[i], *pBC, prevResourceDigest, prevSpectrumDigest, prevUniverseDigest, prevComputerDigest, prevTransactionBodyDigest, nextTickTransactionDigest))
-            {
-                LOG("Vote %d failed to pass salt check\n", i);
-                dumpQuorumTick(votes[i]);
-                all_passed = false;
-            }
-            else
-            {
-                new_votes.push_back(votes[i]);
-            }
-        }
-        if (all_passed)
-        {
-            LOG("ALL votes PASSED salts check\n");
-        }
-        else
-        {
-            votes = new_votes;
-        }
-    }
-    uniqueVote.resize(0);
-    uniqueVote.push_back(votes[0]);
-    voteIndices.resize(1);
-    voteIndices[0].push_back(votes[0].computorIndex);
-    for (int i = 1; i < votes.size(); i++)
+        RequestResponseHeader header;
+        RequestedQuorumTick rqt;
+    } packet;
+    packet.header.setSize(sizeof(packet));
+    packet.header.randomizeDejavu();
+    packet.header.setType(RequestedQuorumTick::type);
+    packet.rqt.tick = requestedTick;
+    memset(packet.rqt.voteFlags, 0, (NUMBER_OF_COMPUTORS + 7) / 8);
+    qc->sendData(reinterpret_cast<uint8_t *>(&packet), sizeof(packet));
+
+    // at most one vote per computor
+    std::vector<Tick> votes;
+    votes.reserve(NUMBER_OF_COMPUTORS);
+    std::vector<bool> received(NUMBER_OF_COMPUTORS, false);
+    PacketStreamReader reader(qc);
+    reader.forEachPacketAs<Tick>([&](const Tick& vote)
     {
-        int vote_indice = -1;
-        for (int j = 0; j < uniqueVote.size(); j++)
-        {
-            if (compareVote(votes[i], uniqueVote[j], compareExpectedNextTickDigest))
-            {
-                vote_indice = j;
-                break;
-            }
-        }
-        if (vote_indice != -1)
-        {
-            voteIndices[vote_indice].push_back(votes[i].computorIndex);
-        }
-        else
+        if (vote.computorIndex < NUMBER_OF_COMPUTORS && !received[vote.computorIndex])
         {
-            uniqueVote.push_back(votes[i]);
-            voteIndices.resize(voteIndices.size() + 1);
-            int M = int(voteIndices.size() -1);
-            voteIndices[M].resize(0);
-            voteIndices[M].push_back(votes[i].computorIndex);
+            received[vote.computorIndex] = true;
+            votes.push_back(vote);
         }
-    }
+    });
+    return votes;
 }
 
 void getQuorumTick(const char* nodeIp, const int nodePort, uint32_t requestedTick, const char* compFileName)
 {
     auto qc = std::make_shared<QubicConnection>(nodeIp, nodePort);
-    BroadcastComputors bc;
-    {
-        FILE* f = fopen(compFileName, "rb");
-        if (fread(&bc, 1, sizeof(BroadcastComputors), f) != sizeof(BroadcastComputors))
-        {
-            LOG("Failed to read comp list\n");
-            fclose(f);
-            return;
-        }
-        fclose(f);
-    }
-
-    static struct
-    {
-        RequestResponseHeader header;
-        RequestedQuorumTick rqt;
-    } packet;
-    packet.header.setSize(sizeof(packet));
-    packet.header.randomizeDejavu();
-    packet.header.setType(RequestedQuorumTick::type); // REQUEST_TICK_DATA
-    packet.rqt.tick = requestedTick;
-    memset(packet.rqt.voteFlags, 0, (676 + 7) / 8);
-    qc->sendData(reinterpret_cast<uint8_t *>(&packet), sizeof(packet));
-    auto votes = qc->getLatestVectorPacketAs<Tick>();
+    auto votes = getQuorumVotes(qc, requestedTick);
     LOG("Received %d quorum tick #%u (votes)\n", votes.size(), requestedTick);
 
-    packet.rqt.tick = requestedTick+1;
-    memset(packet.rqt.voteFlags, 0, (676 + 7) / 8);
-    qc->sendData(reinterpret_cast<uint8_t *>(&packet), sizeof(packet));
-    auto votes_next = qc->getLatestVectorPacketAs<Tick>();
+    auto votes_next = getQuorumVotes(qc, requestedTick + 1);
     LOG("Received %d quorum tick #%u (votes)\n", votes_next.size(), requestedTick+1);
 
     int N = int(votes.size());
@@ -708,56 +728,86 @@ void getQuorumTick(const char* nodeIp, const int nodePort, uint32_t requestedTic
     {
         return;
     }
+    auto computorList = loadComputorList(compFileName, nodeIp, nodePort, votes[0].epoch);
+    if (!computorList)
+    {
+        return;
+    }
+    const BroadcastComputors& bc = computorList->broadcast;
 
-    for (int i = 0; i < N; i++)
+    std::vector<uint8_t> digests(32 * N);
+    std::vector<SignatureToVerify> signatures(N);
+    parallelFor(N, 0, [&](size_t i)
     {
-        uint8_t digest[64] = {0};
         votes[i].computorIndex ^= Tick::type();
-        KangarooTwelve((uint8_t*)&votes[i], sizeof(Tick) - SIGNATURE_SIZE, digest, 32);
+        KangarooTwelve((uint8_t*)&votes[i], sizeof(Tick) - SIGNATURE_SIZE, &digests[32 * i], 32);
         votes[i].computorIndex ^= Tick::type();
         int comp_index = votes[i].computorIndex;
-        if (!verify(bc.computors.publicKeys[comp_index], digest, votes[i].signature))
+        signatures[i] = { bc.computors.publicKeys[comp_index], &digests[32 * i], votes[i].signature };
+    });
+    auto validSignatures = verifySignatures(signatures, 0, &computorList->decodedKeys);
+    for (int i = 0; i < N; i++)
+    {
+        if (!validSignatures[i])
         {
             LOG("Signature of vote %d is not correct\n", i);
             dumpQuorumTick(votes[i]);
             return;
         }
     }
-    std::vector<Tick> uniqueVote, uniqueVoteNext;
-    std::vector<std::vector<int>> voteIndices, voteIndicesNext;
-    getUniqueVotes(votes_next, uniqueVoteNext, voteIndicesNext, N, false, false);
+    // the salts are checked against the vote of the quorum of the next tick
+    std::vector<bool> included(N, true);
+    VoteGroups nextGroups;
+    groupVotes(votes_next, std::vector<bool>(), nextGroups);
     if (votes_next.size() < 451)
     {
         printf("Failed to get votes for tick %d, this will not perform salt check\n", requestedTick+1);
-        getUniqueVotes(votes, uniqueVote, voteIndices, N, false, false);
+    }
+    else if (nextGroups.groupSizes[nextGroups.largestGroup] < 451)
+    {
+        LOG("WARNING: No quorum on tick %u (maximum aligned vote: %d). Skip salt check...\n", requestedTick + 1,
+            nextGroups.groupSizes[nextGroups.largestGroup]);
     }
     else
     {
-        int max_id = 0;
-        for (int i = 1; i < uniqueVoteNext.size(); i++)
+        const Tick* vote_next = nullptr;
+        for (size_t i = 0; !vote_next; i++)
         {
-            if (voteIndicesNext[max_id].size() < voteIndicesNext[i].size())
-            {
-                max_id = i;
-            }
+            if (nextGroups.groupOfVote[i] == nextGroups.largestGroup)
+                vote_next = &votes_next[i];
         }
-        if (voteIndicesNext[max_id].size() >= 451)
+        LOG("Performing salt check...\n");
+        bool all_passed = true;
+        for (int i = 0; i < N; i++)
         {
-            auto vote_next = uniqueVoteNext[max_id];
-            getUniqueVotes(votes, uniqueVote, voteIndices, N, true, true, &bc,
-                vote_next.prevResourceTestingDigest,
-                vote_next.prevSpectrumDigest,
-                vote_next.prevUniverseDigest,
-                vote_next.prevComputerDigest,
-                vote_next.prevTransactionBodyDigest,
-                vote_next.transactionDigest);
+            included[i] = verifyVoteWithSalt(votes[i], bc, vote_next->prevResourceTestingDigest, vote_next->prevSpectrumDigest,
+                                             vote_next->prevUniverseDigest, vote_next->prevComputerDigest,
+                                             vote_next->prevTransactionBodyDigest, vote_next->transactionDigest);
+            if (!included[i])
+            {
+                LOG("Vote %d failed to pass salt check\n", i);
+                dumpQuorumTick(votes[i]);
+                all_passed = false;
+            }
         }
-        else
+        if (all_passed)
         {
-            LOG("WARNING: No quorum on tick %u (maximum aligned vote: %d). Skip salt check...\n", requestedTick + 1, int(voteIndicesNext[max_id].size()));
-            getUniqueVotes(votes, uniqueVote, voteIndices, N, false, false);
+            LOG("ALL votes PASSED salts check\n");
         }
     }
+    VoteGroups groups;
+    groupVotes(votes, included, groups);
+    std::vector<const Tick*> uniqueVote(groups.groupSizes.size(), nullptr);
+    std::vector<std::vector<int>> voteIndices(groups.groupSizes.size());
+    for (int i = 0; i < N; i++)
+    {
+        const int group = groups.groupOfVote[i];
+        if (group < 0)
+            continue;
+        if (!uniqueVote[group])
+            uniqueVote[group] = &votes[i];
+        voteIndices[group].push_back(votes[i].computorIndex);
+    }
 
     LOG("Number of unique votes: %d\n", uniqueVote.size());
     bool flag[676] = {false};
@@ -765,7 +815,7 @@ void getQuorumTick(const char* nodeIp, const int nodePort, uint32_t requestedTic
     {
         LOG("Vote #%d (voted by %d computors ID) ", i, voteIndices[i].size());
         const bool dumpComputorIndex = false;
-        dumpQuorumTick(uniqueVote[i], dumpComputorIndex);
+        dumpQuorumTick(*uniqueVote[i], dumpComputorIndex);
         LOG("Voted by: ");
         std::sort(voteIndices[i].begin(), voteIndices[i].end());
         for (int j = 0; j < voteIndices[i].size(); j++)
@@ -837,26 +887,8 @@ void getTickDataToFile(const char* nodeIp, const int nodePort, uint32_t requeste
     LOG("Tick data and tick transactions have been written to %s\n", fileName);
 }
 
-void readTickDataFromFile(const char* fileName, TickData& td,
-                          std::vector<Transaction>& txs,
-                          std::vector<extraDataStruct>* extraData,
-                          std::vector<SignatureStruct>* signatures,
-                          std::vector<TxhashStruct>* txHashes)
+static void printTransactionDigests(const TickData& td)
 {
-    uint8_t extraDataBuffer[1024] = {0};
-    uint8_t signatureBuffer[128] = {0};
-    char txHashBuffer[128] = {0};
-    uint8_t digest[32] = {0};
-
-    FILE* f = fopen(fileName, "rb");
-    if (fread(&td, 1, sizeof(TickData), f) != sizeof(TickData))
-    {
-        LOG("Failed to read TickData\n");
-        fclose(f);
-        return;
-    }
-
-    int numTx = 0;
     uint8_t all_zero[32] = {0};
     LOG("List of transactions on tickData (correct order):\n");
     for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
@@ -868,140 +900,30 @@ void readTickDataFromFile(const char* fileName, TickData& td,
             LOG("%s\n", digestHex);
         }
     }
-    for (numTx = NUMBER_OF_TRANSACTIONS_PER_TICK; numTx > 0; numTx--)
-    {
-        if (memcmp(all_zero, td.transactionDigests[numTx-1], 32) != 0) break;
-    }
-    std::vector<uint8_t> vDigests;
-    vDigests.resize(32*numTx);
-    for (int i = 0; i < numTx; i++)
-    {
-        Transaction tx;
-        if (fread(&tx, 1, sizeof(Transaction), f) != sizeof(Transaction))
-        {
-            LOG("Failed to read Transaction\n");
-            break;
-        }
-        int extraDataSize = tx.inputSize;
-        if (extraData != nullptr)
-        {
-            extraDataStruct eds;
-            if (extraDataSize != 0)
-            {
-                if (fread(extraDataBuffer, 1, extraDataSize, f) != extraDataSize)
-                {
-                    LOG("Failed to read Transaction payload\n");
-                    fclose(f);
-                    return;
-                }
-                eds.vecU8.resize(extraDataSize);
-                memcpy(eds.vecU8.data(), extraDataBuffer, extraDataSize);
-            }
-            extraData->push_back(eds);
-        }
-
-        if (fread(signatureBuffer, 1, SIGNATURE_SIZE, f) != SIGNATURE_SIZE)
-        {
-            LOG("Failed to read signature\n");
-            fclose(f);
-            return;
-        }
-        if (signatures != nullptr)
-        {
-            SignatureStruct sig;
-            memcpy(sig.sig, signatureBuffer, SIGNATURE_SIZE);
-            signatures->push_back(sig);
-        }
-        {
-            std::vector<uint8_t> raw_data;
-            raw_data.resize(sizeof(Transaction) + tx.inputSize + SIGNATURE_SIZE);
-            auto ptr = raw_data.data();
-            memcpy(ptr, &tx, sizeof(Transaction));
-            memcpy(ptr + sizeof(Transaction), extraDataBuffer, tx.inputSize);
-            memcpy(ptr + sizeof(Transaction) + tx.inputSize, signatureBuffer, SIGNATURE_SIZE);
-            KangarooTwelve(ptr,
-                           uint32_t(raw_data.size()),
-                           digest,
-                           32);
-            memcpy(vDigests.data() + i * 32, digest, 32);
-        }
-        if (txHashes != nullptr)
-        {
-            TxhashStruct tx_hash;
-            getTxHashFromDigest(digest, txHashBuffer);
-            memcpy(tx_hash.hash, txHashBuffer, 60);
-            txHashes->push_back(tx_hash);
-        }
-        txs.push_back(tx);
-    }
-    for (int i = int(txs.size()); i < numTx; i++)
-    {
-        Transaction tx;
-        memset(&tx, 0, sizeof(Transaction));
-        txs.push_back(tx);
-        if (extraData != nullptr)
-        {
-            extraDataStruct eds;
-            eds.vecU8.resize(0);
-            extraData->push_back(eds);
-        }
-        if (signatures != nullptr)
-        {
-            SignatureStruct ss;
-            memset(ss.sig, 0, 64);
-            signatures->push_back(ss);
-        }
-        if (txHashes != nullptr)
-        {
-            TxhashStruct tx_hash;
-            memset(tx_hash.hash, 0, 60);
-            txHashes->push_back(tx_hash);
-        }
-    }
-
-    // put in correct order by tickdata
-    std::vector<Transaction> _txs; _txs.resize(numTx);
-    std::vector<extraDataStruct> _extraData;
-    std::vector<SignatureStruct> _signatures;
-    std::vector<TxhashStruct> _txHashes;
-    if (extraData != nullptr) _extraData.resize(numTx);
-    if (signatures != nullptr) _signatures.resize(numTx);
-    if (txHashes != nullptr) _txHashes.resize(numTx);
-    for (int i = 0; i < numTx; i++)
-    {
-        for (int j = 0; j < numTx; j++)
-        {
-            // guaranteed by the protocol, if any duplicated here it's a bug on core side
-            if (memcmp(vDigests.data() + j * 32, td.transactionDigests[i], 32) == 0)
-            {
-                _txs[i] = txs[j];
-                if (extraData != nullptr) _extraData[i] =  (*extraData)[j];
-                if (signatures != nullptr) _signatures[i] = (*signatures)[j];
-                if (txHashes != nullptr) _txHashes[i] = (*txHashes)[j];
-            }
-        }
-    }
-    txs = _txs;
-    if (extraData != nullptr) (*extraData) = _extraData;
-    if (signatures != nullptr) (*signatures) = _signatures;
-    if (txHashes != nullptr) (*txHashes) = _txHashes;
-    fclose(f);
 }
 
-BroadcastComputors readComputorListFromFile(const char* fileName);
-
-void printTickDataFromFile(const char* fileName, const char* compFile)
+void printTickDataFromFile(const char* fileName, const char* compFile, const char* nodeIp, const int nodePort)
 {
-    TickData td;
-    std::vector<Transaction> txs;
-    std::vector<extraDataStruct> extraData;
-    std::vector<SignatureStruct> signatures;
-    std::vector<TxhashStruct> txHashes;
+    TickFile tickFile;
+    if (!tickFile.read(fileName))
+    {
+        LOG("Failed to read TickData\n");
+        return;
+    }
+    TickData td = tickFile.tickData();
+    const auto& txs = tickFile.transactions();
     uint8_t digest[32];
-    readTickDataFromFile(fileName, td, txs, &extraData, &signatures, &txHashes);
+    printTransactionDigests(td);
     //verifying everything
-    BroadcastComputors bc;
-    bc = readComputorListFromFile(compFile);
+    auto computorList = loadComputorList(compFile, nodeIp, nodePort, td.epoch);
+    if (!computorList)
+    {
+        // nothing verifies, the tick is printed anyway
+        BroadcastComputors none;
+        memset(&none, 0, sizeof(BroadcastComputors));
+        computorList = std::make_shared<const ComputorList>(none);
+    }
+    const BroadcastComputors& bc = computorList->broadcast;
     if (bc.computors.epoch != td.epoch)
     {
         LOG("Computor list epoch (%u) and tick data epoch (%u) are not matched\n", bc.computors.epoch, td.epoch);
@@ -1018,8 +940,9 @@ void printTickDataFromFile(const char* fileName, const char* compFile)
                    sizeof(TickData) - SIGNATURE_SIZE,
                    digest,
                    32);
-    uint8_t* computorOfThisTick = bc.computors.publicKeys[computorIndex];
-    if (verify(computorOfThisTick, digest, td.signature))
+    const uint8_t* computorOfThisTick = bc.computors.publicKeys[computorIndex % NUMBER_OF_COMPUTORS];
+    if (computorIndex < NUMBER_OF_COMPUTORS
+        && verifySignatures({ { computorOfThisTick, digest, td.signature } }, 1, &computorList->decodedKeys)[0])
     {
         char computorID[61] = {0};
         getIdentityFromPublicKey(computorOfThisTick, computorID, false);
@@ -1035,16 +958,39 @@ void printTickDataFromFile(const char* fileName, const char* compFile)
     LOG("Computor index: %u\n", computorIndex);
     LOG("Datetime: %u-%u-%u %u:%u:%u.%u\n", td.day, td.month, td.year, td.hour, td.minute, td.second, td.millisecond);
 
+    // only the transactions in the file are verified
+    std::vector<size_t> txsInFile;
+    for (size_t i = 0; i < txs.size(); i++)
+    {
+        if (txs[i].transaction)
+            txsInFile.push_back(i);
+    }
+    std::vector<uint8_t> txDigests(32 * txsInFile.size());
+    std::vector<SignatureToVerify> txSignatures(txsInFile.size());
+    parallelFor(txsInFile.size(), 0, [&](size_t n)
+    {
+        const auto& view = txs[txsInFile[n]];
+        // the input directly follows the transaction in the file buffer
+        KangarooTwelve((const uint8_t*)view.transaction, unsigned(sizeof(Transaction) + view.transaction->inputSize), &txDigests[32 * n], 32);
+        txSignatures[n] = { view.transaction->sourcePublicKey, &txDigests[32 * n], view.signature };
+    });
+    auto validSignatures = verifySignatures(txSignatures, 0);
+    std::vector<bool> validTxSignatures(txs.size(), false);
+    for (size_t n = 0; n < txsInFile.size(); n++)
+        validTxSignatures[txsInFile[n]] = validSignatures[n];
+
     for (int i = 0; i < txs.size(); i++)
     {
-        if (isArrayZero((uint8_t*)&txs[i], sizeof(Transaction)))
+        if (!txs[i].transaction || isArrayZero((uint8_t*)txs[i].transaction, sizeof(Transaction)))
         {
             LOG("Detect a zero transaction - Ignoring\n");
             continue;
         }
-        uint8_t* extraDataPtr = extraData[i].vecU8.empty() ? nullptr : extraData[i].vecU8.data();
-        printReceipt(txs[i], txHashes[i].hash, extraDataPtr);
-        if (verifyTx(txs[i], extraData[i].vecU8.data(), signatures[i].sig))
+        char txHash[61] = {0};
+        getTxHashFromDigest(txs[i].digest, txHash);
+        Transaction tx = *txs[i].transaction;
+        printReceipt(tx, txHash, tx.inputSize ? txs[i].input : nullptr);
+        if (validTxSignatures[i])
         {
             LOG("Transaction is VERIFIED\n");
         }
@@ -1057,20 +1003,25 @@ void printTickDataFromFile(const char* fileName, const char* compFile)
 
 bool checkTxOnFile(const char* txHash, const char* fileName)
 {
-    TickData td;
-    std::vector<Transaction> txs;
-    std::vector<extraDataStruct> extraData;
-    std::vector<SignatureStruct> signatures;
-    std::vector<TxhashStruct> txHashes;
-
-    readTickDataFromFile(fileName, td, txs, &extraData, &signatures, &txHashes);
+    if (isTickArchive(fileName))
+        return checkTxOnArchive(txHash, fileName);
 
-    for (int i = 0; i < txs.size(); i++)
+    TickFile tickFile;
+    if (!tickFile.read(fileName))
     {
-        if (memcmp(txHashes[i].hash, txHash, 60) == 0)
+        LOG("Failed to read TickData\n");
+        return false;
+    }
+    printTransactionDigests(tickFile.tickData());
+    uint8_t digest[32];
+    getDigestFromTxHash(txHash, digest);
+    for (const auto& view : tickFile.transactions())
+    {
+        if (view.transaction && memcmp(view.digest, digest, 32) == 0)
         {
             LOG("Found tx %s on file %s\n", txHash, fileName);
-            printReceipt(txs[i], txHash, extraData[i].vecU8.data());
+            Transaction tx = *view.transaction;
+            printReceipt(tx, txHash, tx.inputSize ? view.input : nullptr);
             return true;
         }
     }
@@ -1571,34 +1522,16 @@ void broadcastCompChat(const char* nodeIp, const int nodePort, const char* seed,
     LOG("Broadcasted message to network\n");
 }
 
-BroadcastComputors readComputorListFromFile(const char* fileName)
+bool isComputorListSignedByArbitrator(const BroadcastComputors& bc)
 {
-    BroadcastComputors result;
-    FILE* f = fopen(fileName, "rb");
-    if (fread(&result, 1, sizeof(BroadcastComputors), f) != sizeof(BroadcastComputors))
-    {
-        LOG("Failed to read comp list\n");
-        fclose(f);
-        return result;
-    }
-    fclose(f);
     uint8_t digest[32] = {0};
     uint8_t arbPubkey[32] = {0};
-    // verify with arb
     getPublicKeyFromIdentity(ARBITRATOR, arbPubkey);
-    KangarooTwelve(reinterpret_cast<const uint8_t *>(&result),
+    KangarooTwelve(reinterpret_cast<const uint8_t *>(&bc),
                    sizeof(BroadcastComputors) - SIGNATURE_SIZE,
                    digest,
                    32);
-    if (verify(arbPubkey, digest, result.computors.signature))
-    {
-        LOG("Computor list is VERIFIED (signed by ARBITRATOR)\n");
-    } 
-    else 
-    {
-        LOG("Computor list is NOT verified\n");
-    }
-    return result;
+    return verify(arbPubkey, digest, bc.computors.signature);
 }
 
 bool getComputorFromNode(const char* nodeIp, const int nodePort, BroadcastComputors& result)
@@ -1640,10 +1573,6 @@ void getComputorListToFile(const char* nodeIp, const int nodePort, const char* f
         LOG("Failed to get valid computor list!\n");
         return;
     }
-    uint8_t digest[32] = {0};
-    uint8_t arbPubkey[32] = {0};
-    // verify with arb, dump data
-    getPublicKeyFromIdentity(ARBITRATOR, arbPubkey);
     for (int i = 0; i < NUMBER_OF_COMPUTORS; i++)
     {
         char identity[128] = {0};
@@ -1652,11 +1581,8 @@ void getComputorListToFile(const char* nodeIp, const int nodePort, const char* f
         LOG("%d %s\n", i, identity);
     }
     LOG("Epoch: %u\n", bc.computors.epoch);
-    KangarooTwelve(reinterpret_cast<const uint8_t *>(&bc),
-                   sizeof(BroadcastComputors) - SIGNATURE_SIZE,
-                   digest,
-                   32);
-    if (verify(arbPubkey, digest, bc.computors.signature))
+    // a signed list also goes to the cache used by the commands that take "-" as computor list
+    if (addComputorListToCache(bc))
     {
         LOG("Computor list is VERIFIED (signed by ARBITRATOR)\n");
     } 
@@ -1669,215 +1595,196 @@ void getComputorListToFile(const char* nodeIp, const int nodePort, const char* f
     fclose(f);
 }
 
-std::vector<std::string> _getNodeIpList(const char* nodeIp, const int nodePort)
+// Connect to all nodes at once and collect the peers they announce in their handshake.
+static std::vector<std::string> _getNodeIpList(const std::vector<std::string>& nodeIps, const int nodePort)
 {
     std::vector<std::string> result;
-    QCPtr qc;
-    try
-    {
-        qc = make_qc(nodeIp, nodePort);
-    } 
-    catch (std::logic_error)
+    QubicEventLoop loop;
+    std::vector<int> connectionIds;
+    for (const auto& ip : nodeIps)
     {
-        return result;
+        int id = loop.addConnection(ip.c_str(), nodePort);
+        if (id >= 0)
+            connectionIds.push_back(id);
     }
+    loop.run();
 
-    struct {
-        RequestResponseHeader header;
-    } packet;
-    packet.header.setSize(sizeof(packet));
-    packet.header.randomizeDejavu();
-    std::vector<uint8_t> buffer;
-    qc->getHandshakeData(buffer);
-    uint8_t* data = buffer.data();
-    int recvByte = int(buffer.size());
-    if (recvByte == 0)
-    {
-        return result;
-    }
-    auto epp = (ExchangePublicPeers*)(data);
-    for (int i = 0; i < 4; i++)
+    for (int id : connectionIds)
     {
-        if (epp->peers[i][0] == 0 && epp->peers[i][1] == 0 && epp->peers[i][2] == 0 && epp->peers[i][3] == 0) continue;
-        std::string new_ip = std::to_string(epp->peers[i][0]) + "." + std::to_string(epp->peers[i][1]) + "." + std::to_string(epp->peers[i][2]) + "." + std::to_string(epp->peers[i][3]);
-        result.push_back(new_ip);
+        std::vector<uint8_t> buffer;
+        if (!loop.getHandshakeData(id, buffer) || buffer.size() < sizeof(ExchangePublicPeers))
+            continue;
+        auto epp = (ExchangePublicPeers*)(buffer.data());
+        for (int i = 0; i < 4; i++)
+        {
+            if (epp->peers[i][0] == 0 && epp->peers[i][1] == 0 && epp->peers[i][2] == 0 && epp->peers[i][3] == 0) continue;
+            std::string new_ip = std::to_string(epp->peers[i][0]) + "." + std::to_string(epp->peers[i][1]) + "." + std::to_string(epp->peers[i][2]) + "." + std::to_string(epp->peers[i][3]);
+            result.push_back(new_ip);
+        }
     }
     return result;
 }
 
-void getNodeIpList(const char* nodeIp, const int nodePort)
+std::vector<std::string> discoverNodeIps(const char* nodeIp, const int nodePort)
 {
-    LOG("Fetching node ip list from %s\n", nodeIp);
-    std::vector<std::string> result = _getNodeIpList(nodeIp, nodePort);
-    int count = 0;
-    for (int i = 0; i < result.size() && count++ < 4; i++)
-    {
-        std::vector<std::string> new_result = _getNodeIpList(result[i].c_str(), nodePort);
-        result.insert(result.end(), new_result.begin(), new_result.end());
-    }
+    std::vector<std::string> result = _getNodeIpList(std::vector<std::string>{ nodeIp }, nodePort);
+    std::vector<std::string> peers(result.begin(), result.begin() + std::min<size_t>(result.size(), 4));
+    std::vector<std::string> new_result = _getNodeIpList(peers, nodePort);
+    result.insert(result.end(), new_result.begin(), new_result.end());
     std::sort(result.begin(), result.end());
     auto last = std::unique(result.begin(), result.end());
     result.erase(last, result.end());
+    return result;
+}
+
+void getNodeIpList(const char* nodeIp, const int nodePort)
+{
+    LOG("Fetching node ip list from %s\n", nodeIp);
+    std::vector<std::string> result = discoverNodeIps(nodeIp, nodePort);
     for (auto s : result)
     {
         LOG("%s\n", s.c_str());
     }
 }
 
+// rows of a snapshot formatted by one task of a CSV export
+#define CSV_RANGE_SIZE 4096
+
 static bool isEmptyEntity(const Entity& e){
-    bool is_pubkey_zero = true;
-    for (int i = 0; i < 32; i++)
-    {
-        if (e.publicKey[i] != 0)
-        {
-            is_pubkey_zero = false;
-            break;
-        }
-    }
-    if (is_pubkey_zero) return true;
+    // the cheap field checks first, most slots of a spectrum file are all zero
     if (e.outgoingAmount == 0 && e.incomingAmount == 0) return true;
     if (e.latestIncomingTransferTick == 0 && e.latestOutgoingTransferTick == 0) return true;
-    return false;
+    static const unsigned char zeroPublicKey[32] = {0};
+    return memcmp(e.publicKey, zeroPublicKey, 32) == 0;
 }
 
 void dumpSpectrumToCSV(const char* input, const char* output){
     const size_t SPECTRUM_CAPACITY = 0x1000000ULL; // may be changed in the future
-    Entity* spectrum = (Entity*)malloc(SPECTRUM_CAPACITY*sizeof(Entity));
-    FILE* f = fopen(input, "rb");
-    if (fread(spectrum, 1, SPECTRUM_CAPACITY*sizeof(Entity), f) != SPECTRUM_CAPACITY*sizeof(Entity))
+    MappedSpectrum spectrum;
+    if (!spectrum.open(input, true) || spectrum.size() < SPECTRUM_CAPACITY)
     {
         LOG("Failed to read spectrum\n");
-        fclose(f);
         return;
     }
-    fclose(f);
-    f = fopen(output, "w");
+    // identities of a range are converted together, so their checksums are hashed in one batch
+    exportCsv(output, "ID,LastInTick,LastOutTick,AmountIn,AmountOut,Balance\n", SPECTRUM_CAPACITY, CSV_RANGE_SIZE,
+              [&](size_t first, size_t count, CsvRows& rows)
     {
-        std::string header ="ID,LastInTick,LastOutTick,AmountIn,AmountOut,Balance\n";
-        fwrite(header.c_str(), 1, header.size(), f);
-    }
-    char buffer[128] = {0};
-    for (int i = 0; i < SPECTRUM_CAPACITY; i++)
-    {
-        if (!isEmptyEntity(spectrum[i]))
+        std::vector<size_t>& indices = rows.indices();
+        std::vector<uint8_t>& publicKeys = rows.publicKeys();
+        std::vector<char>& identities = rows.identities();
+        indices.clear();
+        for (size_t i = first; i < first + count; i++)
         {
-            memset(buffer, 0, 128);
-            getIdentityFromPublicKey(spectrum[i].publicKey, buffer, false);
-            std::string id = buffer;
-            std::string line = id + "," + std::to_string(spectrum[i].latestIncomingTransferTick)
-                               + "," + std::to_string(spectrum[i].latestOutgoingTransferTick)
-                               + "," + std::to_string(spectrum[i].incomingAmount)
-                               + "," + std::to_string(spectrum[i].outgoingAmount)
-                               + "," + std::to_string(spectrum[i].incomingAmount-spectrum[i].outgoingAmount) + "\n";
-            fwrite(line.c_str(), 1, line.size(), f);
+            if (!isEmptyEntity(spectrum[i]))
+                indices.push_back(i);
         }
-    }
-    free(spectrum);
-    fclose(f);
+        publicKeys.resize(32 * indices.size());
+        identities.resize(61 * indices.size());
+        for (size_t k = 0; k < indices.size(); k++)
+            memcpy(&publicKeys[32 * k], spectrum[indices[k]].publicKey, 32);
+        getIdentitiesFromPublicKeys(publicKeys.data(), indices.size(), identities.data(), false);
+        for (size_t k = 0; k < indices.size(); k++)
+        {
+            const Entity& entity = spectrum[indices[k]];
+            rows.text(&identities[61 * k], 60).comma()
+                .unsignedNumber(entity.latestIncomingTransferTick).comma()
+                .unsignedNumber(entity.latestOutgoingTransferTick).comma()
+                .number(entity.incomingAmount).comma()
+                .number(entity.outgoingAmount).comma()
+                .number(entity.incomingAmount - entity.outgoingAmount).endRow();
+        }
+        // every entity is read once, so the scanned pages need not stay resident
+        spectrum.release(first, count);
+    });
 }
 
 // only print ownership
 void dumpUniverseToCSV(const char* input, const char* output){
     const size_t ASSETS_CAPACITY = 0x1000000ULL; // may be changed in the future
-    AssetRecord* asset = (AssetRecord*)malloc(ASSETS_CAPACITY*sizeof(Entity));
-    FILE* f = fopen(input, "rb");
-    if (fread(asset, 1, ASSETS_CAPACITY*sizeof(AssetRecord), f) != ASSETS_CAPACITY * sizeof(AssetRecord))
+    // records refer to their issuance / ownership by index, so the whole universe must be present
+    MappedUniverse asset;
+    if (!asset.open(input, true) || asset.size() < ASSETS_CAPACITY)
     {
         LOG("Failed to read assets\n");
-        fclose(f);
         return;
     }
-    fclose(f);
-    f = fopen(output, "w");
-    {
-        std::string header ="Index,Type,ID,OwnerIndex,ContractIndex,AssetName,AssetIssuer,Amount\n";
-        fwrite(header.c_str(), 1, header.size(), f);
-    }
-    char buffer[128] = {0};
-    for (int i = 0; i < ASSETS_CAPACITY; i++)
+    // index of the issuance of a record, ASSETS_CAPACITY if the record has none or refers outside of the universe
+    auto issuanceOf = [&](size_t i) -> size_t
     {
+        size_t index = ASSETS_CAPACITY;
         if (asset[i].varStruct.ownership.type == OWNERSHIP)
+            index = asset[i].varStruct.ownership.issuanceIndex;
+        else if (asset[i].varStruct.ownership.type == POSSESSION)
         {
-            memset(buffer, 0, 128);
-            getIdentityFromPublicKey(asset[i].varStruct.ownership.publicKey, buffer, false);
-            std::string id = buffer;
-            std::string asset_name = "null";
-            std::string issuerID = "null";
-            size_t issue_index = asset[i].varStruct.ownership.issuanceIndex;
-            {
-                // get asset name
-                memset(buffer, 0, 128);
-                memcpy(buffer, asset[issue_index].varStruct.issuance.name, 7);
-                asset_name = buffer;
-            }
-            {
-                // get issuer
-                memset(buffer, 0, 128);
-                getIdentityFromPublicKey(asset[issue_index].varStruct.issuance.publicKey, buffer, false);
-                issuerID = buffer;
-            }
-            std::string line = std::to_string(i) + ",OWNERSHIP,"+ id
-                               + "," + std::to_string(i) + ","
-                               + std::to_string(asset[i].varStruct.ownership.managingContractIndex) + "," + asset_name
-                               + "," + issuerID
-                               + "," + std::to_string(asset[i].varStruct.ownership.numberOfShares) + "\n";
-            fwrite(line.c_str(), 1, line.size(), f);
+            size_t ownerIndex = asset[i].varStruct.possession.ownershipIndex;
+            if (ownerIndex < ASSETS_CAPACITY)
+                index = asset[ownerIndex].varStruct.ownership.issuanceIndex;
         }
-        if (asset[i].varStruct.ownership.type == POSSESSION)
+        else if (asset[i].varStruct.ownership.type == ISSUANCE)
+            index = i;
+        return index < ASSETS_CAPACITY ? index : ASSETS_CAPACITY;
+    };
+    exportCsv(output, "Index,Type,ID,OwnerIndex,ContractIndex,AssetName,AssetIssuer,Amount\n", ASSETS_CAPACITY, CSV_RANGE_SIZE,
+              [&](size_t first, size_t count, CsvRows& rows)
+    {
+        // identities of the records and of their issuers, converted in one batch
+        std::vector<uint8_t>& publicKeys = rows.publicKeys();
+        std::vector<size_t>& issuances = rows.indices();
+        std::vector<char>& identities = rows.identities();
+        publicKeys.clear();
+        issuances.resize(count);
+        for (size_t i = first; i < first + count; i++)
         {
-            memset(buffer, 0, 128);
-            getIdentityFromPublicKey(asset[i].varStruct.possession.publicKey, buffer, false);
-            std::string id = buffer;
-            std::string asset_name = "null";
-            std::string issuerID = "null";
-            std::string str_index = std::to_string(i);
-            int owner_index = asset[i].varStruct.possession.ownershipIndex;
-            int contract_index = asset[i].varStruct.possession.managingContractIndex;
-            std::string str_owner_index = std::to_string(owner_index);
-            std::string str_contract_index = std::to_string(contract_index);
-            std::string str_amount = std::to_string(asset[i].varStruct.possession.numberOfShares);
+            const unsigned char type = asset[i].varStruct.ownership.type;
+            if (type != OWNERSHIP && type != POSSESSION && type != ISSUANCE)
+                continue;
+            issuances[i - first] = issuanceOf(i);
+            const unsigned char* publicKey = asset[i].varStruct.ownership.publicKey;
+            publicKeys.insert(publicKeys.end(), publicKey, publicKey + 32);
+            if (issuances[i - first] < ASSETS_CAPACITY)
             {
-                // get asset name
-                int issuance_index = asset[owner_index].varStruct.ownership.issuanceIndex;
-                memset(buffer, 0, 128);
-                memcpy(buffer, asset[issuance_index].varStruct.issuance.name, 7);
-                asset_name = buffer;
-                memset(buffer, 0, 128);
-                getIdentityFromPublicKey(asset[issuance_index].varStruct.issuance.publicKey, buffer, false);
-                issuerID = buffer;
+                publicKey = asset[issuances[i - first]].varStruct.issuance.publicKey;
+                publicKeys.insert(publicKeys.end(), publicKey, publicKey + 32);
             }
-            std::string line = str_index + ",POSSESSION," + id + "," + str_owner_index + "," +
-                               str_contract_index + "," + asset_name + "," + issuerID + "," + str_amount + "\n";
-            fwrite(line.c_str(), 1, line.size(), f);
         }
-        if (asset[i].varStruct.ownership.type == ISSUANCE)
+        identities.resize(61 * (publicKeys.size() / 32));
+        getIdentitiesFromPublicKeys(publicKeys.data(), publicKeys.size() / 32, identities.data(), false);
+
+        size_t key = 0;
+        for (size_t i = first; i < first + count; i++)
         {
-            memset(buffer, 0, 128);
-            getIdentityFromPublicKey(asset[i].varStruct.issuance.publicKey, buffer, false);
-            std::string id = buffer;
-            std::string asset_name = "null";
-            std::string issuerID = "null";
-            std::string str_index = std::to_string(i);
-            std::string str_owner_index = std::to_string(0);
-            std::string str_contract_index = std::to_string(1); // don't know how to get this yet
-            std::string str_amount = std::to_string(asset[i].varStruct.possession.numberOfShares);
+            const AssetRecord& record = asset[i];
+            const unsigned char type = record.varStruct.ownership.type;
+            if (type != OWNERSHIP && type != POSSESSION && type != ISSUANCE)
+                continue;
+            const char* id = &identities[61 * key++];
+            const size_t issuance = issuances[i - first];
+            rows.unsignedNumber(i);
+            if (type == OWNERSHIP)
+            {
+                rows.text(",OWNERSHIP,", 11).text(id, 60).comma()
+                    .unsignedNumber(i).comma()
+                    .unsignedNumber(record.varStruct.ownership.managingContractIndex).comma();
+            }
+            else if (type == POSSESSION)
+            {
+                rows.text(",POSSESSION,", 12).text(id, 60).comma()
+                    .number(int(record.varStruct.possession.ownershipIndex)).comma()
+                    .number(int(record.varStruct.possession.managingContractIndex)).comma();
+            }
+            else
             {
-                // get asset name
-                memset(buffer, 0, 128);
-                memcpy(buffer, asset[i].varStruct.issuance.name, 7);
-                asset_name = buffer;
-                memset(buffer, 0, 128);
-                getIdentityFromPublicKey(asset[i].varStruct.issuance.publicKey, buffer, false);
-                issuerID = buffer;
+                // std::string header ="Index,Type,ID,OwnerIndex,ContractIndex,AssetName,AssetIssuer,Amount\n";
+                rows.text(",ISSUANCE,", 10).text(id, 60).text(",0,1,", 5); // don't know how to get the contract index yet
             }
-            // std::string header ="Index,Type,ID,OwnerIndex,ContractIndex,AssetName,AssetIssuer,Amount\n";
-            std::string line = str_index + ",ISSUANCE," + id + "," + str_owner_index + "," +
-                               str_contract_index + "," + asset_name + "," + issuerID + "," + str_amount + "\n";
-            fwrite(line.c_str(), 1, line.size(), f);
+            if (issuance < ASSETS_CAPACITY)
+                rows.name(asset[issuance].varStruct.issuance.name, 7).comma().text(&identities[61 * key++], 60);
+            else
+                rows.text("null,null", 9);
+            rows.comma().number(record.varStruct.possession.numberOfShares).endRow();
         }
-    }
-    free(asset);
-    fclose(f);
+    });
 }
 
 void getMiningScoreRanking(const char* nodeIp, const int nodePort, const char* seed)
@@ -1982,17 +1889,6 @@ unsigned int extract10Bit(const unsigned char* data, unsigned int idx)
 
 void getVoteCounterTransaction(const char* nodeIp, const int nodePort, unsigned int requestedTick, const char* compFileName)
 {
-    BroadcastComputors bc;
-    {
-        FILE* f = fopen(compFileName, "rb");
-        if (fread(&bc, 1, sizeof(BroadcastComputors), f) != sizeof(BroadcastComputors))
-        {
-            LOG("Failed to read comp list\n");
-            fclose(f);
-            return;
-        }
-        fclose(f);
-    }
     auto qc = make_qc(nodeIp, nodePort);
     std::vector<Transaction> txs;
     std::vector<TxhashStruct> txHashesFromTick;
@@ -2001,6 +1897,12 @@ void getVoteCounterTransaction(const char* nodeIp, const int nodePort, unsigned
     getTickTransactions(qc, requestedTick, 1024, txs, &txHashesFromTick, &extraData, &signatureStruct);
     TickData td;
     getTickData(qc, requestedTick, td);
+    auto computorList = loadComputorList(compFileName, nodeIp, nodePort, td.epoch);
+    if (!computorList)
+    {
+        return;
+    }
+    const BroadcastComputors& bc = computorList->broadcast;
 
     unsigned int votes[676];
     int nTx = int(txs.size());
@@ -1,8 +1,17 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "connection.h"
 #include "structs.h"
 
+// Return zeroed CurrentTickInfo on failure.
+CurrentTickInfo getTickInfoFromNode(QCPtr qc);
+// Limit [startTick, endTick] to the ticks the node has completed in its current epoch, from its initial tick to the
+// tick before its current one. what names the data the node has of these ticks in the messages ("ticks", "votes of
+// ticks"). Return false, after printing why, if the node does not answer or has none of the ticks.
+bool limitTickRangeToNode(const char* nodeIp, int nodePort, const char* what, uint32_t& startTick, uint32_t& endTick);
 void printTickInfoFromNode(const char* nodeIp, int nodePort);
 void printSystemInfoFromNode(const char* nodeIp, int nodePort);
 CurrentSystemInfo getSystemInfoFromNode(QCPtr qc);
@@ -13,14 +22,37 @@ void downloadFile(const char* nodeIp, const int nodePort, const char* trailer, c
 int _GetInputDataFromTxHash(QCPtr& qc, const char* txHash, uint8_t* outData, int& dataSize);
 int _GetTxInfo(QCPtr& qc, const char* txHash);
 int getTxInfo(const char* nodeIp, const int nodePort, const char* txHash);
+// Request all quorum votes of the tick (at most one per computor).
+std::vector<Tick> getQuorumVotes(QCPtr qc, uint32_t requestedTick);
 void getQuorumTick(const char* nodeIp, const int nodePort, uint32_t requestedTick, const char* compFileName);
+// Equal votes of one tick, in the order of their first vote.
+struct VoteGroups
+{
+    std::vector<int> groupOfVote; // -1 for votes left out
+    std::vector<int> groupSizes;
+    int largestGroup;             // -1 if no vote is in a group
+};
+// Group the votes that are equal in the fields compared by compareVote(), leaving out the votes that are not included
+// (included empty: all votes).
+void groupVotes(const std::vector<Tick>& votes, const std::vector<bool>& included, VoteGroups& groups);
+// Whether the salted digests of the vote match the digests reported by the votes of the next tick, the first mismatch
+// is printed if printMismatch is set.
+bool verifyVoteWithSalt(const Tick& A, const BroadcastComputors& bc, const unsigned int prevResourceDigest, const uint8_t* prevSpectrumDigest,
+                        const uint8_t* prevUniverseDigest, const uint8_t* prevComputerDigest, const unsigned int prevTransactionBodyDigest,
+                        const uint8_t* nextTickTransactionDigest, bool printMismatch = true);
+// Two letter name of a computor index (AA, AB, ...).
+std::string indexToAlphabet(int index);
 bool getTickData(QCPtr qc, const uint32_t tick, TickData& result);
 void getTickDataToFile(const char* nodeIp, const int nodePort, uint32_t requestedTick, const char* fileName);
-void printTickDataFromFile(const char* fileName, const char* compFile);
+// compFile is a computor list argument, see loadComputorList().
+void printTickDataFromFile(const char* fileName, const char* compFile, const char* nodeIp, const int nodePort);
+bool isComputorListSignedByArbitrator(const BroadcastComputors& bc);
 bool checkTxOnFile(const char* txHash, const char* fileName);
 void sendRawPacket(const char* nodeIp, const int nodePort, int rawPacketSize, uint8_t* rawPacket);
 void sendSpecialCommand(const char* nodeIp, const int nodePort, const char* seed, int command);
 void getComputorListToFile(const char* nodeIp, const int nodePort, const char* fileName);
+// Peers announced by the node and by (up to 4 of) its peers, sorted and unique.
+std::vector<std::string> discoverNodeIps(const char* nodeIp, const int nodePort);
 void getNodeIpList(const char* nodeIp, const int nodePort);
 void getLogFromNode(const char* nodeIp, const int nodePort, uint64_t* passcode);
 void dumpSpectrumToCSV(const char* input, const char* output);
@@ -28,6 +60,9 @@ void dumpUniverseToCSV(const char* input, const char* output);
 void getMiningScoreRanking(const char* nodeIp, const int nodePort, const char* seed);
 void getVoteCounterTransaction(const char* nodeIp, const int nodePort, unsigned int requestedTick, const char* compFileName);
 void uploadFile(const char* nodeIp, const int nodePort, const char* filePath, const char* seed, unsigned int tickOffset, const char* compressTool = nullptr);
+// External compression used by uploadFile/downloadFile (zip or tar). Return the compressed file name, empty on failure.
+std::string compressFileWithTool(const char* inputFile, const char* tool);
+int decompressFileWithTool(const char* inputFile, const char* tool);
 // remote tools:
 void toggleMainAux(const char* nodeIp, const int nodePort, const char* seed, std::string mode0, std::string mode1);
 void setSolutionThreshold(const char* nodeIp, const int nodePort, const char* seed, int epoch, int threshold);
@@ -0,0 +1,54 @@
+#include <cstring>
+
+#include "packet_stream.h"
+#include "logger.h"
+
+#define INITIAL_STREAM_BUFFER_SIZE 65536
+
+PacketStreamReader::PacketStreamReader(QCPtr qc) : mConnection(qc), mReadOffset(0), mWriteOffset(0), mEndResponseReceived(false)
+{
+    mBuffer.reserve(INITIAL_STREAM_BUFFER_SIZE);
+}
+
+bool PacketStreamReader::next(PacketView& view)
+{
+    if (mReadOffset == mWriteOffset)
+        mReadOffset = mWriteOffset = 0;
+    while (true)
+    {
+        size_t available = mWriteOffset - mReadOffset;
+        size_t needed = sizeof(RequestResponseHeader);
+        if (available >= sizeof(RequestResponseHeader))
+        {
+            RequestResponseHeader* header = (RequestResponseHeader*)(mBuffer.data() + mReadOffset);
+            unsigned int packetSize = header->size();
+            if (packetSize < sizeof(RequestResponseHeader) || packetSize == INT32_MAX)
+            {
+                LOG("Received broken packet header\n");
+                return false;
+            }
+            if (available >= packetSize)
+            {
+                view.header = header;
+                view.payload = mBuffer.data() + mReadOffset + sizeof(RequestResponseHeader);
+                view.payloadSize = int(packetSize - sizeof(RequestResponseHeader));
+                mReadOffset += packetSize;
+                return true;
+            }
+            needed = packetSize;
+        }
+
+        // Make room for the rest of the packet: move the partial packet to the front and grow if it does not fit.
+        if (mReadOffset + needed > mBuffer.capacity())
+        {
+            memmove(mBuffer.data(), mBuffer.data() + mReadOffset, available);
+            mReadOffset = 0;
+            mWriteOffset = available;
+            mBuffer.reserve(needed);
+        }
+        int recvSize = mConnection->receiveSome(mBuffer.data() + mWriteOffset, int(mBuffer.capacity() - mWriteOffset));
+        if (recvSize <= 0)
+            return false;
+        mWriteOffset += recvSize;
+    }
+}
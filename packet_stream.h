@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "buffer_pool.h"
+#include "connection.h"
+#include "defines.h"
+#include "structs.h"
+
+// View of one received packet inside the reader's buffer. Only valid until the next call into the reader.
+struct PacketView
+{
+    RequestResponseHeader* header;
+    const uint8_t* payload;
+    int payloadSize;
+
+    unsigned char type() const { return header->type(); }
+
+    // Interpret the payload as T without copying. Check payloadSize first if the payload may be shorter than T.
+    template <typename T> const T& as() const { return *((const T*)payload); }
+};
+
+// Streaming packet parser over a connection. Received bytes go into one reusable buffer (drawn from BufferPool and
+// compacted when a packet would run past its end) and each complete packet is exposed as a PacketView in place,
+// so large responses are processed packet by packet without copying payloads or collecting them in vectors.
+// Do not use the connection directly while the reader holds unconsumed data.
+class PacketStreamReader
+{
+public:
+    explicit PacketStreamReader(QCPtr qc);
+
+    // Get the next complete packet. Return false on timeout, closed connection, or broken packet header.
+    bool next(PacketView& view);
+
+    // Call callback(const T&) for every packet of type T until END_RESPOND, skipping other packet types and
+    // packets too short for T. Return the number of packets passed to the callback.
+    template <typename T, typename Callback> size_t forEachPacketAs(Callback callback)
+    {
+        return forEachPacketOfType(T::type(), [&](const PacketView& view)
+        {
+            if (view.payloadSize >= int(sizeof(T)))
+            {
+                callback(view.as<T>());
+                return true;
+            }
+            return false;
+        });
+    }
+
+    // Call callback(const PacketView&) for every packet of the given type until END_RESPOND. The callback returns
+    // whether it accepted the packet. Return the number of accepted packets.
+    template <typename Callback> size_t forEachPacketOfType(unsigned char type, Callback callback)
+    {
+        size_t count = 0;
+        PacketView view;
+        mEndResponseReceived = false;
+        while (next(view))
+        {
+            if (view.type() == END_RESPOND)
+            {
+                mEndResponseReceived = true;
+                break;
+            }
+            if (view.type() == type && callback(view))
+                count++;
+        }
+        return count;
+    }
+
+    // Whether the last forEach call ended with END_RESPOND (as opposed to timeout or connection loss).
+    bool endResponseReceived() const { return mEndResponseReceived; }
+
+private:
+    QCPtr mConnection;
+    PooledBuffer mBuffer;
+    size_t mReadOffset;
+    size_t mWriteOffset;
+    bool mEndResponseReceived;
+};
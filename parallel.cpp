@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "parallel.h"
+
+int getNumberOfWorkerThreads(int numberOfThreads)
+{
+    if (numberOfThreads > 0)
+        return numberOfThreads;
+    return std::max(1, int(std::thread::hardware_concurrency()));
+}
+
+void parallelFor(size_t count, int numberOfThreads, const std::function<void(size_t)>& function)
+{
+    size_t numberOfWorkers = std::min(count, size_t(getNumberOfWorkerThreads(numberOfThreads)));
+    if (numberOfWorkers <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+            function(i);
+        return;
+    }
+    std::atomic<size_t> nextIndex(0);
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto worker = [&]()
+    {
+        try
+        {
+            for (size_t i = nextIndex++; i < count; i = nextIndex++)
+                function(i);
+        }
+        catch (...)
+        {
+            // keep the first exception and hand out no more items
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error)
+                error = std::current_exception();
+            nextIndex = count;
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < numberOfWorkers; i++)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers)
+        thread.join();
+    if (error)
+        std::rethrow_exception(error);
+}
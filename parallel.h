@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Number of threads to use for CPU bound work: numberOfThreads if positive, otherwise one per core.
+int getNumberOfWorkerThreads(int numberOfThreads);
+
+// Call function(i) for every i in [0, count) on up to numberOfThreads threads (0 = one per core) and return when all
+// calls are done. Indices are handed out one at a time, so items may take very different amounts of time. With one
+// thread (or one item) everything runs on the calling thread. function must be thread safe. If a call throws, no more
+// items are started and the first exception is rethrown on the calling thread once all workers are done.
+void parallelFor(size_t count, int numberOfThreads, const std::function<void(size_t)>& function);
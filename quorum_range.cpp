@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "batch_verify.h"
+#include "computor_list.h"
+#include "connection.h"
+#include "k12_and_key_utils.h"
+#include "key_utils.h"
+#include "logger.h"
+#include "node_utils.h"
+#include "parallel.h"
+#include "quorum_range.h"
+#include "request_pipeline.h"
+#include "structs.h"
+
+// ticks whose votes are in memory at a time, about 240 KB each
+#define QUORUM_RANGE_WINDOW_TICKS 64
+#define QUORUM_RANGE_DEFAULT_CONNECTIONS 4
+// print progress every this many windows
+#define QUORUM_RANGE_PROGRESS_WINDOWS 16
+#define QUORUM_VOTES (NUMBER_OF_COMPUTORS * 2 / 3 + 1)
+
+namespace
+{
+
+// Votes of one tick, at most one per computor.
+struct TickVotes
+{
+    uint32_t tick;
+    bool fetched;
+    bool verified;                      // signatures checked, votes with a bad signature are removed
+    const ComputorList* computors;      // list of the epoch of the votes, nullptr if there is none
+    std::vector<Tick> votes;
+    std::vector<int> invalidSignatures; // computor indices of the removed votes
+};
+
+struct ComputorStats
+{
+    uint32_t votes;
+    uint32_t votesOnQuorumTicks;
+    uint32_t disagreements;       // votes on ticks with quorum that are not the quorum vote
+    uint32_t saltMismatches;
+    uint32_t invalidSignatures;
+};
+
+}
+
+// Fetch the votes of the ticks, spread over numberOfConnections pipelined connections. Ticks of a failed connection
+// stay not fetched.
+static void fetchVotes(const char* nodeIp, int nodePort, const std::vector<TickVotes*>& ticks, int numberOfConnections)
+{
+    requestPipelined(nodeIp, nodePort, ticks.size(), numberOfConnections, Tick::type(), true,
+        [&](size_t i, std::vector<uint8_t>& request)
+        {
+            struct
+            {
+                RequestResponseHeader header;
+                RequestedQuorumTick rqt;
+            } packet;
+            packet.header.setSize(sizeof(packet));
+            packet.header.setType(RequestedQuorumTick::type);
+            packet.rqt.tick = ticks[i]->tick;
+            memset(packet.rqt.voteFlags, 0, sizeof(packet.rqt.voteFlags));
+            request.assign((const uint8_t*)&packet, (const uint8_t*)&packet + sizeof(packet));
+        },
+        [&](size_t i, const std::vector<PacketPayload>& packets)
+        {
+            TickVotes& tick = *ticks[i];
+            std::vector<bool> received(NUMBER_OF_COMPUTORS, false);
+            for (const PacketPayload& payload : packets)
+            {
+                Tick vote;
+                if (payload.size() < sizeof(Tick))
+                    continue;
+                memcpy(&vote, payload.data(), sizeof(Tick));
+                if (vote.tick == tick.tick && vote.computorIndex < NUMBER_OF_COMPUTORS && !received[vote.computorIndex])
+                {
+                    received[vote.computorIndex] = true;
+                    tick.votes.push_back(vote);
+                }
+            }
+            tick.fetched = true;
+            return true;
+        });
+}
+
+// Remove the votes that are not signed by their computor.
+static void verifyVotes(TickVotes& tick)
+{
+    tick.verified = true;
+    if (!tick.computors)
+        return;
+    const size_t count = tick.votes.size();
+    std::vector<uint8_t> digests(32 * count);
+    std::vector<SignatureToVerify> signatures(count);
+    parallelFor(count, 0, [&](size_t i)
+    {
+        Tick vote = tick.votes[i];
+        vote.computorIndex ^= Tick::type();
+        KangarooTwelve((uint8_t*)&vote, sizeof(Tick) - SIGNATURE_SIZE, &digests[32 * i], 32);
+        signatures[i] = { tick.computors->broadcast.computors.publicKeys[tick.votes[i].computorIndex], &digests[32 * i], tick.votes[i].signature };
+    });
+    std::vector<bool> valid = verifySignatures(signatures, 0, &tick.computors->decodedKeys);
+    std::vector<Tick> validVotes;
+    validVotes.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (valid[i])
+            validVotes.push_back(tick.votes[i]);
+        else
+            tick.invalidSignatures.push_back(tick.votes[i].computorIndex);
+    }
+    tick.votes.swap(validVotes);
+}
+
+void analyzeQuorumRange(const char* nodeIp, int nodePort, const char* computorListFile, uint32_t startTick, uint32_t endTick,
+                        int numberOfConnections)
+{
+    if (!limitTickRangeToNode(nodeIp, nodePort, "votes of ticks", startTick, endTick))
+        return;
+    if (numberOfConnections <= 0)
+        numberOfConnections = QUORUM_RANGE_DEFAULT_CONNECTIONS;
+
+    std::map<uint16_t, std::shared_ptr<const ComputorList>> computorLists;
+    const ComputorList* lastComputors = nullptr;
+    auto computorListOf = [&](uint16_t epoch)
+    {
+        auto found = computorLists.find(epoch);
+        if (found == computorLists.end())
+            found = computorLists.emplace(epoch, loadComputorList(computorListFile, nodeIp, nodePort, epoch)).first;
+        return found->second.get();
+    };
+
+    std::vector<ComputorStats> stats(NUMBER_OF_COMPUTORS);
+    memset(stats.data(), 0, stats.size() * sizeof(ComputorStats));
+    size_t numberOfTicks = 0, numberOfQuorumTicks = 0, numberOfTicksWithoutVotes = 0, numberOfFailedTicks = 0;
+    size_t numberOfTicksWithoutComputors = 0, numberOfVotes = 0, numberOfWindows = 0;
+    const uint32_t numberOfRequestedTicks = endTick - startTick + 1;
+    auto start = std::chrono::steady_clock::now();
+    TickVotes carried;
+    bool haveCarried = false;
+    for (uint64_t first = startTick; first <= endTick; first += QUORUM_RANGE_WINDOW_TICKS)
+    {
+        // the ticks of the window and the tick after it, which is the first tick of the next window
+        const uint32_t last = uint32_t(std::min<uint64_t>(endTick, first + QUORUM_RANGE_WINDOW_TICKS - 1));
+        std::vector<TickVotes> window(last - first + 2);
+        std::vector<TickVotes*> ticksToFetch;
+        for (size_t i = 0; i < window.size(); i++)
+        {
+            if (i == 0 && haveCarried)
+            {
+                window[0] = std::move(carried);
+                continue;
+            }
+            window[i].tick = uint32_t(first + i);
+            window[i].fetched = window[i].verified = false;
+            window[i].computors = nullptr;
+            ticksToFetch.push_back(&window[i]);
+        }
+        fetchVotes(nodeIp, nodePort, ticksToFetch, numberOfConnections);
+        for (TickVotes& tick : window)
+        {
+            if (!tick.fetched || tick.verified)
+                continue;
+            if (!tick.votes.empty())
+                tick.computors = computorListOf(tick.votes[0].epoch);
+            verifyVotes(tick);
+        }
+
+        for (size_t i = 0; i + 1 < window.size(); i++)
+        {
+            TickVotes& tick = window[i];
+            const TickVotes& next = window[i + 1];
+            if (!tick.fetched)
+            {
+                numberOfFailedTicks++;
+                continue;
+            }
+            if (!tick.votes.empty() && !tick.computors)
+            {
+                numberOfTicksWithoutComputors++;
+                continue;
+            }
+            numberOfTicks++;
+            for (int computorIndex : tick.invalidSignatures)
+                stats[computorIndex].invalidSignatures++;
+            if (tick.votes.empty())
+            {
+                numberOfTicksWithoutVotes++;
+                if (tick.invalidSignatures.empty())
+                    continue;
+                LOG("Tick %u: no valid votes, %zu invalid signatures\n", tick.tick, tick.invalidSignatures.size());
+                continue;
+            }
+            lastComputors = tick.computors;
+
+            // the salts are checked against the vote of the quorum of the next tick, as in -getquorumtick
+            const Tick* nextQuorumVote = nullptr;
+            if (next.fetched && !next.votes.empty())
+            {
+                VoteGroups nextGroups;
+                groupVotes(next.votes, std::vector<bool>(), nextGroups);
+                if (nextGroups.largestGroup >= 0 && nextGroups.groupSizes[nextGroups.largestGroup] >= QUORUM_VOTES)
+                {
+                    for (size_t v = 0; v < next.votes.size() && !nextQuorumVote; v++)
+                    {
+                        if (nextGroups.groupOfVote[v] == nextGroups.largestGroup)
+                            nextQuorumVote = &next.votes[v];
+                    }
+                }
+            }
+            std::vector<bool> included(tick.votes.size(), true);
+            int numberOfSaltMismatches = 0;
+            if (nextQuorumVote)
+            {
+                for (size_t v = 0; v < tick.votes.size(); v++)
+                {
+                    included[v] = verifyVoteWithSalt(tick.votes[v], tick.computors->broadcast, nextQuorumVote->prevResourceTestingDigest,
+                                                     nextQuorumVote->prevSpectrumDigest, nextQuorumVote->prevUniverseDigest,
+                                                     nextQuorumVote->prevComputerDigest, nextQuorumVote->prevTransactionBodyDigest,
+                                                     nextQuorumVote->transactionDigest, false);
+                    if (!included[v])
+                    {
+                        stats[tick.votes[v].computorIndex].saltMismatches++;
+                        numberOfSaltMismatches++;
+                    }
+                }
+            }
+            VoteGroups groups;
+            groupVotes(tick.votes, included, groups);
+            const int largestGroupSize = groups.largestGroup < 0 ? 0 : groups.groupSizes[groups.largestGroup];
+            const bool quorum = (largestGroupSize >= QUORUM_VOTES);
+            numberOfQuorumTicks += quorum ? 1 : 0;
+            numberOfVotes += tick.votes.size();
+            for (size_t v = 0; v < tick.votes.size(); v++)
+            {
+                ComputorStats& computor = stats[tick.votes[v].computorIndex];
+                computor.votes++;
+                if (quorum)
+                {
+                    computor.votesOnQuorumTicks++;
+                    if (groups.groupOfVote[v] != groups.largestGroup)
+                        computor.disagreements++;
+                }
+            }
+            if (!quorum || groups.groupSizes.size() > 1 || numberOfSaltMismatches || !tick.invalidSignatures.empty())
+            {
+                LOG("Tick %u: %zu votes, %zu unique, largest vote by %d computors%s", tick.tick, tick.votes.size(), groups.groupSizes.size(),
+                    largestGroupSize, quorum ? "" : ", NO QUORUM");
+                if (!nextQuorumVote)
+                    LOG(", no quorum on the next tick to check salts");
+                if (numberOfSaltMismatches)
+                    LOG(", %d salt mismatches", numberOfSaltMismatches);
+                if (!tick.invalidSignatures.empty())
+                    LOG(", %zu invalid signatures", tick.invalidSignatures.size());
+                LOG("\n");
+            }
+        }
+        carried = std::move(window.back());
+        haveCarried = true;
+        if (++numberOfWindows % QUORUM_RANGE_PROGRESS_WINDOWS == 0 && last < endTick)
+            LOG("%u / %u ticks done\n", last - startTick + 1, numberOfRequestedTicks);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (lastComputors)
+    {
+        std::vector<char> identities(61 * NUMBER_OF_COMPUTORS);
+        getIdentitiesFromPublicKeys(&lastComputors->broadcast.computors.publicKeys[0][0], NUMBER_OF_COMPUTORS, identities.data(), false);
+        LOG("Computors of epoch %u (disagreements are counted on ticks with quorum, salt: votes failing the salt check, signature: votes with an invalid signature):\n",
+            lastComputors->broadcast.computors.epoch);
+        LOG("%5s %3s %-60s %7s %13s %13s %6s %9s\n", "index", "id", "identity", "votes", "participation", "disagreements", "salt", "signature");
+        for (int i = 0; i < NUMBER_OF_COMPUTORS; i++)
+        {
+            const ComputorStats& computor = stats[i];
+            auto alphabet = indexToAlphabet(i);
+            LOG("%5d %3s %-60s %7u %12.1f%% %5u (%5.1f%%) %6u %9u\n", i, alphabet.c_str(), &identities[61 * i], computor.votes,
+                numberOfTicks ? 100.0 * computor.votes / numberOfTicks : 0.0, computor.disagreements,
+                computor.votesOnQuorumTicks ? 100.0 * computor.disagreements / computor.votesOnQuorumTicks : 0.0, computor.saltMismatches,
+                computor.invalidSignatures);
+        }
+    }
+    LOG("Analyzed %zu of %u ticks in %.2f s (%.0f ticks/s) over %d connections: %zu with quorum, %zu without votes, %.1f votes per tick\n",
+        numberOfTicks, numberOfRequestedTicks, seconds, seconds > 0 ? numberOfTicks / seconds : 0.0, numberOfConnections,
+        numberOfQuorumTicks, numberOfTicksWithoutVotes, numberOfTicks ? double(numberOfVotes) / numberOfTicks : 0.0);
+    if (numberOfTicksWithoutComputors)
+        LOG("%zu ticks were skipped, there is no computor list of their epoch\n", numberOfTicksWithoutComputors);
+    if (numberOfFailedTicks)
+        LOG("Failed to download the votes of %zu ticks\n", numberOfFailedTicks);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Analyse the quorum of ticks startTick - endTick. The votes of a window of ticks are fetched at a time over
+// numberOfConnections pipelined connections (0 = 4), every tick once: its votes serve as the votes of the tick and as
+// the next votes of the tick before. Votes are checked against the computor list of their epoch (computorListFile, or
+// "-" for the cached list, see loadComputorList()) and against the salted digests confirmed by the quorum of the next
+// tick, like -getquorumtick does, and equal votes are grouped by a digest of the compared fields. Print the ticks
+// without quorum or with disagreeing votes and, per computor, how often it voted and disagreed with the quorum.
+void analyzeQuorumRange(const char* nodeIp, int nodePort, const char* computorListFile, uint32_t startTick, uint32_t endTick,
+                        int numberOfConnections);
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "request_pipeline.h"
+#include "defines.h"
+#include "logger.h"
+#include "parallel.h"
+
+#define RECEIVER_POLL_MSEC 100
+
+QubicRequestPipeline::QubicRequestPipeline(QCPtr qc, int requestTimeoutMsec)
+    : mConnection(qc), mRequestTimeoutMsec(requestTimeoutMsec), mStop(false), mBroken(false)
+{
+    mReceiver = std::thread(&QubicRequestPipeline::receiveLoop, this);
+}
+
+QubicRequestPipeline::~QubicRequestPipeline()
+{
+    mStop = true;
+    mReceiver.join();
+    failAll("Request pipeline closed before response was received.");
+}
+
+std::future<std::vector<PacketPayload>> QubicRequestPipeline::submit(const uint8_t* packet, int packetSize, unsigned char responseType, bool untilEndResponse)
+{
+    std::vector<uint8_t> buffer(packet, packet + packetSize);
+    RequestResponseHeader& header = (RequestResponseHeader&)buffer[0];
+    std::future<std::vector<PacketPayload>> future;
+    uint32_t dejavu;
+    {
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        if (mBroken)
+        {
+            std::promise<std::vector<PacketPayload>> failed;
+            failed.set_exception(std::make_exception_ptr(std::logic_error("No connection.")));
+            return failed.get_future();
+        }
+        do
+        {
+            header.randomizeDejavu();
+        } while (mPending.count(header.dejavu()));
+        dejavu = header.dejavu();
+
+        // register before sending, the response may arrive before sendData returns
+        PendingRequest& request = mPending[dejavu];
+        request.responseType = responseType;
+        request.untilEndResponse = untilEndResponse;
+        request.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(mRequestTimeoutMsec);
+        future = request.promise.get_future();
+    }
+
+    int sentSize;
+    {
+        std::lock_guard<std::mutex> lock(mSendMutex);
+        sentSize = mConnection->sendData(buffer.data(), packetSize);
+    }
+    if (sentSize != packetSize)
+    {
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        auto it = mPending.find(dejavu);
+        if (it != mPending.end())
+        {
+            it->second.promise.set_exception(std::make_exception_ptr(std::logic_error("Failed to send request.")));
+            mPending.erase(it);
+        }
+    }
+    return future;
+}
+
+std::future<RespondedEntity> QubicRequestPipeline::requestEntity(const uint8_t* publicKey)
+{
+    struct {
+        RequestResponseHeader header;
+        RequestedEntity req;
+    } packet;
+    packet.header.setSize(sizeof(packet));
+    packet.header.setType(REQUEST_ENTITY);
+    memcpy(packet.req.publicKey, publicKey, 32);
+    auto raw = submit((uint8_t*)&packet, sizeof(packet), RESPOND_ENTITY).share();
+    return std::async(std::launch::deferred, [raw]()
+    {
+        const auto& packets = raw.get();
+        if (packets.empty())
+            throw std::logic_error("Node sent no entity.");
+        RespondedEntity result;
+        memset(&result, 0, sizeof(RespondedEntity));
+        memcpy(&result, packets[0].data(), (packets[0].size() < sizeof(RespondedEntity)) ? packets[0].size() : sizeof(RespondedEntity));
+        return result;
+    });
+}
+
+std::future<PacketPayload> QubicRequestPipeline::runContractFunction(unsigned int contractIndex, unsigned short funcNumber, const void* input, size_t inputSize)
+{
+    std::vector<uint8_t> packet(sizeof(RequestResponseHeader) + sizeof(RequestContractFunction) + inputSize);
+    RequestResponseHeader& packetHeader = (RequestResponseHeader&)packet[0];
+    RequestContractFunction& packetRcf = (RequestContractFunction&)packet[sizeof(RequestResponseHeader)];
+    packetHeader.setSize(uint32_t(packet.size()));
+    packetHeader.setType(RequestContractFunction::type());
+    packetRcf.inputSize = uint16_t(inputSize);
+    packetRcf.inputType = funcNumber;
+    packetRcf.contractIndex = contractIndex;
+    if (inputSize)
+        memcpy(&packet[sizeof(RequestResponseHeader) + sizeof(RequestContractFunction)], input, inputSize);
+    auto raw = submit(packet.data(), int(packet.size()), RespondContractFunction::type()).share();
+    return std::async(std::launch::deferred, [raw]()
+    {
+        const auto& packets = raw.get();
+        return packets.empty() ? PacketPayload() : packets[0];
+    });
+}
+
+size_t QubicRequestPipeline::pendingRequests()
+{
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    return mPending.size();
+}
+
+void QubicRequestPipeline::failAll(const char* reason)
+{
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    mBroken = true;
+    for (auto& it : mPending)
+        it.second.promise.set_exception(std::make_exception_ptr(std::logic_error(reason)));
+    mPending.clear();
+}
+
+void QubicRequestPipeline::failExpired()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    for (auto it = mPending.begin(); it != mPending.end();)
+    {
+        if (it->second.deadline < now)
+        {
+            it->second.promise.set_exception(std::make_exception_ptr(std::logic_error("Request timed out.")));
+            it = mPending.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void QubicRequestPipeline::receiveLoop()
+{
+    while (!mStop)
+    {
+        if (!mConnection->waitForData(RECEIVER_POLL_MSEC))
+        {
+            failExpired();
+            continue;
+        }
+
+        RequestResponseHeader header;
+        PacketPayload payload;
+        try
+        {
+            mConnection->receiveAllDataOrThrowException((uint8_t*)&header, sizeof(RequestResponseHeader));
+            unsigned int packetSize = header.size();
+            if (packetSize < sizeof(RequestResponseHeader) || packetSize == INT32_MAX)
+                throw std::logic_error("Received broken packet header.");
+            payload.resize(packetSize - sizeof(RequestResponseHeader));
+            if (!payload.empty())
+                mConnection->receiveAllDataOrThrowException(payload.data(), int(payload.size()));
+        }
+        catch (std::logic_error& e)
+        {
+            LOG("%s\n", e.what());
+            failAll(e.what());
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mPendingMutex);
+            // packets with unknown dejavu are broadcasts or late responses to expired requests
+            auto it = mPending.find(header.dejavu());
+            if (it != mPending.end())
+            {
+                PendingRequest& request = it->second;
+                if (header.type() == END_RESPOND)
+                {
+                    request.promise.set_value(std::move(request.packets));
+                    mPending.erase(it);
+                }
+                else if (header.type() == request.responseType)
+                {
+                    request.packets.push_back(std::move(payload));
+                    if (!request.untilEndResponse)
+                    {
+                        request.promise.set_value(std::move(request.packets));
+                        mPending.erase(it);
+                    }
+                }
+            }
+        }
+        failExpired();
+    }
+}
+
+bool requestPipelined(const char* nodeIp, int nodePort, size_t count, int numberOfConnections, unsigned char responseType,
+                      bool untilEndResponse, const std::function<void(size_t, std::vector<uint8_t>&)>& writeRequest,
+                      const std::function<bool(size_t, const std::vector<PacketPayload>&)>& onResponse)
+{
+    const size_t numberOfPipelines = std::min(count, size_t(std::max(numberOfConnections, 1)));
+    std::atomic<bool> ok(true);
+    parallelFor(numberOfPipelines, int(numberOfPipelines), [&](size_t connection)
+    {
+        try
+        {
+            QubicRequestPipeline pipeline(make_qc(nodeIp, nodePort));
+            std::vector<size_t> requests;
+            std::vector<std::future<std::vector<PacketPayload>>> responses;
+            std::vector<uint8_t> packet;
+            for (size_t i = connection; i < count; i += numberOfPipelines)
+            {
+                writeRequest(i, packet);
+                requests.push_back(i);
+                responses.push_back(pipeline.submit(packet.data(), int(packet.size()), responseType, untilEndResponse));
+            }
+            for (size_t n = 0; n < requests.size(); n++)
+            {
+                if (!onResponse(requests[n], responses[n].get()))
+                    ok = false;
+            }
+        }
+        catch (const std::logic_error&)
+        {
+            ok = false;
+        }
+    });
+    return ok;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "connection.h"
+#include "structs.h"
+
+// Sends many requests back-to-back over one connection and matches the responses to their requests by dejavu,
+// so that N requests cost roughly one round trip instead of N. Every submitted request gets a unique dejavu and a
+// future that is fulfilled by a background receiver thread. A request either completes with the first packet of
+// the expected response type or, if untilEndResponse is set, collects all packets of that type until END_RESPOND.
+// Futures of requests that time out or are pending when the connection fails throw std::logic_error on get().
+// Thread safe. The connection must not be used directly while the pipeline exists.
+class QubicRequestPipeline
+{
+public:
+    explicit QubicRequestPipeline(QCPtr qc, int requestTimeoutMsec = 5000);
+    ~QubicRequestPipeline();
+
+    // Send packet (starting with a RequestResponseHeader with size and type set). The dejavu is overwritten.
+    std::future<std::vector<PacketPayload>> submit(const uint8_t* packet, int packetSize, unsigned char responseType, bool untilEndResponse = false);
+
+    // Send packet and decode the single response as T.
+    template <typename T> std::future<T> submitAs(const uint8_t* packet, int packetSize)
+    {
+        auto raw = submit(packet, packetSize, T::type()).share();
+        return std::async(std::launch::deferred, [raw]()
+        {
+            const auto& packets = raw.get();
+            if (packets.empty())
+                throw std::logic_error("Received end response without data.");
+            T result;
+            memset(&result, 0, sizeof(T));
+            const PacketPayload& payload = packets[0];
+            memcpy(&result, payload.data(), (payload.size() < sizeof(T)) ? payload.size() : sizeof(T));
+            return result;
+        });
+    }
+
+    std::future<RespondedEntity> requestEntity(const uint8_t* publicKey);
+
+    // The future holds the raw output of the contract function (empty if the node could not run it).
+    std::future<PacketPayload> runContractFunction(unsigned int contractIndex, unsigned short funcNumber, const void* input, size_t inputSize);
+
+    size_t pendingRequests();
+
+private:
+    struct PendingRequest
+    {
+        unsigned char responseType;
+        bool untilEndResponse;
+        std::chrono::steady_clock::time_point deadline;
+        std::vector<PacketPayload> packets;
+        std::promise<std::vector<PacketPayload>> promise;
+    };
+
+    void receiveLoop();
+    void failAll(const char* reason);
+    void failExpired();
+
+    QCPtr mConnection;
+    int mRequestTimeoutMsec;
+    std::mutex mSendMutex;
+    std::mutex mPendingMutex;
+    std::map<uint32_t, PendingRequest> mPending;
+    std::atomic<bool> mStop;
+    bool mBroken;
+    std::thread mReceiver;
+};
+
+// Send count requests over numberOfConnections pipelined connections to the node, request i over connection
+// i % numberOfConnections and all requests of a connection back-to-back. writeRequest(i, packet) sets packet to request
+// i (starting with a RequestResponseHeader with size and type set). onResponse(i, packets) gets the packets of type
+// responseType answering request i (all of them until END_RESPOND if untilEndResponse is set) and returns false if
+// they are invalid. Both are called on the thread of the connection, so they must be thread safe. Return false if a
+// connection failed or a response was invalid, the requests a failed connection did not answer get no onResponse().
+bool requestPipelined(const char* nodeIp, int nodePort, size_t count, int numberOfConnections, unsigned char responseType,
+                      bool untilEndResponse, const std::function<void(size_t, std::vector<uint8_t>&)>& writeRequest,
+                      const std::function<bool(size_t, const std::vector<PacketPayload>&)>& onResponse);
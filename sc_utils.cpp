@@ -1,106 +1,81 @@
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "sc_utils.h"
+#include "csv_export.h"
 #include "key_utils.h"
+#include "mapped_file.h"
 #include "structs.h"
 #include "qx_struct.h"
 #include "connection.h"
 #include "logger.h"
 
+// orders formatted by one task of the export
+#define QX_CSV_RANGE_SIZE 4096
+
 void dumpQxContractToCSV(const char* input, const char* output)
 {
     std::cout << "Dumping QX contract file " << input << std::endl;
 
-    // Check the file size
-    FILE* f;
+    // the state is mapped instead of copied, pages of orders that are not populated are never read
+    MappedFile file;
+    if (!file.open(input, true))
     {
-        f = fopen(input, "rb"); // Open the file in binary mode
-        if (f == nullptr)
-        {
-            std::cout << "Can not open file! Exit. " << output << std::endl;
-            return;
-        }
-
-        fseek(f, 0, SEEK_END);
-        unsigned long fileSize = (unsigned long)ftell(f);
-        fclose(f);
-
-        if (fileSize != sizeof(QX))
-        {
-            std::cout << "File size is different from QX state size! " << fileSize << " . Expected " << sizeof(QX) << std::endl;
-            return;
-        }
-    }
-
-    std::shared_ptr<QX> qxState = std::make_shared<QX>();
-
-    f = fopen(input, "rb");
-    if (fread(qxState.get(), 1, sizeof(QX), f) != sizeof(QX))
-    {
-        LOG("Failed to read QX state\n");
-        fclose(f);
+        std::cout << "Can not open file! Exit. " << output << std::endl;
         return;
     }
-    fclose(f);
-
-    f = fopen(output, "w");
+    if (file.size() != sizeof(QX))
     {
-       std::string header ="EarnedAmount,DistributedAmount,BurnedAmount,AssetIssuanceFee,TransferFee,TradeFee,Entity,Issuer,AssetName,NumberOfShares,Price\n";
-       fwrite(header.c_str(), 1, header.size(), f);
+        std::cout << "File size is different from QX state size! " << file.size() << " . Expected " << sizeof(QX) << std::endl;
+        return;
     }
-    std::string stringLine = std::to_string(qxState->_earnedAmount)
-                             + "," + std::to_string(qxState->_distributedAmount)
-                             + "," + std::to_string(qxState->_burnedAmount)
-                             + "," + std::to_string(qxState->_assetIssuanceFee)
-                             + "," + std::to_string(qxState->_transferFee)
-                             + "," + std::to_string(qxState->_tradeFee);
+    const QX* qxState = (const QX*)file.data();
 
-    int64_t elementIdx = 0;
-    uint8_t povID[32];
-    char buffer[128];
-    char assetNameBuffer[8];
-    for (uint64_t elementIdx = 0; elementIdx < qxState->_entityOrders.population(); elementIdx++)
+    const char* header = "EarnedAmount,DistributedAmount,BurnedAmount,AssetIssuanceFee,TransferFee,TradeFee,Entity,Issuer,AssetName,NumberOfShares,Price\n";
+    bool written = exportCsv(output, header, qxState->_entityOrders.population(), QX_CSV_RANGE_SIZE,
+                             [&](size_t first, size_t count, CsvRows& rows)
     {
-        if (elementIdx > 0)
+        // entity and issuer of every order, converted in one batch
+        std::vector<uint8_t>& publicKeys = rows.publicKeys();
+        std::vector<char>& identities = rows.identities();
+        publicKeys.resize(2 * 32 * count);
+        identities.resize(2 * 61 * count);
+        for (size_t i = 0; i < count; i++)
         {
-            stringLine = ",,,,,";
+            qxState->_entityOrders.pov(first + i, &publicKeys[64 * i]);
+            memcpy(&publicKeys[64 * i + 32], qxState->_entityOrders.element(first + i).issuer, 32);
         }
-        // Write data
-        // Entity
-        qxState->_entityOrders.pov(elementIdx, povID);
+        getIdentitiesFromPublicKeys(publicKeys.data(), 2 * count, identities.data(), false);
 
-        memset(buffer, 0, 128);
-        getIdentityFromPublicKey(povID, buffer, false);
-        stringLine = stringLine + "," + buffer;
-
-        // Extract data
-        auto entityOrder = qxState->_entityOrders.element(elementIdx);
-
-        // Issuer
-        memset(buffer, 0, 128);
-        getIdentityFromPublicKey(entityOrder.issuer, buffer, false);
-        stringLine = stringLine + "," + buffer;
-
-        // Asset name
-        memcpy(assetNameBuffer, (char*)&entityOrder.assetName, 8);
-        std::string assetName = assetNameBuffer;
-        stringLine = stringLine + "," + assetName;
-
-        // Number of share
-        stringLine = stringLine + "," + std::to_string(entityOrder.numberOfShares);
-
-        // Price
-        int64_t price = qxState->_entityOrders.priority(elementIdx);
-        stringLine = stringLine + "," + std::to_string(price);
-
-        stringLine += "\n";
-
-        fwrite(stringLine.c_str(), 1, stringLine.size(), f);
-    }
-
-    fclose(f);
+        for (size_t i = 0; i < count; i++)
+        {
+            const size_t elementIdx = first + i;
+            if (elementIdx == 0)
+            {
+                rows.unsignedNumber(qxState->_earnedAmount).comma()
+                    .unsignedNumber(qxState->_distributedAmount).comma()
+                    .unsignedNumber(qxState->_burnedAmount).comma()
+                    .unsignedNumber(qxState->_assetIssuanceFee).comma()
+                    .unsignedNumber(qxState->_transferFee).comma()
+                    .unsignedNumber(qxState->_tradeFee);
+            }
+            else
+            {
+                rows.text(",,,,,", 5);
+            }
+            auto entityOrder = qxState->_entityOrders.element(elementIdx);
+            rows.comma().text(&identities[122 * i], 60)
+                .comma().text(&identities[122 * i + 61], 60)
+                .comma().name((const char*)&entityOrder.assetName, 8)
+                .comma().number(entityOrder.numberOfShares)
+                .comma().number(qxState->_entityOrders.priority(elementIdx))
+                .endRow();
+        }
+    });
+    if (!written)
+        return;
 
     std::cout << "File is written into " << output << std::endl;
 }
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cstring>
+
+#include "k12_and_key_utils.h"
+#include "k12_batch.h"
+#include "key_utils.h"
+#include "parallel.h"
+#include "signer.h"
+
+// signatures whose hashes are computed together
+#define SIGN_GROUP_SIZE 64
+
+Signer::Signer(const char* seed)
+{
+    memset(mSubseed, 0, sizeof(mSubseed));
+    memset(mPrivateKey, 0, sizeof(mPrivateKey));
+    memset(mPublicKey, 0, sizeof(mPublicKey));
+    mValid = (seed && getSubseedFromSeed((const uint8_t*)seed, mSubseed));
+    if (mValid)
+    {
+        getPrivateKeyFromSubSeed(mSubseed, mPrivateKey);
+        getPublicKeyFromPrivateKey(mPrivateKey, mPublicKey);
+    }
+    KangarooTwelve(mSubseed, 32, mNonceKey, 64);
+}
+
+void Signer::sign(const uint8_t* digest, uint8_t* signature) const
+{
+    signWithNonceK(mNonceKey, mPublicKey, digest, signature);
+}
+
+void Signer::signData(const uint8_t* data, size_t dataLength, uint8_t* signature) const
+{
+    uint8_t digest[32];
+    KangarooTwelve(data, unsigned(dataLength), digest, 32);
+    sign(digest, signature);
+}
+
+// Same steps as signWithNonceK(), with the two hashes of all signatures of the group computed together:
+//     r = K12(nonce key[32..64] || digest), R = r * G, h = K12(encode(R) || public key || digest), s = r - h * k
+void Signer::signGroup(const uint8_t* const* digests, uint8_t* const* signatures, size_t count) const
+{
+    uint8_t nonceInputs[SIGN_GROUP_SIZE][64], challengeInputs[SIGN_GROUP_SIZE][96];
+    unsigned long long r[SIGN_GROUP_SIZE][8], h[SIGN_GROUP_SIZE][8];
+    for (size_t i = 0; i < count; i++)
+    {
+        memcpy(nonceInputs[i], mNonceKey + 32, 32);
+        memcpy(nonceInputs[i] + 32, digests[i], 32);
+    }
+    KangarooTwelveBatch(&nonceInputs[0][0], 64, (uint8_t*)&r[0][0], 64, count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        point_t R;
+        ecc_mul_fixed(r[i], R);
+        encode(R, signatures[i]);
+        memcpy(challengeInputs[i], signatures[i], 32);
+        memcpy(challengeInputs[i] + 32, mPublicKey, 32);
+        memcpy(challengeInputs[i] + 64, digests[i], 32);
+    }
+    KangarooTwelveBatch(&challengeInputs[0][0], 96, (uint8_t*)&h[0][0], 64, count);
+
+    unsigned long long k[4];
+    memcpy(k, mNonceKey, 32);
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned long long* s = (unsigned long long*)(signatures[i] + 32);
+        Montgomery_multiply_mod_order(r[i], Montgomery_Rprime, r[i]);
+        Montgomery_multiply_mod_order(r[i], ONE, r[i]);
+        Montgomery_multiply_mod_order(h[i], Montgomery_Rprime, h[i]);
+        Montgomery_multiply_mod_order(h[i], ONE, h[i]);
+        Montgomery_multiply_mod_order(k, Montgomery_Rprime, s);
+        Montgomery_multiply_mod_order(h[i], Montgomery_Rprime, h[i]);
+        Montgomery_multiply_mod_order(s, h[i], s);
+        Montgomery_multiply_mod_order(s, ONE, s);
+        if (_subborrow_u64(_subborrow_u64(_subborrow_u64(_subborrow_u64(0, r[i][0], s[0], &s[0]), r[i][1], s[1], &s[1]), r[i][2], s[2], &s[2]), r[i][3], s[3], &s[3]))
+        {
+            _addcarry_u64(_addcarry_u64(_addcarry_u64(_addcarry_u64(0, s[0], CURVE_ORDER_0, &s[0]), s[1], CURVE_ORDER_1, &s[1]), s[2], CURVE_ORDER_2, &s[2]), s[3], CURVE_ORDER_3, &s[3]);
+        }
+    }
+}
+
+void Signer::signDigests(const uint8_t* digests, size_t count, uint8_t* signatures, int numberOfThreads) const
+{
+    size_t numberOfGroups = (count + SIGN_GROUP_SIZE - 1) / SIGN_GROUP_SIZE;
+    parallelFor(numberOfGroups, numberOfThreads, [&](size_t group)
+    {
+        const uint8_t* groupDigests[SIGN_GROUP_SIZE];
+        uint8_t* groupSignatures[SIGN_GROUP_SIZE];
+        size_t first = group * SIGN_GROUP_SIZE;
+        size_t n = std::min<size_t>(SIGN_GROUP_SIZE, count - first);
+        for (size_t i = 0; i < n; i++)
+        {
+            groupDigests[i] = digests + 32 * (first + i);
+            groupSignatures[i] = signatures + 64 * (first + i);
+        }
+        signGroup(groupDigests, groupSignatures, n);
+    });
+}
+
+void Signer::signBatch(const std::vector<DataToSign>& entries, int numberOfThreads) const
+{
+    size_t numberOfGroups = (entries.size() + SIGN_GROUP_SIZE - 1) / SIGN_GROUP_SIZE;
+    parallelFor(numberOfGroups, numberOfThreads, [&](size_t group)
+    {
+        uint8_t digests[SIGN_GROUP_SIZE][32];
+        const uint8_t* groupDigests[SIGN_GROUP_SIZE];
+        uint8_t* groupSignatures[SIGN_GROUP_SIZE];
+        size_t first = group * SIGN_GROUP_SIZE;
+        size_t n = std::min<size_t>(SIGN_GROUP_SIZE, entries.size() - first);
+        for (size_t i = 0; i < n; i++)
+        {
+            const DataToSign& entry = entries[first + i];
+            KangarooTwelve(entry.data, unsigned(entry.dataLength), digests[i], 32);
+            groupDigests[i] = digests[i];
+            groupSignatures[i] = entry.signature;
+        }
+        signGroup(groupDigests, groupSignatures, n);
+    });
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One piece of data to sign, all pointers are borrowed.
+struct DataToSign
+{
+    const uint8_t* data;
+    size_t dataLength;
+    uint8_t* signature; // 64 bytes
+};
+
+// Keys of one seed, derived once (subseed, private key, public key and the SchnorrQ nonce key) and reused for any
+// number of signatures. Signatures are the same as those of signData() / sign() with the seed.
+class Signer
+{
+public:
+    // seed: 55 lowercase letters, valid() is false otherwise.
+    explicit Signer(const char* seed);
+
+    bool valid() const { return mValid; }
+    const uint8_t* publicKey() const { return mPublicKey; }
+
+    // Sign a 32-byte digest.
+    void sign(const uint8_t* digest, uint8_t* signature) const;
+
+    // Sign the KangarooTwelve digest of data, like signData().
+    void signData(const uint8_t* data, size_t dataLength, uint8_t* signature) const;
+
+    // Sign count digests stored back to back, writing count signatures back to back. The hashes of up to 64 signatures
+    // are computed together by the multi-buffer KangarooTwelve, groups are spread over numberOfThreads threads
+    // (0 = one per core).
+    void signDigests(const uint8_t* digests, size_t count, uint8_t* signatures, int numberOfThreads = 1) const;
+
+    // Sign many pieces of data (for example transactions up to their signature), as signDigests().
+    void signBatch(const std::vector<DataToSign>& entries, int numberOfThreads = 1) const;
+
+private:
+    void signGroup(const uint8_t* const* digests, uint8_t* const* signatures, size_t count) const;
+
+    bool mValid;
+    uint8_t mSubseed[32];
+    uint8_t mPrivateKey[32];
+    uint8_t mPublicKey[32];
+    uint8_t mNonceKey[64]; // KangarooTwelve of the subseed, the second half keys the per-message nonce
+};
@@ -157,6 +157,17 @@ enum COMMAND
     NOSTROMO_TRANSFER_SHARE_MANAGEMENT_RIGHTS = 146,
     NOSTROMO_GET_INFO_USER_INVESTED = 147,
     NOSTROMO_GET_MAX_CLAIM_AMOUNT = 148,
+    GET_BALANCES = 149,
+    RUN_BENCHMARK = 150,
+    COMPARE_NODES = 151,
+    VERIFY_TICK_FILES = 152,
+    SPECTRUM_DIGEST_OF_FILE = 153,
+    UNIVERSE_DIGEST_OF_FILE = 154,
+    MERKLE_PROOF_FROM_FILE = 155,
+    GET_TICK_RANGE = 156,
+    EXTRACT_TICK_FROM_ARCHIVE = 157,
+    FOLLOW_TICKS = 158,
+    GET_QUORUM_RANGE = 159,
     TOTAL_COMMAND, // DO NOT CHANGE THIS
 };
 
@@ -186,6 +197,16 @@ public:
         return !_dejavu;
     }
 
+    inline unsigned int dejavu()
+    {
+        return _dejavu;
+    }
+
+    inline void setDejavu(unsigned int dejavu)
+    {
+        _dejavu = dejavu;
+    }
+
     inline void zeroDejavu()
     {
         _dejavu = 0;
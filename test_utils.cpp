@@ -8,6 +8,7 @@
 #include "logger.h"
 #include "key_utils.h"
 #include "k12_and_key_utils.h"
+#include "tick_watcher.h"
 #include "wallet_utils.h"
 
 
@@ -306,18 +307,7 @@ static void queryAndMatchQpiFunctionsOutput(QCPtr qc, uint32_t firstQueriedTick,
 
         // get quorum tick votes for comparison
         qc->resolveConnection();
-        static struct
-        {
-            RequestResponseHeader header;
-            RequestedQuorumTick rqt;
-        } packetQT;
-        packetQT.header.setSize(sizeof(packetQT));
-        packetQT.header.randomizeDejavu();
-        packetQT.header.setType(RequestedQuorumTick::type);
-        packetQT.rqt.tick = requestedTick;
-        memset(packetQT.rqt.voteFlags, 0, (676 + 7) / 8);
-        qc->sendData(reinterpret_cast<uint8_t*>(&packetQT), sizeof(packetQT));
-        auto votes = qc->getLatestVectorPacketAs<Tick>();
+        auto votes = getQuorumVotes(qc, requestedTick);
         LOG("\tComparing BEGIN_TICK qpi functions output and quorum tick votes\n");
         LOG("\t\tReceived %d quorum tick votes for comparison\n", votes.size());
         int voteMatchCtr = 0;
@@ -349,27 +339,21 @@ void testQpiFunctionsOutput(const char* nodeIp, const int nodePort, const char*
     // wait until network reached last queried tick
     uint32_t lastQueriedTick = firstScheduledTick + numTicks - 1;
     LOG("Waiting for network to reach last queried tick %u, currently at %u...", lastQueriedTick, currentTick);
-    while (currentTick <= lastQueriedTick)
+    auto onTickChange = [&](uint32_t tick)
     {
-        uint32_t tick = getTickNumberFromNode(qc);
-        if (tick == 0)
+        if (tick == currentTick)
+            return;
+        currentTick = tick;
+        if (currentTick > firstScheduledTick && currentTick - firstScheduledTick - 1 < numTicks)
         {
-            qc->resolveConnection();
-            continue;
+            bool txIncluded = checkTxOnTick(qc, txHashes[currentTick - firstScheduledTick - 1].data(), currentTick - 1, false);
         }
-        if (tick != currentTick)
-        {
-            currentTick = tick;
-            if (currentTick > firstScheduledTick)
-            {
-                bool txIncluded = checkTxOnTick(qc, txHashes[currentTick - firstScheduledTick - 1].data(), currentTick - 1, false);
-            }
-            else
-                LOG("\n");
-            LOG("\tTick %u ", currentTick);
-        }
-        Q_SLEEP(1000);
-    }
+        else
+            LOG("\n");
+        LOG("\tTick %u ", currentTick);
+    };
+    uint32_t reachedTick = TickWatcher::forNode(nodeIp, nodePort)->waitForTick(lastQueriedTick + 1, -1, onTickChange);
+    onTickChange(reachedTick);
     LOG("\nDone.\n");
 
     queryAndMatchQpiFunctionsOutput(qc, firstScheduledTick, lastQueriedTick, true);
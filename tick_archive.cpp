@@ -0,0 +1,699 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+
+#include "connection.h"
+#include "defines.h"
+#include "k12_and_key_utils.h"
+#include "k12_batch.h"
+#include "key_utils.h"
+#include "logger.h"
+#include "lz_codec.h"
+#include "node_utils.h"
+#include "parallel.h"
+#include "request_pipeline.h"
+#include "structs.h"
+#include "tick_archive.h"
+#include "utils.h"
+#include "wallet_utils.h"
+
+#define TICK_ARCHIVE_MAGIC "QTA1"
+#define TICK_ARCHIVE_BLOCK_MAGIC "QTAB"
+#define TICK_ARCHIVE_END_MAGIC "QTAE"
+// a block holds 64 ticks of at most 1024 transactions each, anything larger is not a block
+#define TICK_ARCHIVE_MAX_BLOCK_SIZE (TICK_ARCHIVE_BLOCK_TICKS * (sizeof(TickData) + NUMBER_OF_TRANSACTIONS_PER_TICK * MAX_TRANSACTION_SIZE + 12))
+#define TICK_RANGE_DEFAULT_CONNECTIONS 4
+// print progress every this many blocks
+#define TICK_RANGE_PROGRESS_BLOCKS 16
+
+namespace
+{
+
+struct BlockHeader
+{
+    char magic[4];
+    uint32_t numberOfTicks;
+    uint32_t rawSize;
+    uint32_t storedSize;
+    uint8_t digest[32];
+};
+
+struct TickEntry
+{
+    uint32_t tick;
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct IndexEntry
+{
+    uint32_t tick;
+    uint32_t reserved;
+    uint64_t blockOffset;
+};
+
+struct IndexFooter
+{
+    uint64_t indexOffset;
+    uint32_t numberOfEntries;
+    char magic[4];
+};
+
+}
+
+static uint64_t fileSizeOf(FILE* f)
+{
+#ifdef _MSC_VER
+    _fseeki64(f, 0, SEEK_END);
+    long long size = _ftelli64(f);
+#else
+    fseeko(f, 0, SEEK_END);
+    long long size = (long long)ftello(f);
+#endif
+    return size > 0 ? uint64_t(size) : 0;
+}
+
+// Read, decompress and check the block at offset. next receives the offset of the following block.
+static bool readBlock(FILE* f, uint64_t offset, std::vector<uint8_t>& raw, uint64_t& next)
+{
+    BlockHeader header;
+    if (!seekFile(f, offset) || fread(&header, 1, sizeof(header), f) != sizeof(header)
+        || memcmp(header.magic, TICK_ARCHIVE_BLOCK_MAGIC, 4) != 0 || header.numberOfTicks > TICK_ARCHIVE_BLOCK_TICKS
+        || header.rawSize > TICK_ARCHIVE_MAX_BLOCK_SIZE || header.storedSize > TICK_ARCHIVE_MAX_BLOCK_SIZE
+        || header.rawSize < header.numberOfTicks * sizeof(TickEntry))
+        return false;
+    std::vector<uint8_t> stored(header.storedSize);
+    if (fread(stored.data(), 1, stored.size(), f) != stored.size())
+        return false;
+
+    raw.clear();
+    raw.reserve(header.rawSize);
+    QlzDecompressor decompressor([&](const uint8_t* data, size_t size)
+    {
+        raw.insert(raw.end(), data, data + size);
+    });
+    if (!decompressor.write(stored.data(), stored.size()) || !decompressor.finished() || raw.size() != header.rawSize)
+        return false;
+    uint8_t digest[32];
+    KangarooTwelveParallel(raw.data(), raw.size(), digest, 32);
+    if (memcmp(digest, header.digest, 32) != 0)
+        return false;
+
+    const TickEntry* entries = (const TickEntry*)raw.data();
+    if (!header.numberOfTicks || entries[0].offset != header.numberOfTicks * sizeof(TickEntry))
+        return false;
+    for (uint32_t i = 0; i < header.numberOfTicks; i++)
+    {
+        if (entries[i].offset > raw.size() || entries[i].size > raw.size() - entries[i].offset)
+            return false;
+    }
+    next = offset + sizeof(header) + header.storedSize;
+    return true;
+}
+
+static uint32_t numberOfTicksOf(const std::vector<uint8_t>& raw)
+{
+    // the table ends where the first record starts
+    return raw.empty() ? 0 : ((const TickEntry*)raw.data())->offset / sizeof(TickEntry);
+}
+
+// Read the footer of the index, return false if the archive has no complete index.
+static bool readFooter(FILE* f, uint64_t fileSize, IndexFooter& footer)
+{
+    return fileSize >= 4 + sizeof(IndexFooter) && seekFile(f, fileSize - sizeof(IndexFooter))
+        && fread(&footer, 1, sizeof(footer), f) == sizeof(footer) && memcmp(footer.magic, TICK_ARCHIVE_END_MAGIC, 4) == 0
+        && footer.indexOffset >= 4 && footer.indexOffset + uint64_t(footer.numberOfEntries) * sizeof(IndexEntry) + sizeof(IndexFooter) == fileSize;
+}
+
+static std::string txIndexFileNameOf(const std::string& archiveFile)
+{
+    return archiveFile + ".txi";
+}
+
+// Load the index of an open archive, or rebuild it from the blocks if the archive has none.
+// endOfBlocks receives the end of the last complete block.
+static bool loadIndex(FILE* f, std::map<uint32_t, uint64_t>& index, uint64_t& endOfBlocks, bool& indexOnDisk)
+{
+    index.clear();
+    indexOnDisk = false;
+    const uint64_t fileSize = fileSizeOf(f);
+    char magic[4];
+    if (fileSize < 4 || !seekFile(f, 0) || fread(magic, 1, 4, f) != 4 || memcmp(magic, TICK_ARCHIVE_MAGIC, 4) != 0)
+        return false;
+
+    IndexFooter footer;
+    if (readFooter(f, fileSize, footer))
+    {
+        std::vector<IndexEntry> entries(footer.numberOfEntries);
+        if (seekFile(f, footer.indexOffset) && fread(entries.data(), sizeof(IndexEntry), entries.size(), f) == entries.size())
+        {
+            for (const auto& entry : entries)
+                index[entry.tick] = entry.blockOffset;
+            endOfBlocks = footer.indexOffset;
+            indexOnDisk = true;
+            return true;
+        }
+        index.clear();
+    }
+
+    // no index, keep the complete blocks
+    std::vector<uint8_t> raw;
+    uint64_t offset = 4, next = 0;
+    while (offset < fileSize && readBlock(f, offset, raw, next))
+    {
+        const TickEntry* entries = (const TickEntry*)raw.data();
+        for (uint32_t i = 0; i < numberOfTicksOf(raw); i++)
+            index[entries[i].tick] = offset;
+        offset = next;
+    }
+    if (offset < fileSize)
+        LOG("Tick archive has no index, rebuilt it from %zu ticks, %llu damaged bytes at the end are dropped\n",
+            index.size(), (unsigned long long)(fileSize - offset));
+    endOfBlocks = offset;
+    return true;
+}
+
+bool TickArchiveWriter::open(const char* fileName)
+{
+    close();
+    mFileName = fileName;
+    mFile = fopen(fileName, "r+b");
+    if (!mFile)
+    {
+        mFile = fopen(fileName, "w+b");
+        if (!mFile || fwrite(TICK_ARCHIVE_MAGIC, 1, 4, mFile) != 4)
+        {
+            close();
+            return false;
+        }
+        mIndex.clear();
+        mEnd = 4;
+        mIndexOnDisk = false;
+        mTxIndex.clear();
+        return true;
+    }
+    if (!loadIndex(mFile, mIndex, mEnd, mIndexOnDisk))
+    {
+        fclose(mFile);
+        mFile = nullptr;
+        return false;
+    }
+    uint64_t archiveEnd = 0, archiveTicks = 0;
+    if (!mTxIndex.load(txIndexFileNameOf(mFileName).c_str(), archiveEnd, archiveTicks)
+        || archiveEnd != mEnd || archiveTicks != mIndex.size())
+    {
+        LOG("Transaction index of %s is missing or out of date, rebuilding it\n", fileName);
+        if (!rebuildTxIndex())
+        {
+            fclose(mFile);
+            mFile = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Add the transactions of all blocks in index to txIndex. Return false if a block is damaged.
+static bool indexTransactionsOfBlocks(FILE* f, const std::map<uint32_t, uint64_t>& index, TxHashIndex& txIndex)
+{
+    txIndex.clear();
+    std::vector<uint8_t> raw;
+    uint64_t block = UINT64_MAX, next = 0;
+    for (const auto& it : index)
+    {
+        if (it.second == block)
+            continue;
+        block = it.second;
+        if (!readBlock(f, block, raw, next))
+            return false;
+        const TickEntry* entries = (const TickEntry*)raw.data();
+        for (uint32_t i = 0; i < numberOfTicksOf(raw); i++)
+            txIndex.addTick(entries[i].tick, block, raw.data() + entries[i].offset, entries[i].size);
+    }
+    return true;
+}
+
+bool TickArchiveWriter::rebuildTxIndex()
+{
+    return indexTransactionsOfBlocks(mFile, mIndex, mTxIndex);
+}
+
+void TickArchiveWriter::buildBlock(const std::vector<ArchivedTick>& ticks, std::vector<uint8_t>& block)
+{
+    std::vector<uint8_t> raw(ticks.size() * sizeof(TickEntry));
+    for (size_t i = 0; i < ticks.size(); i++)
+    {
+        TickEntry entry = { ticks[i].tick, uint32_t(raw.size()), uint32_t(ticks[i].data.size()) };
+        memcpy(&raw[i * sizeof(TickEntry)], &entry, sizeof(TickEntry));
+        raw.insert(raw.end(), ticks[i].data.begin(), ticks[i].data.end());
+    }
+    block.resize(sizeof(BlockHeader));
+    QlzCompressor compressor("", raw.size(), [&](const uint8_t* data, size_t size)
+    {
+        block.insert(block.end(), data, data + size);
+    });
+    compressor.write(raw.data(), raw.size());
+    compressor.finish();
+
+    BlockHeader header;
+    memcpy(header.magic, TICK_ARCHIVE_BLOCK_MAGIC, 4);
+    header.numberOfTicks = uint32_t(ticks.size());
+    header.rawSize = uint32_t(raw.size());
+    header.storedSize = uint32_t(block.size() - sizeof(BlockHeader));
+    KangarooTwelveParallel(raw.data(), raw.size(), header.digest, 32);
+    memcpy(block.data(), &header, sizeof(header));
+}
+
+bool TickArchiveWriter::append(const std::vector<ArchivedTick>& ticks, const std::vector<uint8_t>& block)
+{
+    if (!mFile || ticks.empty() || ticks.size() > TICK_ARCHIVE_BLOCK_TICKS || block.size() < sizeof(BlockHeader))
+        return false;
+    if (mIndexOnDisk)
+    {
+        // the block overwrites the index, invalidate it first, so an interrupted append makes readers scan the blocks
+        char zero[4] = {0};
+        if (!seekFile(mFile, fileSizeOf(mFile) - 4) || fwrite(zero, 1, 4, mFile) != 4 || fflush(mFile) != 0)
+            return false;
+        mIndexOnDisk = false;
+    }
+    if (!seekFile(mFile, mEnd) || fwrite(block.data(), 1, block.size(), mFile) != block.size())
+        return false;
+    for (const auto& tick : ticks)
+    {
+        mIndex[tick.tick] = mEnd;
+        mTxIndex.addTick(tick.tick, mEnd, tick.data.data(), tick.data.size());
+    }
+    mEnd += block.size();
+    return true;
+}
+
+bool TickArchiveWriter::close()
+{
+    if (!mFile)
+        return true;
+    std::vector<IndexEntry> entries;
+    entries.reserve(mIndex.size());
+    for (const auto& it : mIndex)
+        entries.push_back({ it.first, 0, it.second });
+    IndexFooter footer;
+    footer.indexOffset = mEnd;
+    footer.numberOfEntries = uint32_t(entries.size());
+    memcpy(footer.magic, TICK_ARCHIVE_END_MAGIC, 4);
+    bool ok = seekFile(mFile, mEnd) && fwrite(entries.data(), sizeof(IndexEntry), entries.size(), mFile) == entries.size()
+        && fwrite(&footer, 1, sizeof(footer), mFile) == sizeof(footer);
+    ok = (fclose(mFile) == 0) && ok;
+    mFile = nullptr;
+    if (ok)
+    {
+        // drop a damaged tail or a longer old index after the new index
+        std::error_code error;
+        std::filesystem::resize_file(mFileName, mEnd + entries.size() * sizeof(IndexEntry) + sizeof(IndexFooter), error);
+        ok = !error;
+    }
+    // saved after the archive, so an interrupted close leaves a table that does not match and is rebuilt
+    ok = ok && mTxIndex.save(txIndexFileNameOf(mFileName).c_str(), mEnd, mIndex.size());
+    mTxIndex.clear();
+    return ok;
+}
+
+TickArchiveReader::~TickArchiveReader()
+{
+    if (mFile)
+        fclose(mFile);
+}
+
+bool TickArchiveReader::open(const char* fileName)
+{
+    if (mFile)
+        fclose(mFile);
+    mCachedBlock = UINT64_MAX;
+    mFile = fopen(fileName, "rb");
+    if (!mFile)
+        return false;
+    if (!loadIndex(mFile, mIndex, mEnd, mIndexOnDisk))
+    {
+        fclose(mFile);
+        mFile = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool TickArchiveReader::indexTransactions(TxHashIndex& txIndex)
+{
+    return mFile && indexTransactionsOfBlocks(mFile, mIndex, txIndex);
+}
+
+std::vector<uint32_t> TickArchiveReader::ticks() const
+{
+    std::vector<uint32_t> result;
+    result.reserve(mIndex.size());
+    for (const auto& it : mIndex)
+        result.push_back(it.first);
+    return result;
+}
+
+bool TickArchiveReader::read(uint32_t tick, std::vector<uint8_t>& data)
+{
+    auto found = mIndex.find(tick);
+    if (!mFile || found == mIndex.end())
+        return false;
+    if (mCachedBlock != found->second)
+    {
+        uint64_t next = 0;
+        mCachedBlock = UINT64_MAX;
+        if (!readBlock(mFile, found->second, mCachedData, next))
+            return false;
+        mCachedBlock = found->second;
+    }
+    const TickEntry* entries = (const TickEntry*)mCachedData.data();
+    for (uint32_t i = 0; i < numberOfTicksOf(mCachedData); i++)
+    {
+        if (entries[i].tick == tick)
+        {
+            data.assign(mCachedData.begin() + entries[i].offset, mCachedData.begin() + entries[i].offset + entries[i].size);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool fetchTickRecords(const char* nodeIp, int nodePort, const uint32_t* ticks, size_t count, std::vector<ArchivedTick>& result)
+{
+    result.resize(count);
+    std::vector<int> numberOfTransactions(count, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        result[i].tick = ticks[i];
+        result[i].data.clear();
+    }
+
+    // the node answers with END_RESPOND only if the tick is empty
+    bool ok = requestPipelined(nodeIp, nodePort, count, 1, TickData::type(), false,
+        [&](size_t i, std::vector<uint8_t>& request)
+        {
+            struct
+            {
+                RequestResponseHeader header;
+                RequestTickData requestTickData;
+            } packet;
+            packet.header.setSize(sizeof(packet));
+            packet.header.setType(REQUEST_TICK_DATA);
+            packet.requestTickData.requestedTickData.tick = ticks[i];
+            request.assign((const uint8_t*)&packet, (const uint8_t*)&packet + sizeof(packet));
+        },
+        [&](size_t i, const std::vector<PacketPayload>& packets)
+        {
+            if (packets.empty() || packets[0].size() < sizeof(TickData))
+                return true;
+            const TickData& td = *(const TickData*)packets[0].data();
+            if (td.epoch == 0)
+                return true;
+            result[i].data.assign(packets[0].begin(), packets[0].begin() + sizeof(TickData));
+            uint8_t zeroDigest[32] = {0};
+            for (int n = NUMBER_OF_TRANSACTIONS_PER_TICK; n > 0; n--)
+            {
+                if (memcmp(td.transactionDigests[n - 1], zeroDigest, 32) != 0)
+                {
+                    numberOfTransactions[i] = n;
+                    break;
+                }
+            }
+            return true;
+        });
+
+    std::vector<size_t> ticksWithTransactions;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (numberOfTransactions[i])
+            ticksWithTransactions.push_back(i);
+    }
+    ok = ok && requestPipelined(nodeIp, nodePort, ticksWithTransactions.size(), 1, BROADCAST_TRANSACTION, true,
+        [&](size_t n, std::vector<uint8_t>& request)
+        {
+            const size_t i = ticksWithTransactions[n];
+            struct
+            {
+                RequestResponseHeader header;
+                RequestedTickTransactions txs;
+            } packet;
+            packet.header.setSize(sizeof(packet));
+            packet.header.setType(REQUEST_TICK_TRANSACTIONS);
+            packet.txs.tick = ticks[i];
+            for (int j = 0; j < NUMBER_OF_TRANSACTIONS_PER_TICK / 8; j++)
+                packet.txs.transactionFlags[j] = (j < (numberOfTransactions[i] + 7) / 8) ? 0 : 0xff;
+            request.assign((const uint8_t*)&packet, (const uint8_t*)&packet + sizeof(packet));
+        },
+        [&](size_t n, const std::vector<PacketPayload>& packets)
+        {
+            const size_t i = ticksWithTransactions[n];
+            // only transactions listed in the tick data are kept, a tick that lacks any of them is not complete
+            std::vector<uint8_t> listed(result[i].data.begin() + offsetof(TickData, transactionDigests),
+                                        result[i].data.begin() + offsetof(TickData, transactionDigests) + 32 * numberOfTransactions[i]);
+            std::vector<bool> received(numberOfTransactions[i], false);
+            for (const PacketPayload& payload : packets)
+            {
+                const Transaction* tx = (const Transaction*)payload.data();
+                if (payload.size() < sizeof(Transaction) || tx->inputSize > MAX_INPUT_SIZE
+                    || payload.size() < sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE)
+                {
+                    LOG("Received tx with invalid inputSize in tick %u\n", ticks[i]);
+                    return false;
+                }
+                const size_t txSize = sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE;
+                uint8_t digest[32];
+                KangarooTwelve(payload.data(), unsigned(txSize), digest, 32);
+                for (int j = 0; j < numberOfTransactions[i]; j++)
+                {
+                    if (!received[j] && memcmp(&listed[32 * j], digest, 32) == 0)
+                    {
+                        received[j] = true;
+                        result[i].data.insert(result[i].data.end(), payload.begin(), payload.begin() + txSize);
+                        break;
+                    }
+                }
+            }
+            static const uint8_t zeroDigest[32] = {0};
+            for (int j = 0; j < numberOfTransactions[i]; j++)
+            {
+                if (!received[j] && memcmp(&listed[32 * j], zeroDigest, 32) != 0)
+                {
+                    LOG("Tick %u is missing transactions of its tick data\n", ticks[i]);
+                    return false;
+                }
+            }
+            return true;
+        });
+    if (!ok)
+        LOG("Failed to download ticks %u - %u\n", ticks[0], ticks[count - 1]);
+    return ok;
+}
+
+void downloadTickRange(const char* nodeIp, int nodePort, uint32_t startTick, uint32_t endTick, const char* archiveFile, int numberOfConnections)
+{
+    // ticks the node does not have would be archived as empty
+    if (!limitTickRangeToNode(nodeIp, nodePort, "ticks", startTick, endTick))
+        return;
+
+    TickArchiveWriter archive;
+    if (!archive.open(archiveFile))
+    {
+        LOG("Failed to open tick archive %s\n", archiveFile);
+        return;
+    }
+    std::vector<uint32_t> missingTicks;
+    for (uint64_t tick = startTick; tick <= endTick; tick++)
+    {
+        if (!archive.contains(uint32_t(tick)))
+            missingTicks.push_back(uint32_t(tick));
+    }
+    if (missingTicks.size() < size_t(endTick - startTick) + 1)
+        LOG("%zu of %u ticks are already archived\n", size_t(endTick - startTick) + 1 - missingTicks.size(), endTick - startTick + 1);
+    if (numberOfConnections <= 0)
+        numberOfConnections = TICK_RANGE_DEFAULT_CONNECTIONS;
+
+    auto start = std::chrono::steady_clock::now();
+    const size_t numberOfBlocks = (missingTicks.size() + TICK_ARCHIVE_BLOCK_TICKS - 1) / TICK_ARCHIVE_BLOCK_TICKS;
+    std::mutex archiveMutex;
+    size_t numberOfArchivedTicks = 0, numberOfEmptyTicks = 0, numberOfFailedTicks = 0, numberOfDoneBlocks = 0;
+    uint64_t rawBytes = 0, storedBytes = 0;
+    bool writeFailed = false;
+    parallelFor(numberOfBlocks, numberOfConnections, [&](size_t block)
+    {
+        const size_t first = block * TICK_ARCHIVE_BLOCK_TICKS;
+        const size_t count = std::min<size_t>(TICK_ARCHIVE_BLOCK_TICKS, missingTicks.size() - first);
+        std::vector<ArchivedTick> ticks;
+        bool fetched = fetchTickRecords(nodeIp, nodePort, &missingTicks[first], count, ticks);
+        // compressing and hashing is done by every connection on its own, only the write is serialized
+        std::vector<uint8_t> storedBlock;
+        if (fetched)
+            TickArchiveWriter::buildBlock(ticks, storedBlock);
+
+        std::lock_guard<std::mutex> lock(archiveMutex);
+        if (!fetched || writeFailed || !archive.append(ticks, storedBlock))
+        {
+            writeFailed = writeFailed || fetched;
+            numberOfFailedTicks += count;
+        }
+        else
+        {
+            numberOfArchivedTicks += count;
+            for (const auto& tick : ticks)
+            {
+                numberOfEmptyTicks += tick.data.empty() ? 1 : 0;
+                rawBytes += tick.data.size();
+            }
+            storedBytes += storedBlock.size();
+        }
+        if (++numberOfDoneBlocks % TICK_RANGE_PROGRESS_BLOCKS == 0)
+            LOG("%zu / %zu ticks done\n", std::min(numberOfDoneBlocks * TICK_ARCHIVE_BLOCK_TICKS, missingTicks.size()), missingTicks.size());
+    });
+    if (!archive.close())
+        writeFailed = true;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    LOG("Archived %zu ticks (%zu empty) in %.2f s (%.0f ticks/s) over %d connections, %.2f MB stored as %.2f MB\n",
+        numberOfArchivedTicks, numberOfEmptyTicks, seconds, seconds > 0 ? numberOfArchivedTicks / seconds : 0.0,
+        numberOfConnections, rawBytes / 1048576.0, storedBytes / 1048576.0);
+    if (writeFailed)
+        LOG("Failed to write tick archive %s\n", archiveFile);
+    if (numberOfFailedTicks)
+        LOG("%zu ticks failed, run the command again to download them\n", numberOfFailedTicks);
+}
+
+bool isTickArchive(const char* fileName)
+{
+    char magic[4];
+    FILE* f = fopen(fileName, "rb");
+    if (!f)
+        return false;
+    bool result = fread(magic, 1, 4, f) == 4 && memcmp(magic, TICK_ARCHIVE_MAGIC, 4) == 0;
+    fclose(f);
+    return result;
+}
+
+// Look up digest in the transaction index of archiveFile. Return false if the index does not match the archive.
+static bool lookupTx(const char* archiveFile, const uint8_t* digest, bool& found, TxLocation& location)
+{
+    FILE* f = fopen(archiveFile, "rb");
+    if (!f)
+        return false;
+    IndexFooter footer;
+    bool hasFooter = readFooter(f, fileSizeOf(f), footer);
+    fclose(f);
+    uint64_t archiveEnd = 0, archiveTicks = 0;
+    return hasFooter && TxHashIndex::lookup(txIndexFileNameOf(archiveFile).c_str(), digest, found, location, archiveEnd, archiveTicks)
+        && archiveEnd == footer.indexOffset && archiveTicks == footer.numberOfEntries;
+}
+
+bool checkTxOnArchive(const char* txHash, const char* archiveFile)
+{
+    uint8_t digest[32];
+    getDigestFromTxHash(txHash, digest);
+
+    bool found = false;
+    TxLocation location;
+    if (!lookupTx(archiveFile, digest, found, location))
+    {
+        LOG("Transaction index of %s is missing or out of date, rebuilding it\n", archiveFile);
+        TickArchiveReader archive;
+        TxHashIndex txIndex;
+        if (!archive.open(archiveFile) || !archive.indexTransactions(txIndex))
+        {
+            LOG("Failed to build the transaction index of %s\n", archiveFile);
+            return false;
+        }
+        found = txIndex.find(digest, location);
+        // an archive without index is repaired by the next -gettickrange, a table saved now would not match it
+        if (archive.hasIndex() && !txIndex.save(txIndexFileNameOf(archiveFile).c_str(), archive.endOfBlocks(), archive.numberOfTicks()))
+            LOG("Failed to save the transaction index of %s\n", archiveFile);
+    }
+    if (!found)
+    {
+        LOG("Can NOT find tx %s on archive %s\n", txHash, archiveFile);
+        return false;
+    }
+
+    FILE* f = fopen(archiveFile, "rb");
+    if (!f)
+    {
+        LOG("Failed to open tick archive %s\n", archiveFile);
+        return false;
+    }
+    std::vector<uint8_t> raw;
+    uint64_t next = 0;
+    bool ok = readBlock(f, location.blockOffset, raw, next);
+    fclose(f);
+    const uint8_t* txData = nullptr;
+    const TickEntry* entries = (const TickEntry*)raw.data();
+    for (uint32_t i = 0; ok && i < numberOfTicksOf(raw); i++)
+    {
+        if (entries[i].tick != location.tick || uint64_t(location.recordOffset) + sizeof(Transaction) > entries[i].size)
+            continue;
+        const uint8_t* record = raw.data() + entries[i].offset;
+        const Transaction* tx = (const Transaction*)(record + location.recordOffset);
+        const size_t size = sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE;
+        uint8_t txDigest[32];
+        if (location.recordOffset + size <= entries[i].size)
+        {
+            KangarooTwelve(record + location.recordOffset, unsigned(size), txDigest, 32);
+            if (memcmp(txDigest, digest, 32) == 0)
+                txData = record + location.recordOffset;
+        }
+        break;
+    }
+    if (!txData)
+    {
+        LOG("Failed to read tx %s from tick %u, the archive is damaged\n", txHash, location.tick);
+        return false;
+    }
+
+    if (location.position == 0xFFFF)
+        LOG("Found tx %s on tick %u in archive %s, it is not listed in the tick data\n", txHash, location.tick, archiveFile);
+    else
+        LOG("Found tx %s on tick %u (position %u) in archive %s\n", txHash, location.tick, location.position, archiveFile);
+    Transaction tx = *(const Transaction*)txData;
+    printReceipt(tx, txHash, txData + sizeof(Transaction));
+    return true;
+}
+
+void extractTickFromArchive(const char* archiveFile, uint32_t tick, const char* outputFile)
+{
+    TickArchiveReader archive;
+    if (!archive.open(archiveFile))
+    {
+        LOG("Failed to open tick archive %s\n", archiveFile);
+        return;
+    }
+    std::vector<uint8_t> data;
+    if (!archive.contains(tick))
+    {
+        LOG("Tick %u is not in %s\n", tick, archiveFile);
+        return;
+    }
+    if (!archive.read(tick, data))
+    {
+        LOG("Failed to read tick %u, the archive is damaged\n", tick);
+        return;
+    }
+    if (data.empty())
+    {
+        LOG("Tick %u is empty\n", tick);
+        return;
+    }
+    FILE* f = fopen(outputFile, "wb");
+    if (!f)
+    {
+        LOG("Failed to open %s\n", outputFile);
+        return;
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    ok = (fclose(f) == 0) && ok;
+    if (ok)
+        LOG("Tick data and tick transactions have been written to %s\n", outputFile);
+    else
+        LOG("Failed to write %s\n", outputFile);
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tx_index.h"
+
+// Append-only archive of many ticks in one file, written by -gettickrange.
+//
+// Layout: "QTA1", the blocks, then the index. A block holds up to TICK_ARCHIVE_BLOCK_TICKS ticks: a header ("QTAB",
+// number of ticks, raw size, stored size, KangarooTwelve digest of the raw data) followed by the raw data as a qlz
+// stream. The raw data is a table of (tick, offset, size) per tick followed by the records. A record is the content
+// of a -gettickdata file (TickData followed by the raw transactions), or empty for an empty tick.
+// The index lists (tick, block offset) of every tick and is followed by its offset, its number of entries and "QTAE",
+// so readers find it from the end of the file. Appending overwrites the index, if it is missing because the writer
+// was interrupted, it is rebuilt by scanning the blocks. All integers are little endian.
+// The writer also keeps a TxHashIndex of all archived transactions in "<archive>.txi", see tx_index.h.
+
+#define TICK_ARCHIVE_BLOCK_TICKS 64
+
+struct ArchivedTick
+{
+    uint32_t tick;
+    std::vector<uint8_t> data; // TickData and transactions as written by -gettickdata, empty for an empty tick
+};
+
+class TickArchiveWriter
+{
+public:
+    TickArchiveWriter() : mFile(nullptr), mEnd(0), mIndexOnDisk(false) {}
+    ~TickArchiveWriter() { close(); }
+    TickArchiveWriter(const TickArchiveWriter&) = delete;
+    TickArchiveWriter& operator=(const TickArchiveWriter&) = delete;
+
+    // Open fileName for appending, create it if it does not exist. Return false on I/O errors or if the file is not
+    // a tick archive.
+    bool open(const char* fileName);
+
+    bool contains(uint32_t tick) const { return mIndex.count(tick) != 0; }
+    size_t numberOfTicks() const { return mIndex.size(); }
+
+    // Compress and hash ticks into one block, header included. Does not touch an archive, so blocks can be built
+    // concurrently while another one is appended.
+    static void buildBlock(const std::vector<ArchivedTick>& ticks, std::vector<uint8_t>& block);
+
+    // Append the block built by buildBlock() from ticks. Not thread safe. Return false on I/O errors.
+    bool append(const std::vector<ArchivedTick>& ticks, const std::vector<uint8_t>& block);
+
+    // Write the index and the transaction index and close the file. Return false on I/O errors.
+    bool close();
+
+private:
+    bool rebuildTxIndex();
+
+    FILE* mFile;
+    std::string mFileName;
+    uint64_t mEnd; // end of the last block
+    bool mIndexOnDisk;
+    std::map<uint32_t, uint64_t> mIndex;
+    TxHashIndex mTxIndex;
+};
+
+class TickArchiveReader
+{
+public:
+    TickArchiveReader() : mFile(nullptr), mEnd(0), mIndexOnDisk(false), mCachedBlock(UINT64_MAX) {}
+    ~TickArchiveReader();
+    TickArchiveReader(const TickArchiveReader&) = delete;
+    TickArchiveReader& operator=(const TickArchiveReader&) = delete;
+
+    bool open(const char* fileName);
+
+    bool contains(uint32_t tick) const { return mIndex.count(tick) != 0; }
+    size_t numberOfTicks() const { return mIndex.size(); }
+    // Archived ticks in increasing order.
+    std::vector<uint32_t> ticks() const;
+
+    // Read the record of one tick. The block holding it is checked against its digest and kept, so reading the other
+    // ticks of the block costs no further decompression. Return false if the tick is not archived or the block is
+    // damaged.
+    bool read(uint32_t tick, std::vector<uint8_t>& data);
+
+    // Index the transactions of all archived ticks. Return false if a block is damaged.
+    bool indexTransactions(TxHashIndex& txIndex);
+
+    // True if the archive ends with a complete index, endOfBlocks() is then where the index starts.
+    bool hasIndex() const { return mIndexOnDisk; }
+    uint64_t endOfBlocks() const { return mEnd; }
+
+private:
+    FILE* mFile;
+    uint64_t mEnd; // end of the last complete block
+    bool mIndexOnDisk;
+    std::map<uint32_t, uint64_t> mIndex;
+    uint64_t mCachedBlock;
+    std::vector<uint8_t> mCachedData;
+};
+
+// Fetch the records of count ticks over one pipelined connection, with two rounds of requests (tick data, then
+// transactions). Empty ticks get an empty record. Return false if the node fails to answer or lacks a transaction
+// listed in the tick data of a tick, so that the ticks are fetched again instead of being kept incomplete.
+bool fetchTickRecords(const char* nodeIp, int nodePort, const uint32_t* ticks, size_t count, std::vector<ArchivedTick>& result);
+
+// Download ticks [startTick, endTick] and append them to archiveFile. Blocks of ticks are fetched over
+// numberOfConnections pooled connections (0 = default), each block with two pipelined rounds of requests (tick data,
+// then transactions). Ticks already in the archive are skipped, so an interrupted download is resumed by running it
+// again. Ticks outside of the current epoch of the node or after its current tick are not downloaded.
+void downloadTickRange(const char* nodeIp, int nodePort, uint32_t startTick, uint32_t endTick, const char* archiveFile, int numberOfConnections);
+
+// Return true if fileName starts like a tick archive.
+bool isTickArchive(const char* fileName);
+
+// Find a transaction in an archive with its transaction index and print its receipt. If the index is missing or does
+// not match the archive, it is rebuilt in memory and saved again, the archive itself is only read. Return false if
+// the transaction is not archived.
+bool checkTxOnArchive(const char* txHash, const char* archiveFile);
+
+// Write one tick of an archive to outputFile in the format of -gettickdata.
+void extractTickFromArchive(const char* archiveFile, uint32_t tick, const char* outputFile);
@@ -0,0 +1,95 @@
+#include <array>
+#include <cstring>
+#include <unordered_map>
+
+#include "defines.h"
+#include "digest_hash.h"
+#include "k12_and_key_utils.h"
+#include "logger.h"
+#include "parallel.h"
+#include "tick_file.h"
+
+bool TickFile::read(const char* fileName, int numberOfThreads)
+{
+    std::vector<uint8_t> data;
+    FILE* f = fopen(fileName, "rb");
+    if (f)
+    {
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        if (size > 0)
+        {
+            data.resize(size_t(size));
+            if (fread(data.data(), 1, data.size(), f) != data.size())
+                data.clear();
+        }
+        fclose(f);
+    }
+    return assign(std::move(data), numberOfThreads);
+}
+
+bool TickFile::assign(std::vector<uint8_t>&& data, int numberOfThreads)
+{
+    mData = std::move(data);
+    mTransactions.clear();
+    mNumberOfTransactionsInFile = 0;
+    if (mData.size() < sizeof(TickData))
+    {
+        mData.clear();
+        return false;
+    }
+
+    // transactions of the file, a truncated or invalid one ends the list
+    std::vector<size_t> offsets;
+    size_t offset = sizeof(TickData);
+    while (offsets.size() < NUMBER_OF_TRANSACTIONS_PER_TICK && offset + sizeof(Transaction) <= mData.size())
+    {
+        const Transaction* tx = (const Transaction*)&mData[offset];
+        const size_t txSize = sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE;
+        if (tx->inputSize > MAX_INPUT_SIZE || offset + txSize > mData.size())
+        {
+            LOG("Failed to read Transaction\n");
+            break;
+        }
+        offsets.push_back(offset);
+        offset += txSize;
+    }
+    mNumberOfTransactionsInFile = offsets.size();
+    std::vector<std::array<uint8_t, 32>> digests(offsets.size());
+    parallelFor(offsets.size(), numberOfThreads, [&](size_t i)
+    {
+        const Transaction* tx = (const Transaction*)&mData[offsets[i]];
+        KangarooTwelve(&mData[offsets[i]], unsigned(sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE), digests[i].data(), 32);
+    });
+    // a digest listed twice is a bug of the core, the last transaction with it wins
+    std::unordered_map<std::array<uint8_t, 32>, size_t, DigestHash> transactionOfDigest(2 * offsets.size());
+    for (size_t i = 0; i < offsets.size(); i++)
+        transactionOfDigest[digests[i]] = i;
+
+    const TickData& td = tickData();
+    const uint8_t zeroDigest[32] = {0};
+    int numberOfListedTransactions = NUMBER_OF_TRANSACTIONS_PER_TICK;
+    while (numberOfListedTransactions > 0 && memcmp(td.transactionDigests[numberOfListedTransactions - 1], zeroDigest, 32) == 0)
+        numberOfListedTransactions--;
+    mTransactions.resize(numberOfListedTransactions);
+    std::array<uint8_t, 32> listed;
+    for (int i = 0; i < numberOfListedTransactions; i++)
+    {
+        TransactionView& view = mTransactions[i];
+        memcpy(view.digest, td.transactionDigests[i], 32);
+        memcpy(listed.data(), td.transactionDigests[i], 32);
+        auto found = transactionOfDigest.find(listed);
+        if (memcmp(listed.data(), zeroDigest, 32) == 0 || found == transactionOfDigest.end())
+        {
+            view.transaction = nullptr;
+            view.input = nullptr;
+            view.signature = nullptr;
+            continue;
+        }
+        view.transaction = (const Transaction*)&mData[offsets[found->second]];
+        view.input = &mData[offsets[found->second] + sizeof(Transaction)];
+        view.signature = view.input + view.transaction->inputSize;
+    }
+    return true;
+}
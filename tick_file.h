@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "structs.h"
+
+// A tick file written by -gettickdata (TickData followed by the raw transactions), read into one buffer. The
+// transactions are hashed once and put in the order of the tick data through a hash map, they are views into the
+// buffer and stay valid until the next read() or assign().
+class TickFile
+{
+public:
+    struct TransactionView
+    {
+        const Transaction* transaction; // nullptr if the transaction listed in the tick data is not in the file
+        const uint8_t* input;           // transaction->inputSize bytes, directly after the transaction
+        const uint8_t* signature;       // SIGNATURE_SIZE bytes, directly after the input
+        uint8_t digest[32];             // KangarooTwelve of transaction, input and signature
+    };
+
+    TickFile() : mNumberOfTransactionsInFile(0) {}
+
+    // Read fileName. The transactions are hashed on numberOfThreads threads (0 = one per core). Return false if it
+    // cannot be read or is shorter than a TickData.
+    bool read(const char* fileName, int numberOfThreads = 1);
+    // Take the content of a tick file held in memory, such as a record of a tick archive. Return false if it is
+    // shorter than a TickData.
+    bool assign(std::vector<uint8_t>&& data, int numberOfThreads = 1);
+
+    // Content of the file, empty if the last read() or assign() failed.
+    const std::vector<uint8_t>& data() const { return mData; }
+    const TickData& tickData() const { return *(const TickData*)mData.data(); }
+    // Transactions in the order of the tick data, up to the last listed digest.
+    const std::vector<TransactionView>& transactions() const { return mTransactions; }
+    // Number of complete transactions in the file, listed or not.
+    size_t numberOfTransactionsInFile() const { return mNumberOfTransactionsInFile; }
+
+private:
+    std::vector<uint8_t> mData;
+    std::vector<TransactionView> mTransactions;
+    size_t mNumberOfTransactionsInFile;
+};
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdarg>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _MSC_VER
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "computor_list.h"
+#include "connection.h"
+#include "key_utils.h"
+#include "logger.h"
+#include "node_utils.h"
+#include "structs.h"
+#include "tick_archive.h"
+#include "tick_file.h"
+#include "tick_follower.h"
+#include "tick_verifier.h"
+#include "tick_watcher.h"
+
+// ticks fetched (and held in memory) at a time when catching up
+#define FOLLOW_BATCH_TICKS 16
+// how long to wait for the next tick before checking the node again
+#define FOLLOW_WAIT_MSEC 30000
+#define FOLLOW_RETRY_MIN_MSEC 1000
+#define FOLLOW_RETRY_MAX_MSEC 30000
+
+static void appendFormat(std::string& out, const char* format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length > 0)
+        out.append(buffer, std::min<size_t>(size_t(length), sizeof(buffer) - 1));
+}
+
+static void appendHex(std::string& out, const uint8_t* data, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < size; i++)
+    {
+        out.push_back(digits[data[i] >> 4]);
+        out.push_back(digits[data[i] & 15]);
+    }
+}
+
+// "true" or "false", "null" if not known because the tick data signature was not checked.
+static const char* jsonVerdict(const TickVerdict& verdict, bool value)
+{
+    return !verdict.tickDataSignatureChecked ? "null" : (value ? "true" : "false");
+}
+
+static void appendTickJson(std::string& out, uint32_t tick, const TickFile& tickFile, const TickVerdict& verdict)
+{
+    appendFormat(out, "{\"tick\":%u", tick);
+    if (verdict.empty)
+    {
+        out += ",\"empty\":true}\n";
+        return;
+    }
+    const TickData& td = tickFile.tickData();
+    appendFormat(out, ",\"epoch\":%u,\"computorIndex\":%u,\"time\":\"20%02u-%02u-%02uT%02u:%02u:%02u.%03uZ\"", td.epoch,
+                 td.computorIndex, td.year, td.month, td.day, td.hour, td.minute, td.second, td.millisecond);
+    appendFormat(out, ",\"verified\":%s,\"tickDataSignatureValid\":%s,\"epochMatchesComputorList\":%s",
+                 verdict.unverified() ? "null" : (verdict.ok() ? "true" : "false"), jsonVerdict(verdict, verdict.tickDataSignatureValid),
+                 jsonVerdict(verdict, verdict.epochMatches));
+    appendFormat(out, ",\"numberOfMissingTransactions\":%d,\"numberOfUnlistedTransactions\":%d", verdict.numberOfMissingTransactions,
+                 verdict.numberOfUnlistedTransactions);
+
+    const auto& views = tickFile.transactions();
+    std::vector<uint8_t> keys;
+    std::vector<int> positions;
+    for (size_t i = 0; i < views.size(); i++)
+    {
+        if (!views[i].transaction)
+            continue;
+        keys.insert(keys.end(), views[i].transaction->sourcePublicKey, views[i].transaction->sourcePublicKey + 32);
+        keys.insert(keys.end(), views[i].transaction->destinationPublicKey, views[i].transaction->destinationPublicKey + 32);
+        keys.insert(keys.end(), views[i].digest, views[i].digest + 32);
+        positions.push_back(int(i));
+    }
+    std::vector<char> identities(61 * keys.size() / 32);
+    getIdentitiesFromPublicKeys(keys.data(), keys.size() / 32, identities.data(), false);
+    const std::set<int> invalid(verdict.invalidTransactions.begin(), verdict.invalidTransactions.end());
+    out += ",\"transactions\":[";
+    for (size_t n = 0; n < positions.size(); n++)
+    {
+        const TickFile::TransactionView& view = views[positions[n]];
+        const Transaction& tx = *view.transaction;
+        char* hash = &identities[61 * (3 * n + 2)];
+        for (int c = 0; c < 60; c++)
+            hash[c] = char(tolower(hash[c]));
+        appendFormat(out, "%s{\"position\":%d,\"hash\":\"%s\",\"source\":\"%s\",\"destination\":\"%s\"", n ? "," : "", positions[n],
+                     hash, &identities[61 * (3 * n)], &identities[61 * (3 * n + 1)]);
+        appendFormat(out, ",\"amount\":%lld,\"tick\":%u,\"inputType\":%u,\"inputSize\":%u,\"input\":\"", (long long)tx.amount, tx.tick,
+                     tx.inputType, tx.inputSize);
+        appendHex(out, view.input, tx.inputSize);
+        appendFormat(out, "\",\"signatureValid\":%s}", invalid.count(positions[n]) ? "false" : "true");
+    }
+    out += "]}\n";
+}
+
+// Open the output for appending. For "-" the output gets the real stdout and stdout is pointed at stderr, so that
+// messages printed with LOG() do not end up between the ticks.
+static FILE* openOutput(const char* outputFile)
+{
+    if (strcmp(outputFile, "-") != 0)
+        return fopen(outputFile, "ab");
+    fflush(stdout);
+#ifdef _MSC_VER
+    int fd = _dup(_fileno(stdout));
+    if (fd < 0 || _dup2(_fileno(stderr), _fileno(stdout)) != 0)
+        return nullptr;
+    _setmode(fd, _O_BINARY);
+    return _fdopen(fd, "wb");
+#else
+    int fd = dup(fileno(stdout));
+    if (fd < 0 || dup2(fileno(stderr), fileno(stdout)) < 0)
+        return nullptr;
+    return fdopen(fd, "wb");
+#endif
+}
+
+static bool writeAll(FILE* out, const void* data, size_t size)
+{
+    return fwrite(data, 1, size, out) == size;
+}
+
+static bool writeGap(FILE* out, bool binary, uint32_t firstTick, uint32_t lastTick)
+{
+    if (binary)
+    {
+        FollowedTickHeader header = { firstTick, FOLLOWED_TICK_GAP, sizeof(lastTick) };
+        return writeAll(out, &header, sizeof(header)) && writeAll(out, &lastTick, sizeof(lastTick));
+    }
+    std::string line;
+    appendFormat(line, "{\"gap\":{\"firstTick\":%u,\"lastTick\":%u}}\n", firstTick, lastTick);
+    return writeAll(out, line.data(), line.size());
+}
+
+static bool writeTick(FILE* out, bool binary, uint32_t tick, const TickFile& tickFile, const TickVerdict& verdict)
+{
+    if (binary)
+    {
+        const std::vector<uint8_t>& record = tickFile.data();
+        uint32_t flags = 0;
+        if (!record.empty() && verdict.ok())
+            flags = FOLLOWED_TICK_VERIFIED;
+        else if (!record.empty() && verdict.unverified())
+            flags = FOLLOWED_TICK_UNVERIFIED;
+        FollowedTickHeader header = { tick, flags, uint32_t(record.size()) };
+        return writeAll(out, &header, sizeof(header)) && writeAll(out, record.data(), record.size());
+    }
+    std::string line;
+    appendTickJson(line, tick, tickFile, verdict);
+    return writeAll(out, line.data(), line.size());
+}
+
+void followTicks(const char* nodeIp, int nodePort, uint32_t startTick, const char* outputFile, bool binary)
+{
+    const bool toStdout = (strcmp(outputFile, "-") == 0);
+    FILE* out = openOutput(outputFile);
+    if (!out)
+    {
+        LOG("Failed to open %s\n", outputFile);
+        return;
+    }
+    auto watcher = TickWatcher::forNode(nodeIp, nodePort);
+    // tick data signatures are not checked until the computor list of their epoch is available, such ticks are
+    // written as unverified
+    std::shared_ptr<const ComputorList> computors;
+    uint16_t unverifiableEpoch = 0; // epoch without a computor list, reported once
+    uint32_t nextTick = startTick;
+    int retryDelayMsec = FOLLOW_RETRY_MIN_MSEC;
+    auto retry = [&](const char* reason)
+    {
+        LOG("%s, retrying in %d s\n", reason, retryDelayMsec / 1000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(retryDelayMsec));
+        retryDelayMsec = std::min(2 * retryDelayMsec, FOLLOW_RETRY_MAX_MSEC);
+    };
+
+    while (true)
+    {
+        CurrentTickInfo tickInfo;
+        memset(&tickInfo, 0, sizeof(tickInfo));
+        try
+        {
+            tickInfo = getTickInfoFromNode(make_qc(nodeIp, nodePort));
+        }
+        catch (const std::logic_error&)
+        {
+        }
+        if (tickInfo.tick == 0)
+        {
+            retry("Failed to get the current tick from the node");
+            continue;
+        }
+        if (nextTick == 0)
+        {
+            nextTick = tickInfo.tick;
+            LOG("Following ticks of %s:%d from tick %u (epoch %u)\n", nodeIp, nodePort, nextTick, tickInfo.epoch);
+        }
+        if (nextTick < tickInfo.initialTick)
+        {
+            LOG("The node has no ticks before %u (epoch %u), ticks %u - %u are skipped\n", tickInfo.initialTick, tickInfo.epoch,
+                nextTick, tickInfo.initialTick - 1);
+            if (!writeGap(out, binary, nextTick, tickInfo.initialTick - 1) || fflush(out) != 0)
+                break;
+            nextTick = tickInfo.initialTick;
+        }
+        if (tickInfo.tick <= nextTick)
+        {
+            // a tick is complete once the node has moved past it
+            watcher->waitForTick(nextTick + 1, FOLLOW_WAIT_MSEC);
+            continue;
+        }
+
+        const uint32_t lastTick = std::min<uint32_t>(tickInfo.tick - 1, nextTick + FOLLOW_BATCH_TICKS - 1);
+        std::vector<uint32_t> ticks;
+        for (uint32_t tick = nextTick; tick <= lastTick; tick++)
+            ticks.push_back(tick);
+        std::vector<ArchivedTick> records;
+        if (!fetchTickRecords(nodeIp, nodePort, ticks.data(), ticks.size(), records))
+        {
+            retry("Failed to download ticks");
+            continue;
+        }
+
+        bool failed = false, computorListRequested = false;
+        for (ArchivedTick& record : records)
+        {
+            TickFile tickFile;
+            const TickData* td = tickFile.assign(std::move(record.data)) ? &tickFile.tickData() : nullptr;
+            // the list comes from the cache once per epoch, if neither the cache nor the node has it, it is looked for
+            // again with the next batch
+            if (td && (!computors || td->epoch != computors->broadcast.computors.epoch) && !computorListRequested)
+            {
+                computorListRequested = true;
+                auto epochComputors = getCachedComputorList(nodeIp, nodePort, td->epoch);
+                computors = epochComputors;
+                if (epochComputors)
+                {
+                    LOG("Verifying ticks of epoch %u with the computor list signed by the arbitrator\n", td->epoch);
+                }
+                else if (td->epoch != unverifiableEpoch)
+                {
+                    unverifiableEpoch = td->epoch;
+                    LOG("Failed to get the computor list of epoch %u signed by the arbitrator, its ticks cannot be verified until it is available\n",
+                        td->epoch);
+                }
+            }
+            TickVerdict verdict = verifyTick(tickFile, computors.get());
+            if (!writeTick(out, binary, record.tick, tickFile, verdict))
+            {
+                failed = true;
+                break;
+            }
+            if (verdict.empty)
+                LOG("Tick %u: empty\n", record.tick);
+            else
+                LOG("Tick %u: %d transactions, %s\n", record.tick, verdict.numberOfTransactions,
+                    verdict.ok() ? "OK" : (verdict.unverified() ? "UNVERIFIED" : "FAILED"));
+        }
+        if (failed || fflush(out) != 0)
+            break;
+        nextTick = lastTick + 1;
+        retryDelayMsec = FOLLOW_RETRY_MIN_MSEC;
+    }
+    LOG("Failed to write %s\n", toStdout ? "to stdout" : outputFile);
+    fclose(out);
+}
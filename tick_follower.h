@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary output of -followticks: for every tick a FollowedTickHeader followed by size bytes. For a tick the bytes are
+// its record (the content of a -gettickdata file, nothing for an empty tick). For a gap (ticks the node does not have
+// any more, for example after an epoch change) they are the last tick of the gap, the header holds the first one.
+// All integers are little endian.
+#define FOLLOWED_TICK_VERIFIED 1 // tick data and all listed transactions are present and signed correctly
+#define FOLLOWED_TICK_GAP 2
+#define FOLLOWED_TICK_UNVERIFIED 4 // like VERIFIED, but the tick data signature was not checked (no computor list)
+
+struct FollowedTickHeader
+{
+    uint32_t tick;
+    uint32_t flags;
+    uint32_t size;
+};
+
+// Follow the chain from startTick (0 = the current tick of the node) until the process is stopped. Every tick is
+// fetched as soon as the node has moved past it, checked against the computor list of its epoch (from the computor
+// list cache, fetched from the node once per epoch, ticks are unverified while it is not available) and written to
+// outputFile ("-" for stdout, status messages then go to stderr), as one JSON object per line or, if binary is set,
+// in the format above. A few ticks are in memory at a time. Failed requests are retried with the same ticks, so a
+// disconnect or a restart of the node delays the output but leaves no gap.
+void followTicks(const char* nodeIp, int nodePort, uint32_t startTick, const char* outputFile, bool binary);
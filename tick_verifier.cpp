@@ -0,0 +1,223 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <set>
+
+#include "batch_verify.h"
+#include "computor_list.h"
+#include "k12_and_key_utils.h"
+#include "logger.h"
+#include "parallel.h"
+#include "tick_file.h"
+#include "tick_verifier.h"
+
+bool TickVerdict::ok() const
+{
+    if (!readable)
+        return false;
+    if (empty)
+        return true;
+    return tickDataSignatureValid && numberOfMissingTransactions == 0 && numberOfUnlistedTransactions == 0 && invalidTransactions.empty();
+}
+
+bool TickVerdict::unverified() const
+{
+    return readable && !empty && !tickDataSignatureChecked && numberOfMissingTransactions == 0 && numberOfUnlistedTransactions == 0
+        && invalidTransactions.empty();
+}
+
+static TickVerdict unreadableTick(const std::string& fileName)
+{
+    TickVerdict verdict;
+    verdict.fileName = fileName;
+    verdict.readable = verdict.empty = verdict.epochMatches = verdict.tickDataSignatureChecked = verdict.tickDataSignatureValid = false;
+    verdict.tick = 0;
+    verdict.epoch = verdict.computorIndex = 0;
+    verdict.numberOfTransactions = verdict.numberOfMissingTransactions = verdict.numberOfUnlistedTransactions = 0;
+    return verdict;
+}
+
+TickVerdict verifyTick(const TickFile& tickFile, const ComputorList* computors, int numberOfThreads)
+{
+    if (tickFile.data().empty())
+    {
+        TickVerdict verdict = unreadableTick("");
+        verdict.readable = verdict.empty = true;
+        return verdict;
+    }
+    const TickData& td = tickFile.tickData();
+    TickVerdict verdict;
+    verdict.readable = true;
+    verdict.tick = td.tick;
+    verdict.epoch = td.epoch;
+    verdict.computorIndex = td.computorIndex;
+    verdict.epochMatches = computors && (td.epoch == computors->broadcast.computors.epoch);
+    verdict.tickDataSignatureChecked = (computors != nullptr);
+    verdict.tickDataSignatureValid = false;
+    verdict.numberOfTransactions = 0;
+    verdict.numberOfMissingTransactions = 0;
+    verdict.numberOfUnlistedTransactions = 0;
+    TickData zero;
+    memset(&zero, 0, sizeof(TickData));
+    verdict.empty = (memcmp(&td, &zero, sizeof(TickData)) == 0);
+    if (verdict.empty)
+    {
+        verdict.numberOfUnlistedTransactions = int(tickFile.numberOfTransactionsInFile());
+        return verdict;
+    }
+
+    // TickFile has the digests identifying the transactions (over all data), the sources sign the digest without the
+    // signature
+    const auto& views = tickFile.transactions();
+    std::vector<uint8_t> signedDigests(32 * views.size());
+    parallelFor(views.size(), numberOfThreads, [&](size_t i)
+    {
+        if (views[i].transaction)
+            KangarooTwelve((const uint8_t*)views[i].transaction, unsigned(sizeof(Transaction) + views[i].transaction->inputSize), &signedDigests[32 * i], 32);
+    });
+
+    std::vector<SignatureToVerify> signatures;
+    std::vector<int> signaturePositions; // position in the tick data digest list, -1 for the tick data signature
+    TickData signedTickData = td;
+    uint8_t tickDataDigest[32];
+    signedTickData.computorIndex ^= TickData::type();
+    KangarooTwelve((uint8_t*)&signedTickData, sizeof(TickData) - SIGNATURE_SIZE, tickDataDigest, 32);
+    if (computors && td.computorIndex < NUMBER_OF_COMPUTORS)
+    {
+        signatures.push_back({ computors->broadcast.computors.publicKeys[td.computorIndex], tickDataDigest, td.signature });
+        signaturePositions.push_back(-1);
+    }
+    std::set<const Transaction*> listed;
+    uint8_t zeroDigest[32] = {0};
+    for (size_t position = 0; position < views.size(); position++)
+    {
+        const TickFile::TransactionView& view = views[position];
+        if (memcmp(view.digest, zeroDigest, 32) == 0)
+            continue;
+        verdict.numberOfTransactions++;
+        if (!view.transaction)
+        {
+            verdict.numberOfMissingTransactions++;
+            continue;
+        }
+        listed.insert(view.transaction);
+        signatures.push_back({ view.transaction->sourcePublicKey, &signedDigests[32 * position], view.signature });
+        signaturePositions.push_back(int(position));
+    }
+    verdict.numberOfUnlistedTransactions = int(tickFile.numberOfTransactionsInFile() - listed.size());
+
+    std::vector<bool> valid = verifySignatures(signatures, numberOfThreads, computors ? &computors->decodedKeys : nullptr);
+    for (size_t i = 0; i < signatures.size(); i++)
+    {
+        if (signaturePositions[i] < 0)
+            verdict.tickDataSignatureValid = valid[i];
+        else if (!valid[i])
+            verdict.invalidTransactions.push_back(signaturePositions[i]);
+    }
+    return verdict;
+}
+
+TickVerdict verifyTickFile(const std::string& fileName, const ComputorList& computors, int numberOfThreads)
+{
+    TickFile tickFile;
+    if (!tickFile.read(fileName.c_str(), numberOfThreads))
+        return unreadableTick(fileName);
+    TickVerdict verdict = verifyTick(tickFile, &computors, numberOfThreads);
+    verdict.fileName = fileName;
+    return verdict;
+}
+
+std::vector<TickVerdict> verifyTickFiles(const std::vector<std::string>& fileNames, const ComputorList& computors, int numberOfThreads)
+{
+    // one tick per thread: ticks are independent, so this scales with the number of cores without any coordination
+    std::vector<TickVerdict> verdicts(fileNames.size());
+    parallelFor(fileNames.size(), numberOfThreads, [&](size_t i)
+    {
+        verdicts[i] = verifyTickFile(fileNames[i], computors, 1);
+    });
+    return verdicts;
+}
+
+void printTickVerdict(const TickVerdict& verdict)
+{
+    if (!verdict.readable)
+    {
+        LOG("%s: FAILED, cannot read tick data\n", verdict.fileName.c_str());
+        return;
+    }
+    if (verdict.empty)
+    {
+        LOG("%s: empty tick\n", verdict.fileName.c_str());
+        return;
+    }
+    LOG("%s: tick %u epoch %u computor %u, %d transactions: %s", verdict.fileName.c_str(), verdict.tick, verdict.epoch,
+        verdict.computorIndex, verdict.numberOfTransactions, verdict.ok() ? "OK" : "FAILED");
+    if (!verdict.tickDataSignatureChecked)
+        LOG(", tick data signature not checked");
+    else if (!verdict.tickDataSignatureValid)
+        LOG(", tick data signature invalid%s", verdict.epochMatches ? "" : " (epoch does not match computor list)");
+    if (verdict.numberOfMissingTransactions)
+        LOG(", %d missing", verdict.numberOfMissingTransactions);
+    if (verdict.numberOfUnlistedTransactions)
+        LOG(", %d not listed in tick data", verdict.numberOfUnlistedTransactions);
+    if (!verdict.invalidTransactions.empty())
+    {
+        LOG(", %zu invalid signatures at", verdict.invalidTransactions.size());
+        for (int position : verdict.invalidTransactions)
+            LOG(" %d", position);
+    }
+    LOG("\n");
+}
+
+void verifyTickFilesFromList(const char* computorListFile, const char* tickFileList, int numberOfThreads, const char* nodeIp, int nodePort)
+{
+    std::vector<std::string> fileNames;
+    std::ifstream file(tickFileList);
+    if (!file.is_open())
+    {
+        LOG("Failed to open tick file list %s\n", tickFileList);
+        return;
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() && line[0] != '#')
+            fileNames.push_back(line);
+    }
+    // the cached list is the one of the first readable tick
+    uint16_t epoch = 0;
+    for (size_t i = 0; i < fileNames.size() && !epoch && strcmp(computorListFile, "-") == 0; i++)
+    {
+        TickFile tickFile;
+        if (tickFile.read(fileNames[i].c_str()))
+            epoch = tickFile.tickData().epoch;
+    }
+    auto computorList = loadComputorList(computorListFile, nodeIp, nodePort, epoch);
+    if (!computorList)
+        return;
+    const ComputorList& computors = *computorList;
+
+    numberOfThreads = getNumberOfWorkerThreads(numberOfThreads);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<TickVerdict> verdicts;
+    if (fileNames.size() == 1)
+        verdicts.push_back(verifyTickFile(fileNames[0], computors, numberOfThreads));
+    else
+        verdicts = verifyTickFiles(fileNames, computors, numberOfThreads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int numberOfOk = 0, numberOfEmpty = 0;
+    long long numberOfTransactions = 0;
+    for (const auto& verdict : verdicts)
+    {
+        printTickVerdict(verdict);
+        numberOfOk += verdict.ok() ? 1 : 0;
+        numberOfEmpty += verdict.empty ? 1 : 0;
+        numberOfTransactions += verdict.numberOfTransactions;
+    }
+    LOG("%zu ticks (%d empty): %d OK, %zu FAILED\n", verdicts.size(), numberOfEmpty, numberOfOk, verdicts.size() - numberOfOk);
+    LOG("Verified %lld transactions in %.3f s (%.0f transactions/s) on %d threads\n", numberOfTransactions, seconds,
+        seconds > 0 ? numberOfTransactions / seconds : 0.0, numberOfThreads);
+}
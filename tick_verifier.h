@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "computor_list.h"
+#include "structs.h"
+
+// Result of checking one saved tick (tick data followed by its transactions, as written by -gettickdata).
+struct TickVerdict
+{
+    std::string fileName;
+    bool readable;                      // the file holds a complete TickData
+    bool empty;                         // the tick data is all zero (empty tick)
+    uint32_t tick;
+    uint16_t epoch;
+    uint16_t computorIndex;
+    bool epochMatches;                  // epoch of the tick data equals the epoch of the computor list
+    bool tickDataSignatureChecked;      // a computor list was given
+    bool tickDataSignatureValid;        // signed by the computor of computorIndex
+    int numberOfTransactions;           // digests listed in the tick data
+    int numberOfMissingTransactions;    // listed in the tick data but not in the file
+    int numberOfUnlistedTransactions;   // in the file but not listed in the tick data
+    std::vector<int> invalidTransactions; // positions in the tick data digest list of transactions with a bad signature
+
+    // Whether the tick data is signed correctly, and all listed transactions are present and signed correctly.
+    bool ok() const;
+    // Whether all listed transactions are present and signed correctly, but the tick data signature was not checked.
+    bool unverified() const;
+};
+
+class TickFile;
+
+// Check one saved tick. Transaction digests and signatures are spread over numberOfThreads threads (0 = one per core).
+TickVerdict verifyTickFile(const std::string& fileName, const ComputorList& computors, int numberOfThreads = 0);
+
+// Check one tick held in memory, such as a tick record fetched from a node (a TickFile without data is an empty tick).
+// Without computors the tick data signature is not checked. The verdict has no file name.
+TickVerdict verifyTick(const TickFile& tickFile, const ComputorList* computors, int numberOfThreads = 0);
+
+// Check many saved ticks, numberOfThreads (0 = one per core) ticks at a time. Verdicts are in the order of fileNames.
+std::vector<TickVerdict> verifyTickFiles(const std::vector<std::string>& fileNames, const ComputorList& computors, int numberOfThreads = 0);
+
+void printTickVerdict(const TickVerdict& verdict);
+
+// Check all tick files listed in tickFileList (one file name per line, empty lines and lines starting with # are
+// ignored) against the computor list (a file or "-" for the cached list of the epoch of the first tick, see
+// loadComputorList()), print one line per tick, the failing transactions, and a summary.
+void verifyTickFilesFromList(const char* computorListFile, const char* tickFileList, int numberOfThreads, const char* nodeIp, int nodePort);
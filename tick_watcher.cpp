@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <stdexcept>
+
+#include "tick_watcher.h"
+#include "node_utils.h"
+
+#define INITIAL_TICK_DURATION_MSEC 1000
+#define MIN_POLL_INTERVAL_MSEC 100
+#define MAX_POLL_INTERVAL_MSEC 3000
+#define RECONNECT_INTERVAL_MSEC 1000
+
+static long long nowMsec()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::shared_ptr<TickWatcher> TickWatcher::forNode(const char* nodeIp, int nodePort)
+{
+    // never destroyed: watchers may be in use by other threads until exit, which ends their threads
+    static std::mutex* registryMutex = new std::mutex();
+    static auto* registry = new std::map<std::string, std::shared_ptr<TickWatcher>>();
+    std::string key = std::string(nodeIp) + ":" + std::to_string(nodePort);
+    std::lock_guard<std::mutex> lock(*registryMutex);
+    auto& watcher = (*registry)[key];
+    if (!watcher)
+        watcher = std::make_shared<TickWatcher>(nodeIp, nodePort);
+    return watcher;
+}
+
+TickWatcher::TickWatcher(const char* nodeIp, int nodePort)
+    : mNodeIp(nodeIp), mNodePort(nodePort), mNumberOfWaiters(0), mForcePoll(false), mStop(false), mTick(0),
+      mTickChangeTimeMsec(0), mLastPollTimeMsec(0), mTickDurationMsec(INITIAL_TICK_DURATION_MSEC), mNumberOfPolls(0)
+{
+    mThread = std::thread(&TickWatcher::watchLoop, this);
+}
+
+TickWatcher::~TickWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+        mWaitersChanged.notify_all();
+    }
+    mThread.join();
+}
+
+uint32_t TickWatcher::waitForTick(uint32_t targetTick, int timeoutMsec, const TickCallback& onTickChange)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    long long deadline = (timeoutMsec < 0) ? -1 : nowMsec() + timeoutMsec;
+    mNumberOfWaiters++;
+    mWaitersChanged.notify_all();
+    uint32_t reportedTick = 0;
+    while (mTick < targetTick)
+    {
+        if (mTick != reportedTick && mTick != 0)
+        {
+            reportedTick = mTick;
+            if (onTickChange)
+            {
+                lock.unlock();
+                onTickChange(reportedTick);
+                lock.lock();
+                continue;
+            }
+        }
+        if (deadline < 0)
+        {
+            mTickChanged.wait(lock);
+        }
+        else
+        {
+            long long remaining = deadline - nowMsec();
+            if (remaining <= 0)
+                break;
+            mTickChanged.wait_for(lock, std::chrono::milliseconds(remaining));
+        }
+    }
+    mNumberOfWaiters--;
+    return mTick;
+}
+
+void TickWatcher::subscribe(uint32_t targetTick, TickCallback callback)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSubscriptions.push_back({targetTick, std::move(callback)});
+    mWaitersChanged.notify_all();
+}
+
+uint32_t TickWatcher::getCurrentTick()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (mTick == 0 || nowMsec() - mLastPollTimeMsec > mTickDurationMsec)
+    {
+        size_t polls = mNumberOfPolls;
+        mForcePoll = true;
+        mNumberOfWaiters++;
+        mWaitersChanged.notify_all();
+        mTickChanged.wait_for(lock, std::chrono::milliseconds(MAX_POLL_INTERVAL_MSEC), [&]() { return mNumberOfPolls != polls; });
+        mNumberOfWaiters--;
+    }
+    return mTick;
+}
+
+long long TickWatcher::getTickDurationEstimateMsec()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTickDurationMsec;
+}
+
+size_t TickWatcher::getNumberOfPolls()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNumberOfPolls;
+}
+
+uint32_t TickWatcher::pollTick(QCPtr& qc)
+{
+    try
+    {
+        if (!qc)
+            qc = make_qc(mNodeIp.c_str(), mNodePort);
+        uint32_t tick = getTickInfoFromNode(qc).tick;
+        if (tick == 0)
+            qc.reset(); // let the pool health-check or replace the connection next time
+        return tick;
+    }
+    catch (std::logic_error&)
+    {
+        qc.reset();
+        return 0;
+    }
+}
+
+// Called with mMutex held.
+long long TickWatcher::nextPollDelayMsec(long long now)
+{
+    if (mTick == 0)
+        return RECONNECT_INTERVAL_MSEC;
+    // sleep until the next tick is due, then poll a few times per tick until it shows up
+    long long expectedChange = mTickChangeTimeMsec + mTickDurationMsec;
+    long long delay = (expectedChange > now) ? expectedChange - now : mTickDurationMsec / 4;
+    return std::max<long long>(MIN_POLL_INTERVAL_MSEC, std::min<long long>(MAX_POLL_INTERVAL_MSEC, delay));
+}
+
+void TickWatcher::watchLoop()
+{
+    QCPtr qc;
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mStop)
+    {
+        if (mNumberOfWaiters == 0 && mSubscriptions.empty())
+        {
+            qc.reset();
+            mWaitersChanged.wait(lock);
+            continue;
+        }
+
+        long long now = nowMsec();
+        if (!mForcePoll && mLastPollTimeMsec != 0)
+        {
+            long long pollTime = mLastPollTimeMsec + nextPollDelayMsec(mLastPollTimeMsec);
+            if (pollTime > now)
+            {
+                mWaitersChanged.wait_for(lock, std::chrono::milliseconds(pollTime - now));
+                continue;
+            }
+        }
+        mForcePoll = false;
+
+        lock.unlock();
+        uint32_t tick = pollTick(qc);
+        lock.lock();
+        now = nowMsec();
+        mLastPollTimeMsec = now;
+        mNumberOfPolls++;
+        if (tick > mTick)
+        {
+            if (mTick != 0 && mTickChangeTimeMsec != 0)
+            {
+                // moving average over observed tick changes, smoothing out the polling granularity
+                long long observed = (now - mTickChangeTimeMsec) / (tick - mTick);
+                mTickDurationMsec = (3 * mTickDurationMsec + std::max<long long>(observed, MIN_POLL_INTERVAL_MSEC)) / 4;
+            }
+            mTick = tick;
+            mTickChangeTimeMsec = now;
+        }
+        else if (tick != 0 && tick < mTick)
+        {
+            // node restarted or went back (new epoch / fallback), resynchronize
+            mTick = tick;
+            mTickChangeTimeMsec = now;
+        }
+
+        std::vector<TickCallback> ready;
+        for (size_t i = 0; i < mSubscriptions.size();)
+        {
+            if (mTick != 0 && mSubscriptions[i].targetTick <= mTick)
+            {
+                ready.push_back(std::move(mSubscriptions[i].callback));
+                mSubscriptions[i] = std::move(mSubscriptions.back());
+                mSubscriptions.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+        mTickChanged.notify_all();
+        if (!ready.empty())
+        {
+            uint32_t currentTick = mTick;
+            lock.unlock();
+            for (auto& callback : ready)
+                callback(currentTick);
+            lock.lock();
+        }
+    }
+}
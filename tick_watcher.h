@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "connection.h"
+
+// Shared observer of the current tick of one node. A background thread polls the node over a single connection while
+// there are waiters, and times the polls by the observed tick duration: it sleeps until the next tick is expected and
+// then polls at a fraction of the tick duration, so waiters wake up about one poll after the tick changes instead of
+// after a fixed sleep, and any number of waiters share the same requests. Without waiters the thread sleeps and the
+// connection goes back to the connection pool.
+// Thread safe.
+class TickWatcher
+{
+public:
+    // Called with the latest tick number.
+    typedef std::function<void(uint32_t tick)> TickCallback;
+
+    // Process-wide watcher of the node, created on first use.
+    static std::shared_ptr<TickWatcher> forNode(const char* nodeIp, int nodePort);
+
+    TickWatcher(const char* nodeIp, int nodePort);
+    ~TickWatcher();
+
+    // Block until the node reaches targetTick or timeoutMsec (-1 = no timeout) expires. onTickChange is called from
+    // this thread whenever a new tick is observed while waiting. Return the latest observed tick (>= targetTick on
+    // success, 0 if the node was never reached).
+    uint32_t waitForTick(uint32_t targetTick, int timeoutMsec = -1, const TickCallback& onTickChange = nullptr);
+
+    // Call callback(tick) from the watcher thread once the node reaches targetTick. Must not block for long.
+    void subscribe(uint32_t targetTick, TickCallback callback);
+
+    // Latest tick observed by the watcher, polling the node first if nothing is known yet or the value is older than
+    // one tick duration. Return 0 if the node cannot be reached.
+    uint32_t getCurrentTick();
+
+    // Current estimate of the tick duration in milliseconds.
+    long long getTickDurationEstimateMsec();
+
+    // Number of tick info requests sent to the node so far.
+    size_t getNumberOfPolls();
+
+private:
+    struct Subscription
+    {
+        uint32_t targetTick;
+        TickCallback callback;
+    };
+
+    void watchLoop();
+    uint32_t pollTick(QCPtr& qc);
+    long long nextPollDelayMsec(long long nowMsec);
+
+    std::string mNodeIp;
+    int mNodePort;
+    std::mutex mMutex;
+    std::condition_variable mWaitersChanged;
+    std::condition_variable mTickChanged;
+    std::vector<Subscription> mSubscriptions;
+    int mNumberOfWaiters;
+    bool mForcePoll;
+    bool mStop;
+    uint32_t mTick;
+    long long mTickChangeTimeMsec;
+    long long mLastPollTimeMsec;
+    long long mTickDurationMsec;
+    size_t mNumberOfPolls;
+    std::thread mThread;
+};
@@ -0,0 +1,202 @@
+#include <array>
+#include <cstring>
+#include <map>
+
+#include "defines.h"
+#include "digest_hash.h"
+#include "k12_and_key_utils.h"
+#include "mapped_file.h"
+#include "structs.h"
+#include "tx_index.h"
+
+#define TX_INDEX_MAGIC "QTX1"
+#define TX_INDEX_MIN_SLOTS 4096
+
+namespace
+{
+
+struct TxIndexHeader
+{
+    char magic[4];
+    uint32_t reserved;
+    uint64_t numberOfSlots;
+    uint64_t numberOfEntries;
+    uint64_t archiveEnd;
+    uint64_t archiveTicks;
+};
+
+}
+
+static uint64_t slotOf(const uint8_t* digest, uint64_t numberOfSlots)
+{
+    return hashOfDigest(digest) & (numberOfSlots - 1);
+}
+
+void TxHashIndex::clear()
+{
+    mSlots.clear();
+    mNumberOfEntries = 0;
+}
+
+void TxHashIndex::grow()
+{
+    std::vector<Slot> old;
+    old.swap(mSlots);
+    mSlots.resize(old.empty() ? TX_INDEX_MIN_SLOTS : 2 * old.size());
+    memset(mSlots.data(), 0, mSlots.size() * sizeof(Slot));
+    mNumberOfEntries = 0;
+    for (const Slot& slot : old)
+    {
+        if (slot.tick)
+            insert(slot.digest, { slot.blockOffset, slot.tick, slot.recordOffset, slot.position });
+    }
+}
+
+void TxHashIndex::insert(const uint8_t* digest, const TxLocation& location)
+{
+    if (2 * (mNumberOfEntries + 1) > mSlots.size())
+        grow();
+    const uint64_t mask = mSlots.size() - 1;
+    for (uint64_t i = slotOf(digest, mSlots.size()); ; i = (i + 1) & mask)
+    {
+        Slot& slot = mSlots[i];
+        if (slot.tick && memcmp(slot.digest, digest, 32) != 0)
+            continue;
+        if (!slot.tick)
+            mNumberOfEntries++;
+        memcpy(slot.digest, digest, 32);
+        slot.blockOffset = location.blockOffset;
+        slot.tick = location.tick;
+        slot.recordOffset = location.recordOffset;
+        slot.position = location.position;
+        return;
+    }
+}
+
+void TxHashIndex::addTick(uint32_t tick, uint64_t blockOffset, const uint8_t* record, size_t recordSize)
+{
+    if (recordSize < sizeof(TickData))
+        return;
+    const TickData& td = *(const TickData*)record;
+    std::map<std::array<uint8_t, 32>, uint16_t> positions;
+    uint8_t zeroDigest[32] = {0};
+    for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
+    {
+        if (memcmp(td.transactionDigests[i], zeroDigest, 32) == 0)
+            continue;
+        std::array<uint8_t, 32> digest;
+        memcpy(digest.data(), td.transactionDigests[i], 32);
+        positions[digest] = uint16_t(i);
+    }
+    size_t offset = sizeof(TickData);
+    while (offset + sizeof(Transaction) <= recordSize)
+    {
+        const Transaction& tx = *(const Transaction*)(record + offset);
+        const size_t size = sizeof(Transaction) + tx.inputSize + SIGNATURE_SIZE;
+        if (offset + size > recordSize)
+            break;
+        std::array<uint8_t, 32> digest;
+        KangarooTwelve(record + offset, unsigned(size), digest.data(), 32);
+        auto found = positions.find(digest);
+        insert(digest.data(), { blockOffset, tick, uint32_t(offset), found == positions.end() ? uint16_t(0xFFFF) : found->second });
+        offset += size;
+    }
+}
+
+bool TxHashIndex::load(const char* fileName, uint64_t& archiveEnd, uint64_t& archiveTicks)
+{
+    clear();
+    FILE* f = fopen(fileName, "rb");
+    if (!f)
+        return false;
+    TxIndexHeader header;
+    bool ok = fread(&header, 1, sizeof(header), f) == sizeof(header) && memcmp(header.magic, TX_INDEX_MAGIC, 4) == 0
+        && header.numberOfSlots >= TX_INDEX_MIN_SLOTS && !(header.numberOfSlots & (header.numberOfSlots - 1))
+        && 2 * header.numberOfEntries <= header.numberOfSlots;
+    if (ok)
+    {
+        mSlots.resize(header.numberOfSlots);
+        ok = fread(mSlots.data(), sizeof(Slot), mSlots.size(), f) == mSlots.size();
+    }
+    fclose(f);
+    if (!ok)
+    {
+        clear();
+        return false;
+    }
+    mNumberOfEntries = header.numberOfEntries;
+    archiveEnd = header.archiveEnd;
+    archiveTicks = header.archiveTicks;
+    return true;
+}
+
+bool TxHashIndex::save(const char* fileName, uint64_t archiveEnd, uint64_t archiveTicks) const
+{
+    TxIndexHeader header;
+    memcpy(header.magic, TX_INDEX_MAGIC, 4);
+    header.reserved = 0;
+    header.numberOfEntries = mNumberOfEntries;
+    header.archiveEnd = archiveEnd;
+    header.archiveTicks = archiveTicks;
+    // an empty table still gets its minimum size, so lookups never see zero slots
+    std::vector<Slot> empty;
+    const std::vector<Slot>* slots = &mSlots;
+    if (mSlots.empty())
+    {
+        empty.resize(TX_INDEX_MIN_SLOTS);
+        memset(empty.data(), 0, empty.size() * sizeof(Slot));
+        slots = &empty;
+    }
+    header.numberOfSlots = slots->size();
+
+    FILE* f = fopen(fileName, "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(&header, 1, sizeof(header), f) == sizeof(header)
+        && fwrite(slots->data(), sizeof(Slot), slots->size(), f) == slots->size();
+    ok = (fclose(f) == 0) && ok;
+    return ok;
+}
+
+bool TxHashIndex::lookup(const char* fileName, const uint8_t* digest, bool& found, TxLocation& location, uint64_t& archiveEnd, uint64_t& archiveTicks)
+{
+    found = false;
+    MappedFile file;
+    if (!file.open(fileName) || file.size() < sizeof(TxIndexHeader))
+        return false;
+    const TxIndexHeader& header = *(const TxIndexHeader*)file.data();
+    if (memcmp(header.magic, TX_INDEX_MAGIC, 4) != 0 || header.numberOfSlots < TX_INDEX_MIN_SLOTS
+        || (header.numberOfSlots & (header.numberOfSlots - 1)) || 2 * header.numberOfEntries > header.numberOfSlots
+        || file.size() != sizeof(TxIndexHeader) + header.numberOfSlots * sizeof(Slot))
+        return false;
+    archiveEnd = header.archiveEnd;
+    archiveTicks = header.archiveTicks;
+
+    const Slot* slot = findSlot((const Slot*)(file.data() + sizeof(TxIndexHeader)), header.numberOfSlots, digest);
+    if (slot)
+    {
+        location = { slot->blockOffset, slot->tick, slot->recordOffset, slot->position };
+        found = true;
+    }
+    return true;
+}
+
+bool TxHashIndex::find(const uint8_t* digest, TxLocation& location) const
+{
+    const Slot* slot = mSlots.empty() ? nullptr : findSlot(mSlots.data(), mSlots.size(), digest);
+    if (!slot)
+        return false;
+    location = { slot->blockOffset, slot->tick, slot->recordOffset, slot->position };
+    return true;
+}
+
+const TxHashIndex::Slot* TxHashIndex::findSlot(const Slot* slots, uint64_t numberOfSlots, const uint8_t* digest)
+{
+    const uint64_t mask = numberOfSlots - 1;
+    for (uint64_t i = slotOf(digest, numberOfSlots); slots[i].tick; i = (i + 1) & mask)
+    {
+        if (memcmp(slots[i].digest, digest, 32) == 0)
+            return &slots[i];
+    }
+    return nullptr;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Where a transaction is stored in a tick archive.
+struct TxLocation
+{
+    uint64_t blockOffset;  // archive block holding the tick
+    uint32_t tick;
+    uint32_t recordOffset; // offset of the transaction in the tick record
+    uint16_t position;     // position in the transaction digest list of the tick data, 0xFFFF if not listed
+};
+
+// Hash table from transaction digest to TxLocation, kept next to a tick archive in "<archive>.txi".
+//
+// Layout: "QTX1", 4 reserved bytes, number of slots (power of two), number of entries, end of the archive blocks and
+// number of archived ticks when the table was saved (to detect a table that does not match its archive), then the
+// slots (digest, block offset, tick, record offset, position). Slots are addressed by the first 8 bytes of the
+// digest with linear probing, the table is kept at most half full, so a lookup maps the file and reads one or two
+// slots instead of loading anything. All integers are little endian.
+class TxHashIndex
+{
+public:
+    TxHashIndex() : mNumberOfEntries(0) {}
+
+    // Index all transactions of a tick record (TickData followed by the raw transactions) stored in blockOffset.
+    void addTick(uint32_t tick, uint64_t blockOffset, const uint8_t* record, size_t recordSize);
+    void insert(const uint8_t* digest, const TxLocation& location);
+    void clear();
+    size_t size() const { return mNumberOfEntries; }
+
+    // Load a table saved by save(). archiveEnd and archiveTicks receive the archive state it was saved for.
+    bool load(const char* fileName, uint64_t& archiveEnd, uint64_t& archiveTicks);
+    bool save(const char* fileName, uint64_t archiveEnd, uint64_t archiveTicks) const;
+
+    // Find a transaction in the table in memory. Return false if the digest is not in the table.
+    bool find(const uint8_t* digest, TxLocation& location) const;
+
+    // Find a transaction in a saved table without loading it. Return false if the file is not a table.
+    // found is set if the digest is in the table.
+    static bool lookup(const char* fileName, const uint8_t* digest, bool& found, TxLocation& location, uint64_t& archiveEnd, uint64_t& archiveTicks);
+
+private:
+    struct Slot
+    {
+        uint8_t digest[32];
+        uint64_t blockOffset;
+        uint32_t tick;          // 0 for an empty slot
+        uint32_t recordOffset;
+        uint16_t position;
+        uint16_t reserved[3];
+    };
+
+    void grow();
+    static const Slot* findSlot(const Slot* slots, uint64_t numberOfSlots, const uint8_t* digest);
+
+    std::vector<Slot> mSlots;
+    size_t mNumberOfEntries;
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <random>
+#include <cstdio>
 #include <cstring>
 #include <string>
 #include <vector>
@@ -76,3 +77,13 @@ static inline int strcasecmp(const char* s1, const char* s2)
     return _stricmp(s1, s2);
 }
 #endif
+
+// Seek to an absolute offset, also past 2 GB where long is 32-bit.
+static inline bool seekFile(FILE* f, uint64_t offset)
+{
+#ifdef _MSC_VER
+    return _fseeki64(f, (long long)offset, SEEK_SET) == 0;
+#else
+    return fseeko(f, off_t(offset), SEEK_SET) == 0;
+#endif
+}
@@ -1,15 +1,24 @@
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <thread>
 #include <cstdint>
 #include <cstring>
+#include <fstream>
+#include <future>
+#include <map>
 #include <stdexcept>
+#include <string>
 
 #include "utils.h"
 #include "node_utils.h"
 #include "key_utils.h"
+#include "merkle_verify.h"
 #include "logger.h"
 #include "structs.h"
 #include "connection.h"
+#include "request_pipeline.h"
+#include "tick_watcher.h"
 #include "k12_and_key_utils.h"
 
 void printWalletInfo(const char* seed)
@@ -34,14 +43,10 @@ void printWalletInfo(const char* seed)
     LOG("Identity: %s\n", publicIdentity);
 }
 
-RespondedEntity getBalance(const char* nodeIp, const int nodePort, const uint8_t* publicKey)
+RespondedEntity getBalance(QCPtr qc, const uint8_t* publicKey)
 {
     RespondedEntity result;
     memset(&result, 0, sizeof(RespondedEntity));
-    std::vector<uint8_t> buffer;
-    buffer.resize(0);
-    uint8_t tmp[1024] = {0};
-    auto qc = make_qc(nodeIp, nodePort);
     struct {
         RequestResponseHeader header;
         RequestedEntity req;
@@ -51,31 +56,41 @@ RespondedEntity getBalance(const char* nodeIp, const int nodePort, const uint8_t
     packet.header.setType(REQUEST_ENTITY);
     memcpy(packet.req.publicKey, publicKey, 32);
     qc->sendData((uint8_t *) &packet, packet.header.size());
-    int recvByte = qc->receiveData(tmp, 1024);
-    while (recvByte > 0)
-    {
-        buffer.resize(recvByte + buffer.size());
-        memcpy(buffer.data() + buffer.size() - recvByte, tmp, recvByte);
-        recvByte = qc->receiveData(tmp, 1024);
-    }
-    uint8_t* data = buffer.data();
-    recvByte = int(buffer.size());
-    int ptr = 0;
-    while (ptr < recvByte)
+
+    // stop as soon as the entity has arrived instead of draining the socket until timeout
+    try
     {
-        auto header = (RequestResponseHeader*)(data+ptr);
-        if (header->type() == RESPOND_ENTITY)
+        while (true)
         {
-            auto entity = (RespondedEntity*)(data + ptr + sizeof(RequestResponseHeader));
-            result = *entity;
+            RequestResponseHeader header;
+            qc->receiveAllDataOrThrowException((uint8_t*)&header, sizeof(RequestResponseHeader));
+            int payloadSize = int(header.size() - sizeof(RequestResponseHeader));
+            if (header.type() == RESPOND_ENTITY && payloadSize == sizeof(RespondedEntity))
+            {
+                qc->receiveAllDataOrThrowException((uint8_t*)&result, sizeof(RespondedEntity));
+                break;
+            }
+            if (header.type() == END_RESPOND)
+                break;
+            std::vector<uint8_t> skipped(payloadSize);
+            if (payloadSize)
+                qc->receiveAllDataOrThrowException(skipped.data(), payloadSize);
         }
-        ptr+= header->size();
+    }
+    catch (std::logic_error& e)
+    {
+        LOG("%s\n", e.what());
     }
 
     return result;
 }
 
-void getSpectrumDigest(RespondedEntity& respondedEntity, uint8_t* spectrumDigest)
+RespondedEntity getBalance(const char* nodeIp, const int nodePort, const uint8_t* publicKey)
+{
+    return getBalance(make_qc(nodeIp, nodePort), publicKey);
+}
+
+void getSpectrumDigest(const RespondedEntity& respondedEntity, uint8_t* spectrumDigest)
 {
     // Check if the size of entity is good
     const size_t entity_size = sizeof(respondedEntity.entity);
@@ -95,7 +110,7 @@ void getSpectrumDigest(RespondedEntity& respondedEntity, uint8_t* spectrumDigest
     // Compute the spectrum digest
     getDigestFromSiblings<32>(
         SPECTRUM_DEPTH,
-        (uint8_t*)(&respondedEntity.entity),
+        (const uint8_t*)(&respondedEntity.entity),
         entity_size,
         respondedEntity.spectrumIndex,
         respondedEntity.siblings,
@@ -125,6 +140,76 @@ void printBalance(const char* publicIdentity, const char* nodeIp, int nodePort)
     LOG("Spectum Digest: %s\n", hex);
 }
 
+void printBalances(const char* identityListFile, const char* nodeIp, int nodePort)
+{
+    std::vector<std::string> identities;
+    std::ifstream file(identityListFile);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        // an identity is 60 chars, ignore empty lines and trailing whitespace / CR
+        if (line.size() >= 60)
+            identities.push_back(line.substr(0, 60));
+    }
+
+    // send all requests before waiting for the first response
+    QubicRequestPipeline pipeline(make_qc(nodeIp, nodePort));
+    std::vector<std::future<RespondedEntity>> responses(identities.size());
+    for (size_t i = 0; i < identities.size(); i++)
+    {
+        uint8_t publicKey[32] = {0};
+        getPublicKeyFromIdentity(identities[i].c_str(), publicKey);
+        responses[i] = pipeline.requestEntity(publicKey);
+    }
+
+    std::map<unsigned int, std::vector<RespondedEntity>> entitiesByTick;
+    for (size_t i = 0; i < identities.size(); i++)
+    {
+        try
+        {
+            RespondedEntity entity = responses[i].get();
+            LOG("%s %lld (tick %u)\n", identities[i].c_str(), entity.entity.incomingAmount - entity.entity.outgoingAmount, entity.tick);
+            entitiesByTick[entity.tick].push_back(entity);
+        }
+        catch (std::logic_error& e)
+        {
+            LOG("%s failed: %s\n", identities[i].c_str(), e.what());
+        }
+    }
+
+    // all balances of a tick must prove the same spectrum digest, the one most of them agree on
+    for (const auto& tick : entitiesByTick)
+    {
+        const std::vector<RespondedEntity>& entities = tick.second;
+        uint8_t spectrumDigest[32] = {0};
+        getSpectrumDigest(entities[0], spectrumDigest);
+        std::vector<uint8_t> valid(entities.size());
+        verifySpectrumProofs(entities.data(), entities.size(), spectrumDigest, valid.data());
+        size_t numberOfValid = std::count(valid.begin(), valid.end(), 1);
+        if (2 * numberOfValid <= entities.size())
+        {
+            // the first proof is not backed by a majority, count the digest of every proof
+            std::map<std::array<uint8_t, 32>, size_t> votes;
+            for (const RespondedEntity& entity : entities)
+            {
+                if (entity.spectrumIndex < 0)
+                    continue;
+                std::array<uint8_t, 32> digest;
+                getSpectrumDigest(entity, digest.data());
+                size_t& count = votes[digest];
+                if (++count > numberOfValid)
+                {
+                    numberOfValid = count;
+                    memcpy(spectrumDigest, digest.data(), 32);
+                }
+            }
+        }
+        char hex[65];
+        byteToHex(spectrumDigest, hex, 32);
+        LOG("Tick %u: spectrum digest %s, %zu of %zu balances consistent\n", tick.first, hex, numberOfValid, entities.size());
+    }
+}
+
 void printReceipt(Transaction& tx, const char* txHash = nullptr, const uint8_t* extraData = nullptr, int moneyFlew = -1)
 {
     char sourceIdentity[128] = {0};
@@ -165,10 +250,9 @@ void printReceipt(Transaction& tx, const char* txHash = nullptr, const uint8_t*
     LOG("~~~~~END-RECEIPT~~~~~\n");
 }
 
-bool verifyTx(Transaction& tx, const uint8_t* extraData, const uint8_t* signature)
+void getTxDigest(const Transaction& tx, const uint8_t* extraData, uint8_t* digest)
 {
     std::vector<uint8_t> buffer;
-    uint8_t digest[32] = {0};
     buffer.resize(sizeof(Transaction) + tx.inputSize);
     memcpy(buffer.data(), &tx, sizeof(Transaction));
     if (extraData && tx.inputSize) memcpy(buffer.data() + sizeof(Transaction), extraData, tx.inputSize);
@@ -176,6 +260,12 @@ bool verifyTx(Transaction& tx, const uint8_t* extraData, const uint8_t* signatur
                    uint32_t(buffer.size()),
                    digest,
                    32);
+}
+
+bool verifyTx(Transaction& tx, const uint8_t* extraData, const uint8_t* signature)
+{
+    uint8_t digest[32] = {0};
+    getTxDigest(tx, extraData, digest);
     return verify(tx.sourcePublicKey, digest, signature);
 }
 
@@ -230,13 +320,10 @@ void makeStandardTransactionInTick(const char* nodeIp, int nodePort, const char*
     if (waitUntilFinish)
     {
         LOG("Waiting for tick:\n");
-        uint32_t currentTick = getTickNumberFromNode(qc);
-        while (currentTick <= packet.transaction.tick)
+        TickWatcher::forNode(nodeIp, nodePort)->waitForTick(packet.transaction.tick + 1, -1, [&](uint32_t tick)
         {
-            LOG("%d/%d\n", currentTick, packet.transaction.tick);
-            Q_SLEEP(1000);
-            currentTick = getTickNumberFromNode(qc);
-        }
+            LOG("%d/%d\n", tick, packet.transaction.tick);
+        });
         checkTxOnTick(nodeIp, nodePort, txHash, packet.transaction.tick);
     }
     else
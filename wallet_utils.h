@@ -4,7 +4,11 @@
 #include "connection.h"
 
 void printWalletInfo(const char* seed);
+// Return zeroed RespondedEntity on failure.
+RespondedEntity getBalance(QCPtr qc, const uint8_t* publicKey);
+void getSpectrumDigest(const RespondedEntity& respondedEntity, uint8_t* spectrumDigest);
 void printBalance(const char* publicIdentity, const char* nodeIp, int nodePort);
+void printBalances(const char* identityListFile, const char* nodeIp, int nodePort);
 void makeStandardTransaction(const char* nodeIp, int nodePort, const char* seed,
                              const char* targetIdentity, const uint64_t amount, uint32_t scheduledTickOffset,
                              int waitUntilFinish);
@@ -39,6 +43,7 @@ bool runContractFunction(const char* nodeIp, int nodePort,
     QCPtr* qcPtr = nullptr);
 
 void printReceipt(Transaction& tx, const char* txHash = nullptr, const uint8_t* extraData = nullptr, int moneyFlew = -1);
+void getTxDigest(const Transaction& tx, const uint8_t* extraData, uint8_t* digest);
 bool verifyTx(Transaction& tx, const uint8_t* extraData, const uint8_t* signature);
 void makeIPOBid(const char* nodeIp, int nodePort,
                 const char* seed,